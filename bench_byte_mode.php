@@ -0,0 +1,72 @@
+<?php
+// Benchmark: allocations and throughput when iterating a 10 MB blob
+//
+// Single-byte units are returned as PHP's interned one-character strings,
+// so byte mode (and ASCII in the other modes) should allocate nothing per
+// unit. Allocations are estimated by keeping every yielded unit alive and
+// comparing the memory used against an array of the same length holding
+// ints: whatever is left over was spent on string allocations.
+// Run it on the previous commit as well to get the "before" numbers.
+// Usage: php bench_byte_mode.php > bench_output.txt
+
+$size = 10 << 20;
+$inputs = [
+    "binary" => random_bytes($size),
+    "ascii"  => str_repeat("The quick brown fox jumps over the lazy dog. ", intdiv($size, 45)),
+];
+
+// Size of one heap-allocated string holding a single unit, as measured by
+// the allocator (zend_string header plus payload, rounded up to a bin)
+function one_string_cost(): int {
+    $before = memory_get_usage();
+    $strings = [];
+    for ($i = 0; $i < 100000; $i++) {
+        $strings[] = str_repeat("é", 1) . "x";
+    }
+    $used = memory_get_usage() - $before;
+    unset($strings);
+    $before = memory_get_usage();
+    $ints = array_fill(0, 100000, 0);
+    $slots = memory_get_usage() - $before;
+    return intdiv($used - $slots, 100000);
+}
+
+function bench_throughput(string $str, string $mode): array {
+    $start = hrtime(true);
+    $units = 0;
+    foreach (str_iter($str, $mode) as $unit) {
+        $units++;
+    }
+    return [$units, hrtime(true) - $start];
+}
+
+function bench_allocations(string $str, string $mode, int $cost): int {
+    $before = memory_get_usage();
+    $kept = [];
+    foreach (str_iter($str, $mode) as $unit) {
+        $kept[] = $unit;
+    }
+    $used = memory_get_usage() - $before;
+    $count = count($kept);
+    unset($kept);
+
+    $before = memory_get_usage();
+    $slots = array_fill(0, $count, 0);
+    $baseline = memory_get_usage() - $before;
+    unset($slots);
+
+    return max(0, intdiv($used - $baseline, $cost));
+}
+
+$cost = one_string_cost();
+printf("one unit string costs ~%d bytes\n", $cost);
+printf("%-7s %-10s %10s %12s %12s %10s\n", "input", "mode", "units", "allocations", "MB/s", "ns/unit");
+foreach ($inputs as $name => $str) {
+    foreach (["byte", "codepoint", "grapheme"] as $mode) {
+        [$units, $ns] = bench_throughput($str, $mode);
+        $allocs = bench_allocations($str, $mode, $cost);
+        printf("%-7s %-10s %10d %12d %12.1f %10.1f\n",
+            $name, $mode, $units, $allocs, strlen($str) / (1 << 20) / ($ns / 1e9), $ns / $units);
+    }
+}
+?>
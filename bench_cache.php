@@ -0,0 +1,36 @@
+<?php
+// Benchmark: str_iter() on the same literal with and without the cache
+//
+// Each round creates an iterator over a template literal and asks for its
+// count and the unit in the middle, as code wrapping the same strings on
+// every request does. A foreach over the literal first leaves its count
+// and index in the cache, so cached rounds skip both scans.
+// Usage: php bench_cache.php > bench_output.txt
+
+const SHORT = "Héllo {name}, 👨‍👩‍👧 welcome back! ";
+const LONG = <<<'TXT'
+Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.
+Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat. Duis aute irure
+dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla pariatur. こんにちは世界 👨‍👩‍👧 🇯🇵 café
+Excepteur sint occaecat cupidatat non proident, sunt in culpa qui officia deserunt mollit anim id est laborum. Ünïcödé!
+TXT;
+
+$rounds = 100000;
+
+printf("%-8s %8s %14s %14s\n", "string", "bytes", "uncached ns", "cached ns");
+foreach (["short" => SHORT, "long" => LONG] as $name => $literal) {
+    $result = [];
+    foreach (["0", "1M"] as $size) {
+        ini_set("striter.cache_size", $size);
+        foreach (str_iter($literal) as $unit) {
+        }
+        $start = hrtime(true);
+        for ($i = 0; $i < $rounds; $i++) {
+            $it = str_iter($literal);
+            $it[intdiv(count($it), 2)];
+        }
+        $result[] = (hrtime(true) - $start) / $rounds;
+    }
+    printf("%-8s %8d %14.0f %14.0f\n", $name, strlen($literal), $result[0], $result[1]);
+}
+?>
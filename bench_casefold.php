@@ -0,0 +1,44 @@
+<?php
+// Benchmark: caseless comparison against folding copies in userland
+//
+// The userland versions fold both strings with mb_convert_case() (or
+// mb_strtolower()) and compare the copies. str_iter_casecmp() and
+// str_iter_starts_with_folded() fold as they compare and stop at the first
+// difference, so a mismatch early in a long string costs almost nothing.
+// Usage: php bench_casefold.php > bench_output.txt
+
+$size = 1 << 16;
+$rounds = 200;
+$samples = [
+    "ascii" => "The Quick Brown Fox Jumps Over The Lazy Dog. ",
+    "mixed" => "Straße ΣΊΣΥΦΟΣ Ünïcödé 👨‍👩‍👧 café ",
+];
+
+function measure(callable $fn, int $rounds): float {
+    $start = hrtime(true);
+    for ($i = 0; $i < $rounds; $i++) {
+        $fn();
+    }
+    return (hrtime(true) - $start) / 1e6;
+}
+
+printf("%-6s %-14s %10s %10s\n", "input", "case", "user ms", "native ms");
+foreach ($samples as $name => $sample) {
+    $a = str_repeat($sample, intdiv($size, strlen($sample)));
+    $cases = [
+        "equal" => [$a, mb_strtoupper($a)],
+        "early diff" => [$a, "X" . mb_strtoupper($a)],
+        "prefix" => [$a, mb_strtoupper(mb_substr($a, 0, 64))],
+    ];
+    foreach ($cases as $case => [$x, $y]) {
+        if ($case === "prefix") {
+            $user = fn() => str_starts_with(mb_convert_case($x, MB_CASE_FOLD), mb_convert_case($y, MB_CASE_FOLD));
+            $native = fn() => str_iter_starts_with_folded($x, $y);
+        } else {
+            $user = fn() => strcmp(mb_convert_case($x, MB_CASE_FOLD), mb_convert_case($y, MB_CASE_FOLD));
+            $native = fn() => str_iter_casecmp($x, $y);
+        }
+        printf("%-6s %-14s %10.1f %10.1f\n", $name, $case, measure($user, $rounds), measure($native, $rounds));
+    }
+}
+?>
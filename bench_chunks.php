@@ -0,0 +1,45 @@
+<?php
+// Benchmark: foreach over single units and over chunks of 16 and 256
+//
+// Each step of a foreach costs an iterator call and a value, whatever its
+// size. Chunks pass the same text through in fewer steps; the loop body
+// only takes the length of each value, as code handing windows of text
+// to another function would.
+// Usage: php bench_chunks.php > bench_output.txt
+
+$size = 1 << 20;
+$samples = [
+    "ascii" => "The quick brown fox jumps over the lazy dog. ",
+    "mixed" => "Hello世界🌍 こんにちは 👨‍👩‍👧 café ",
+];
+
+function best_of(int $runs, callable $fn): int {
+    $best = PHP_INT_MAX;
+    for ($i = 0; $i < $runs; $i++) {
+        $start = hrtime(true);
+        $fn();
+        $best = min($best, hrtime(true) - $start);
+    }
+    return $best;
+}
+
+function walk(string $str, string $mode, array $options): void {
+    $bytes = 0;
+    foreach (str_iter($str, $mode, $options) as $value) {
+        $bytes += strlen($value);
+    }
+}
+
+printf("%-6s %-10s %10s %10s %10s %14s\n", "input", "mode", "1 ms", "16 ms", "256 ms", "4096 bytes ms");
+foreach ($samples as $name => $sample) {
+    $str = str_repeat($sample, intdiv($size, strlen($sample)));
+    foreach (["grapheme", "codepoint", "word"] as $mode) {
+        $row = [];
+        foreach ([1, 16, 256] as $chunk) {
+            $row[] = best_of(3, fn() => walk($str, $mode, ["chunk" => $chunk])) / 1e6;
+        }
+        $row[] = best_of(3, fn() => walk($str, $mode, ["chunk_bytes" => 4096])) / 1e6;
+        printf("%-6s %-10s %10.1f %10.1f %10.1f %14.1f\n", $name, $mode, ...$row);
+    }
+}
+?>
@@ -0,0 +1,48 @@
+<?php
+// Benchmark: iterating UTF-16 and Latin-1 strings in place against
+// converting them to UTF-8 first
+//
+// The userland version converts the whole string with mb_convert_encoding()
+// and iterates the copy. The encoding option decodes the string as it
+// goes, holding only a small window of it in UTF-8, so peak memory stays
+// flat however long the string is.
+// Usage: php bench_encoding.php > bench_output.txt
+
+$size = 1 << 20;
+$samples = [
+    "ascii" => "The quick brown fox jumps over the lazy dog. ",
+    "latin" => "Crème brûlée à la française, señor. ",
+    "cjk" => "日本語のテキストを反復処理します。",
+    "emoji" => "Hi 👋🏽 family 👨‍👩‍👧 flags 🇫🇷🇩🇪. ",
+];
+
+function measure(callable $fn): array {
+    memory_reset_peak_usage();
+    $base = memory_get_usage();
+    $start = hrtime(true);
+    $fn();
+    return [(hrtime(true) - $start) / 1e6, (memory_get_peak_usage() - $base) / 1024];
+}
+
+printf("%-6s %-10s %-10s %12s %12s %12s %12s\n", "input", "encoding", "mode", "option ms", "option KiB", "convert ms", "convert KiB");
+foreach ($samples as $name => $sample) {
+    $text = str_repeat($sample, intdiv($size, strlen($sample)));
+    foreach (["UTF-16LE", "ISO-8859-1"] as $encoding) {
+        if ($encoding === "ISO-8859-1" && $name !== "ascii" && $name !== "latin") {
+            continue;
+        }
+        $str = mb_convert_encoding($text, $encoding, "UTF-8");
+        foreach (["grapheme", "codepoint", "word"] as $mode) {
+            [$native_ms, $native_kb] = measure(function () use ($str, $mode, $encoding) {
+                foreach (str_iter($str, $mode, ["encoding" => $encoding]) as $unit) {
+                }
+            });
+            [$user_ms, $user_kb] = measure(function () use ($str, $mode, $encoding) {
+                foreach (str_iter(mb_convert_encoding($str, "UTF-8", $encoding), $mode) as $unit) {
+                }
+            });
+            printf("%-6s %-10s %-10s %12.1f %12.0f %12.1f %12.0f\n", $name, $encoding, $mode, $native_ms, $native_kb, $user_ms, $user_kb);
+        }
+    }
+}
+?>
@@ -0,0 +1,37 @@
+<?php
+// Benchmark: str_iter_file() against reading the file into a string
+//
+// Creating the iterator maps the file, so its cost should not grow with
+// the file size, while file_get_contents() copies every byte first.
+// Usage: php bench_file.php > bench_output.txt
+
+$sizes = [1 << 20, 16 << 20, 128 << 20];
+$block = str_repeat("Hello世界🌍 こんにちは 👨‍👩‍👧 café\r\n", 10000);
+$path = tempnam(sys_get_temp_dir(), "striter");
+
+printf("%10s %14s %14s %14s %14s\n", "bytes", "open file us", "open copy us", "count file ms", "count copy ms");
+foreach ($sizes as $size) {
+    file_put_contents($path, str_repeat($block, max(1, intdiv($size, strlen($block)))));
+
+    $start = hrtime(true);
+    $mapped = str_iter_file($path, "grapheme");
+    $open_file = hrtime(true) - $start;
+
+    $start = hrtime(true);
+    $copied = str_iter(file_get_contents($path), "grapheme");
+    $open_copy = hrtime(true) - $start;
+
+    $start = hrtime(true);
+    count($mapped);
+    $count_file = hrtime(true) - $start;
+
+    $start = hrtime(true);
+    count($copied);
+    $count_copy = hrtime(true) - $start;
+
+    printf("%10d %14.1f %14.1f %14.2f %14.2f\n", filesize($path),
+        $open_file / 1e3, $open_copy / 1e3, $count_file / 1e6, $count_copy / 1e6);
+    unset($mapped, $copied);
+}
+unlink($path);
+?>
@@ -0,0 +1,57 @@
+<?php
+// Benchmark: native UAX #29 engine versus the PCRE2 \X engine
+//
+// Both engines must produce the same segmentation; the benchmark checks
+// that before timing them.
+// Usage: php bench_grapheme_engine.php > bench_output.txt
+
+if (@ini_set("striter.grapheme_engine", "pcre2") === false) {
+    echo "PCRE2 engine not available, nothing to compare\n";
+    exit(0);
+}
+ini_set("striter.grapheme_engine", "native");
+
+$corpora = [
+    "ascii" => str_repeat("The quick brown fox jumps over the lazy dog.\n", 25000),
+    "emoji+cjk" => str_repeat("東京タワー🗼👨‍👩‍👧‍👦こんにちは世界🌏🇯🇵👋🏽漢字かな交じり文。", 10000),
+];
+
+function segments(string $str): array {
+    $out = [];
+    foreach (str_iter($str) as $char) {
+        $out[] = $char;
+    }
+    return $out;
+}
+
+function bench(callable $fn, int $rounds = 5): float {
+    $best = PHP_INT_MAX;
+    for ($i = 0; $i < $rounds; $i++) {
+        $start = hrtime(true);
+        $fn();
+        $best = min($best, hrtime(true) - $start);
+    }
+    return $best / 1e6;
+}
+
+printf("%-10s %-7s %10s %12s %12s\n", "corpus", "engine", "bytes", "count ms", "foreach ms");
+foreach ($corpora as $name => $str) {
+    ini_set("striter.grapheme_engine", "native");
+    $native = segments($str);
+    ini_set("striter.grapheme_engine", "pcre2");
+    $pcre2 = segments($str);
+    if ($native !== $pcre2) {
+        echo "$name: engines disagree!\n";
+    }
+
+    foreach (["native", "pcre2"] as $engine) {
+        ini_set("striter.grapheme_engine", $engine);
+        $count_ms = bench(fn() => count(str_iter($str)));
+        $foreach_ms = bench(function () use ($str) {
+            foreach (str_iter($str) as $char) {
+            }
+        });
+        printf("%-10s %-7s %10d %12.2f %12.2f\n", $name, $engine, strlen($str), $count_ms, $foreach_ms);
+    }
+}
+?>
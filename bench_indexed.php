@@ -0,0 +1,29 @@
+<?php
+// Benchmark: memory and random access with and without the indexed option
+//
+// For each mode, an iterator over about 1 MiB of mixed text is read at
+// random offsets; the first lookups build its indexes. The memory columns
+// are indexSize() per unit afterwards: the sparse checkpoints only, and
+// the checkpoints plus the unit index.
+// Usage: php bench_indexed.php > bench_output.txt
+
+$text = str_repeat("Héllo wörld, this is some text. 👨‍👩‍👧 こんにちは世界 🇯🇵 café! ", 12000);
+$lookups = 200000;
+
+mt_srand(42);
+printf("%-10s %9s %12s %12s %12s %12s\n", "mode", "units", "plain B/u", "indexed B/u", "plain ns", "indexed ns");
+foreach (["grapheme", "codepoint", "byte", "word", "sentence", "line"] as $mode) {
+    $row = [];
+    foreach ([false, true] as $indexed) {
+        $it = str_iter($text, $mode, ["indexed" => $indexed]);
+        $n = count($it);
+        $start = hrtime(true);
+        for ($i = 0; $i < $lookups; $i++) {
+            $it[mt_rand(0, $n - 1)];
+        }
+        $row[] = $it->indexSize() / $n;
+        $row[] = (hrtime(true) - $start) / $lookups;
+    }
+    printf("%-10s %9d %12.2f %12.2f %12.0f %12.0f\n", $mode, $n, $row[0], $row[2], $row[1], $row[3]);
+}
+?>
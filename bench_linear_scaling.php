@@ -0,0 +1,36 @@
+<?php
+// Benchmark: foreach cost versus string size
+//
+// With the cursor-based engine every step costs the size of one unit, so
+// the time per unit should stay flat from 1 KB up to 10 MB.
+// Usage: php bench_linear_scaling.php > bench_output.txt
+
+$sizes = [1 << 10, 10 << 10, 100 << 10, 1 << 20, 10 << 20];
+$samples = [
+    "ascii" => "The quick brown fox jumps over the lazy dog. ",
+    "mixed" => "Hello世界🌍 こんにちは 👨‍👩‍👧 café ",
+];
+
+function bench_foreach(string $str, string $mode): array {
+    $start = hrtime(true);
+    $units = 0;
+    foreach (str_iter($str, $mode) as $char) {
+        $units++;
+    }
+    return [$units, hrtime(true) - $start];
+}
+
+printf("%-6s %-10s %10s %12s %10s %10s\n", "input", "mode", "bytes", "units", "ms", "ns/unit");
+foreach ($samples as $name => $sample) {
+    foreach (["grapheme", "codepoint", "byte"] as $mode) {
+        foreach ($sizes as $size) {
+            // Whole repetitions only, so the tail is never a cut UTF-8 sequence
+            $str = str_repeat($sample, max(1, intdiv($size, strlen($sample))));
+
+            [$units, $ns] = bench_foreach($str, $mode);
+            printf("%-6s %-10s %10d %12d %10.2f %10.1f\n",
+                $name, $mode, strlen($str), $units, $ns / 1e6, $units ? $ns / $units : 0);
+        }
+    }
+}
+?>
@@ -0,0 +1,45 @@
+<?php
+// Benchmark: normalized iteration against normalizing every unit in userland
+//
+// The userland version iterates str_iter() and passes every unit through
+// Normalizer::normalize() (intl). The normalize option yields units that
+// pass the quick check without copying or decoding them, so text that is
+// already normalized costs little more than plain iteration.
+// Usage: php bench_normalize.php > bench_output.txt
+
+$size = 1 << 20;
+$samples = [
+    "ascii" => "The quick brown fox jumps over the lazy dog. ",
+    "latin" => "Crème brûlée à la française, señor. ",
+    "nfd" => "Cre\u{300}me bru\u{302}le\u{301}e a\u{300} la franc\u{327}aise. ",
+    "hangul" => "한국어 텍스트를 정규화합니다. ",
+];
+
+function measure(callable $fn): float {
+    $start = hrtime(true);
+    $fn();
+    return (hrtime(true) - $start) / 1e6;
+}
+
+$intl = class_exists("Normalizer");
+printf("%-7s %-5s %10s %12s %10s\n", "input", "form", "plain ms", "normalize ms", "intl ms");
+foreach ($samples as $name => $sample) {
+    $str = str_repeat($sample, intdiv($size, strlen($sample)));
+    foreach (["NFC" => $intl ? Normalizer::FORM_C : 0, "NFD" => $intl ? Normalizer::FORM_D : 0] as $form => $intl_form) {
+        $plain = measure(function () use ($str) {
+            foreach (str_iter($str) as $unit) {
+            }
+        });
+        $native = measure(function () use ($str, $form) {
+            foreach (str_iter($str, null, ["normalize" => $form]) as $unit) {
+            }
+        });
+        $user = $intl ? measure(function () use ($str, $intl_form) {
+            foreach (str_iter($str) as $unit) {
+                Normalizer::normalize($unit, $intl_form);
+            }
+        }) : NAN;
+        printf("%-7s %-5s %10.1f %12.1f %10.1f\n", $name, $form, $plain, $native, $user);
+    }
+}
+?>
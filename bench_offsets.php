@@ -0,0 +1,31 @@
+<?php
+// Benchmark: walking a document as strings versus offset pairs
+//
+// With ["offsets" => true] nothing is copied out of the source string;
+// each step yields a [byteOffset, byteLength] pair instead. The memory
+// column keeps every yielded value alive to show the footprint.
+// Usage: php bench_offsets.php > bench_output.txt
+
+$size = 4 << 20;
+$doc = str_repeat("Lorem ipsum 世界🌍 dolor sit 👨‍👩‍👧 amet, café. ", intdiv($size, 60));
+
+function walk(string $doc, array $options, bool $keep): array {
+    $start = hrtime(true);
+    $before = memory_get_usage();
+    $kept = [];
+    foreach (str_iter($doc, "grapheme", $options) as $value) {
+        if ($keep) {
+            $kept[] = $value;
+        }
+    }
+    return [hrtime(true) - $start, memory_get_usage() - $before];
+}
+
+printf("%d bytes\n", strlen($doc));
+printf("%-8s %10s %14s\n", "yield", "walk ms", "kept MB");
+foreach (["strings" => [], "offsets" => ["offsets" => true]] as $name => $options) {
+    [$ns] = walk($doc, $options, false);
+    [, $bytes] = walk($doc, $options, true);
+    printf("%-8s %10.2f %14.1f\n", $name, $ns / 1e6, $bytes / (1 << 20));
+}
+?>
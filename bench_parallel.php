@@ -0,0 +1,33 @@
+<?php
+// Benchmark: count() and index building versus striter.threads
+//
+// Each thread segments its own range of the string, so both should scale
+// close to linearly with the thread count until memory bandwidth runs
+// out. The index is built by the first lookup near the end.
+// Usage: php bench_parallel.php [megabytes] > bench_output.txt
+
+$size = (int)($argv[1] ?? 256) << 20;
+$sample = "Hello世界🌍 こんにちは 👨‍👩‍👧 café ";
+$str = str_repeat($sample, intdiv($size, strlen($sample)));
+
+printf("%-10s %8s %12s %12s %10s\n", "mode", "threads", "count ms", "index ms", "speedup");
+foreach (["grapheme", "codepoint"] as $mode) {
+    $base = null;
+    foreach ([0, 2, 4, 8] as $threads) {
+        ini_set("striter.threads", (string)$threads);
+
+        $start = hrtime(true);
+        $units = count(str_iter($str, $mode));
+        $count = hrtime(true) - $start;
+
+        $iter = str_iter($str, $mode);
+        $start = hrtime(true);
+        $iter[$units - 1];
+        $index = hrtime(true) - $start;
+
+        $base ??= $count;
+        printf("%-10s %8d %12.1f %12.1f %9.2fx\n",
+            $mode, $threads, $count / 1e6, $index / 1e6, $base / $count);
+    }
+}
+?>
@@ -0,0 +1,37 @@
+<?php
+// Benchmark: random-access latency versus string size
+//
+// $it[$i] walks at most striter.index_interval units from the nearest
+// checkpoint, so after the first lookup (which builds the index) the cost
+// per lookup should stay flat as the string grows.
+// Usage: php -d striter.index_interval=128 bench_random_access.php > bench_output.txt
+
+$sizes = [10 << 10, 100 << 10, 1 << 20, 10 << 20];
+$sample = "Hello世界🌍 こんにちは 👨‍👩‍👧 café ";
+$lookups = 10000;
+
+printf("index_interval: %s\n", ini_get("striter.index_interval"));
+printf("%-10s %10s %10s %14s %14s\n", "mode", "bytes", "units", "first lookup", "ns/lookup");
+foreach (["grapheme", "codepoint"] as $mode) {
+    foreach ($sizes as $size) {
+        $str = str_repeat($sample, intdiv($size, strlen($sample)));
+        $iter = str_iter($str, $mode);
+        $units = count($iter);
+
+        // The first lookup near the end scans the string and builds the index
+        $start = hrtime(true);
+        $iter[$units - 1];
+        $first = hrtime(true) - $start;
+
+        mt_srand(42);
+        $start = hrtime(true);
+        for ($i = 0; $i < $lookups; $i++) {
+            $iter[mt_rand(0, $units - 1)];
+        }
+        $ns = hrtime(true) - $start;
+
+        printf("%-10s %10d %10d %11.2f ms %14.0f\n",
+            $mode, strlen($str), $units, $first / 1e6, $ns / $lookups);
+    }
+}
+?>
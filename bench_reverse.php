@@ -0,0 +1,40 @@
+<?php
+// Benchmark: reading the last units of a string versus its length
+//
+// Stepping back segments only the unit before the cursor, so reading the
+// last K units should take the same time whatever the string length,
+// while a forward walk to them grows with it.
+// Usage: php bench_reverse.php > bench_output.txt
+
+$sizes = [10 << 10, 100 << 10, 1 << 20, 10 << 20];
+$sample = "Hello世界🌍 こんにちは 👨‍👩‍👧 café. Next sentence ";
+$k = 100;
+
+printf("last %d units\n", $k);
+printf("%-10s %10s %14s %14s\n", "mode", "bytes", "reverse us", "forward us");
+foreach (["grapheme", "codepoint", "word", "sentence", "line"] as $mode) {
+    foreach ($sizes as $size) {
+        $str = str_repeat($sample, intdiv($size, strlen($sample)));
+
+        $start = hrtime(true);
+        $n = 0;
+        foreach (str_iter_reverse($str, $mode) as $unit) {
+            if (++$n === $k) {
+                break;
+            }
+        }
+        $reverse = hrtime(true) - $start;
+
+        // Forward: the last K units can only be reached by walking to them
+        $start = hrtime(true);
+        $iter = str_iter($str, $mode);
+        $units = count($iter);
+        for ($iter->seek($units - $k); $iter->valid(); $iter->next()) {
+            $iter->current();
+        }
+        $forward = hrtime(true) - $start;
+
+        printf("%-10s %10d %14.1f %14.1f\n", $mode, strlen($str), $reverse / 1e3, $forward / 1e3);
+    }
+}
+?>
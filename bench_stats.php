@@ -0,0 +1,56 @@
+<?php
+// Benchmark: unit frequencies and the longest unit, natively and in userland
+//
+// The userland versions iterate str_iter() and create a string for every
+// unit; str_iter_count_values() and str_iter_stats() hash and measure the
+// units in place. Memory is the peak growth while the function runs.
+// Usage: php bench_stats.php > bench_output.txt
+
+$size = 1 << 20;
+$samples = [
+    "ascii" => "The quick brown fox jumps over the lazy dog. ",
+    "mixed" => "Hello世界🌍 こんにちは 👨‍👩‍👧 café ",
+];
+
+function measure(callable $fn): array {
+    gc_collect_cycles();
+    memory_reset_peak_usage();
+    $base = memory_get_usage();
+    $start = hrtime(true);
+    $fn();
+    return [(hrtime(true) - $start) / 1e6, (memory_get_peak_usage() - $base) / 1024];
+}
+
+function userland_stats(string $str, string $mode): array {
+    $max = 0;
+    $units = 0;
+    foreach (str_iter($str, $mode) as $unit) {
+        $units++;
+        $max = max($max, strlen($unit));
+    }
+    return [$units, $max];
+}
+
+printf("%-6s %-10s %-13s %10s %10s %10s %10s\n", "input", "mode", "function", "user ms", "native ms", "user KiB", "native KiB");
+foreach ($samples as $name => $sample) {
+    $str = str_repeat($sample, intdiv($size, strlen($sample)));
+    foreach (["grapheme", "codepoint", "word"] as $mode) {
+        $cases = [
+            "count_values" => [
+                fn() => array_count_values(str_iter($str, $mode)->toArray()),
+                fn() => str_iter_count_values($str, $mode),
+            ],
+            "stats" => [
+                fn() => userland_stats($str, $mode),
+                fn() => str_iter_stats($str, $mode),
+            ],
+        ];
+        foreach ($cases as $function => [$user, $native]) {
+            [$user_ms, $user_kib] = measure($user);
+            [$native_ms, $native_kib] = measure($native);
+            printf("%-6s %-10s %-13s %10.1f %10.1f %10.0f %10.0f\n",
+                $name, $mode, $function, $user_ms, $native_ms, $user_kib, $native_kib);
+        }
+    }
+}
+?>
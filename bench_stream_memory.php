@@ -0,0 +1,34 @@
+<?php
+// Benchmark: segmenting a large file through str_iter_stream()
+//
+// Memory stays bounded by the chunk size however large the file is; the
+// peak RSS reported at the end should stay well under 64 MB for 1 GB.
+// Usage: php bench_stream_memory.php [size in MB, default 1024] > bench_output.txt
+
+$mb = (int)($argv[1] ?? 1024);
+$path = tempnam(sys_get_temp_dir(), "striter");
+$block = str_repeat("Hello世界🌍 こんにちは 👨‍👩‍👧 café\r\n", 30000);
+
+$fp = fopen($path, "w");
+for ($written = 0; $written < $mb << 20; $written += strlen($block)) {
+    fwrite($fp, $block);
+}
+fclose($fp);
+
+foreach (["grapheme", "codepoint"] as $mode) {
+    $fp = fopen($path, "r");
+    $start = hrtime(true);
+    $units = 0;
+    foreach (str_iter_stream($fp, $mode) as $unit) {
+        $units++;
+    }
+    $ns = hrtime(true) - $start;
+    fclose($fp);
+
+    printf("%-10s %6d MB %12d units %8.1f s %8.1f MB/s\n",
+        $mode, $mb, $units, $ns / 1e9, (filesize($path) >> 20) / ($ns / 1e9));
+}
+
+unlink($path);
+printf("peak RSS: %.1f MB\n", getrusage()["ru_maxrss"] / 1024);
+?>
@@ -0,0 +1,45 @@
+<?php
+// Benchmark: materializing all units as an array
+//
+// Compares iterator_to_array() and a foreach loop, which both go through
+// the iterator protocol per element, with the native toArray() and
+// str_iter_split(), which size the array once and fill it directly.
+// Usage: php bench_to_array.php > bench_output.txt
+
+$size = 1 << 20;
+$samples = [
+    "ascii" => "The quick brown fox jumps over the lazy dog. ",
+    "mixed" => "Hello世界🌍 こんにちは 👨‍👩‍👧 café ",
+];
+
+function best_of(int $runs, callable $fn): int {
+    $best = PHP_INT_MAX;
+    for ($i = 0; $i < $runs; $i++) {
+        $start = hrtime(true);
+        $fn();
+        $best = min($best, hrtime(true) - $start);
+    }
+    return $best;
+}
+
+printf("%-6s %-10s %12s %12s %12s %12s %8s\n",
+    "input", "mode", "to_array ms", "foreach ms", "toArray ms", "split ms", "speedup");
+foreach ($samples as $name => $sample) {
+    $str = str_repeat($sample, intdiv($size, strlen($sample)));
+    foreach (["grapheme", "codepoint", "byte"] as $mode) {
+        $generic = best_of(3, fn() => iterator_to_array(str_iter($str, $mode)));
+        $loop = best_of(3, function () use ($str, $mode) {
+            $units = [];
+            foreach (str_iter($str, $mode) as $unit) {
+                $units[] = $unit;
+            }
+            return $units;
+        });
+        $native = best_of(3, fn() => str_iter($str, $mode)->toArray());
+        $split = best_of(3, fn() => str_iter_split($str, $mode));
+
+        printf("%-6s %-10s %12.2f %12.2f %12.2f %12.2f %7.1fx\n",
+            $name, $mode, $generic / 1e6, $loop / 1e6, $native / 1e6, $split / 1e6, $generic / $native);
+    }
+}
+?>
@@ -0,0 +1,47 @@
+<?php
+// Benchmark: str_iter_truncate() and str_iter_substr() versus iterating
+// and concatenating, and versus intl's grapheme_substr()
+//
+// The native functions stop segmenting at the end of the requested units,
+// so their cost should not depend on the length of the input.
+// Usage: php bench_truncate.php > bench_output.txt
+
+$sample = "Hello世界🌍 こんにちは 👨‍👩‍👧 café ";
+$sizes = [100, 10 << 10, 1 << 20];
+$n = 80;
+$rounds = 1000;
+
+function bench(callable $fn, int $rounds): float {
+    $start = hrtime(true);
+    for ($i = 0; $i < $rounds; $i++) {
+        $fn();
+    }
+    return (hrtime(true) - $start) / $rounds / 1e3;
+}
+
+printf("first %d grapheme clusters, us per call\n", $n);
+printf("%10s %12s %12s %12s %12s %12s\n", "bytes", "truncate", "substr", "substr -N", "foreach", "intl");
+foreach ($sizes as $size) {
+    $str = str_repeat($sample, max(1, intdiv($size, strlen($sample))));
+
+    $truncate = bench(fn() => str_iter_truncate($str, $n), $rounds);
+    $substr = bench(fn() => str_iter_substr($str, 0, $n), $rounds);
+    $tail = bench(fn() => str_iter_substr($str, -$n), $rounds);
+    $foreach = bench(function () use ($str, $n) {
+        $out = "";
+        $i = 0;
+        foreach (str_iter($str) as $cluster) {
+            if ($i++ === $n) {
+                break;
+            }
+            $out .= $cluster;
+        }
+        return $out;
+    }, $rounds);
+    $intl = function_exists("grapheme_substr")
+        ? sprintf("%12.2f", bench(fn() => grapheme_substr($str, 0, $n), $rounds))
+        : sprintf("%12s", "n/a");
+
+    printf("%10d %12.2f %12.2f %12.2f %12.2f %s\n", strlen($str), $truncate, $substr, $tail, $foreach, $intl);
+}
+?>
@@ -0,0 +1,43 @@
+<?php
+// Benchmark: strict UTF-8 validation throughput
+//
+// Strict mode validates the whole string when the iterator is created, so
+// the cost of str_iter($s, ..., ["strict" => true]) is the validator alone.
+// Copying the string ($str . "!") gives a rough memory bandwidth ceiling.
+// Usage: php -d striter.simd=scalar bench_utf8_validate.php, then =sse2, =avx2
+
+$size = 10 << 20;
+$samples = [
+    "ascii"    => "The quick brown fox jumps over the lazy dog. ",
+    "latin"    => "Größenwahn café naïve façade ",
+    "cjk"      => "こんにちは世界、日本語のテキスト。",
+    "emoji"    => "🌍👋🏽👨‍👩‍👧🇯🇵 ",
+];
+
+function best_of(int $runs, callable $fn): int {
+    $best = PHP_INT_MAX;
+    for ($i = 0; $i < $runs; $i++) {
+        $start = hrtime(true);
+        $fn();
+        $best = min($best, hrtime(true) - $start);
+    }
+    return $best;
+}
+
+printf("simd level: %s\n", ini_get("striter.simd"));
+printf("%-8s %10s %12s %12s\n", "input", "bytes", "MB/s", "copy MB/s");
+foreach ($samples as $name => $sample) {
+    $str = str_repeat($sample, intdiv($size, strlen($sample)));
+    $mb = strlen($str) / (1 << 20);
+
+    $validate = best_of(5, function () use ($str) {
+        str_iter($str, "codepoint", ["strict" => true]);
+    });
+    $copy = best_of(5, function () use ($str) {
+        $dup = $str . "!";
+        return strlen($dup);
+    });
+
+    printf("%-8s %10d %12.0f %12.0f\n", $name, strlen($str), $mb / ($validate / 1e9), $mb / ($copy / 1e9));
+}
+?>
@@ -0,0 +1,81 @@
+<?php
+// Benchmark: word and sentence modes versus intl's IntlBreakIterator
+//
+// Both follow UAX #29, so on text without dictionary-based scripts they
+// should find the same boundaries; ICU additionally splits CJK and Thai
+// runs into dictionary words, which the default rules keep as single
+// characters (ideographs) or runs (kana). The agreement column reports
+// whether the segment counts match.
+// Usage: php bench_word_sentence.php > bench_output.txt
+
+$corpus = [
+    "en" => "The quick brown fox doesn't jump over 3.14 lazy dogs. Mr. Smith said: \"Wait!\" Then he left. ",
+    "de" => "Größere Übungen fördern Käsespätzle-Rezepte. Wie geht's? Gut, danke! ",
+    "ru" => "Съешь же ещё этих мягких французских булок, да выпей чаю. Хорошо? ",
+    "el" => "Ξεσκεπάζω την ψυχοφθόρα βδελυγμία. Τι κάνεις; ",
+    "he" => "עטלף אבק נס דרך מזגן שהתפוצץ כי חם. מה נשמע? ",
+    "ar" => "نص حكيم له سر قاطع وذو شأن عظيم مكتوب على ثوب أخضر. ",
+    "hi" => "ऋषियों को सताने वाले दुष्ट राक्षसों के राजा रावण का सर्वनाश करने वाले विष्णुवतार भगवान श्रीराम। ",
+    "ja" => "いろはにほへと ちりぬるを。カタカナのテキスト、漢字交じり文。 ",
+    "emoji" => "Nice 👍🏽 work 👨‍👩‍👧 team 🇯🇵! ",
+];
+$str = str_repeat(implode("", $corpus), 2000);
+
+function bench(callable $fn, int $rounds = 5): array {
+    $best = PHP_INT_MAX;
+    $result = null;
+    for ($i = 0; $i < $rounds; $i++) {
+        $start = hrtime(true);
+        $result = $fn();
+        $best = min($best, hrtime(true) - $start);
+    }
+    return [$best / 1e6, $result];
+}
+
+printf("corpus: %d bytes\n", strlen($str));
+printf("%-9s %-10s %10s %12s %12s\n", "mode", "engine", "segments", "count ms", "foreach ms");
+
+foreach (["word", "sentence"] as $mode) {
+    [$count_ms, $count] = bench(fn() => count(str_iter($str, $mode)));
+    [$foreach_ms] = bench(function () use ($str, $mode) {
+        $n = 0;
+        foreach (str_iter($str, $mode) as $segment) {
+            $n++;
+        }
+        return $n;
+    });
+    printf("%-9s %-10s %10d %12.2f %12.2f\n", $mode, "striter", $count, $count_ms, $foreach_ms);
+
+    if (!class_exists("IntlBreakIterator")) {
+        continue;
+    }
+
+    $create = $mode === "word"
+        ? fn() => IntlBreakIterator::createWordInstance("en")
+        : fn() => IntlBreakIterator::createSentenceInstance("en");
+    [$icu_count_ms, $icu_count] = bench(function () use ($str, $create) {
+        $it = $create();
+        $it->setText($str);
+        $n = 0;
+        while ($it->next() !== IntlBreakIterator::DONE) {
+            $n++;
+        }
+        return $n;
+    });
+    [$icu_foreach_ms] = bench(function () use ($str, $create) {
+        $it = $create();
+        $it->setText($str);
+        $n = 0;
+        foreach ($it->getPartsIterator() as $segment) {
+            $n++;
+        }
+        return $n;
+    });
+    printf("%-9s %-10s %10d %12.2f %12.2f %s\n", $mode, "intl", $icu_count, $icu_count_ms, $icu_foreach_ms,
+        $icu_count === $count ? "agree" : sprintf("differ by %+d", $icu_count - $count));
+}
+
+if (!class_exists("IntlBreakIterator")) {
+    echo "intl not loaded, striter timings only\n";
+}
+?>
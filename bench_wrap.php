@@ -0,0 +1,59 @@
+<?php
+// Benchmark: str_iter_wrap() and line mode
+//
+// wordwrap() is the byte-based baseline: it is not width or UAX #14 aware,
+// so it wraps CJK text by bytes and never breaks between ideographs, but
+// it shows the cost of a plain single pass. Line segments are compared
+// with intl's IntlBreakIterator when loaded; ICU applies the same default
+// rules, plus its number tailoring.
+// Usage: php bench_wrap.php > bench_output.txt
+
+$corpus = [
+    "en" => "The quick brown fox doesn't jump over 3.14 lazy dogs; well-known, self-evident facts. ",
+    "de" => "Größere Übungen fördern Käsespätzle-Rezepte. Wie geht's? Gut, danke! ",
+    "ja" => "いろはにほへと ちりぬるを。カタカナのテキスト、漢字交じり文。",
+    "zh" => "我能吞下玻璃而不伤身体。",
+    "emoji" => "Nice 👍🏽 work 👨‍👩‍👧 team 🇯🇵! ",
+];
+$str = str_repeat(implode("", $corpus), 2000);
+
+function bench(callable $fn, int $rounds = 5): array {
+    $best = PHP_INT_MAX;
+    $result = null;
+    for ($i = 0; $i < $rounds; $i++) {
+        $start = hrtime(true);
+        $result = $fn();
+        $best = min($best, hrtime(true) - $start);
+    }
+    return [$best / 1e6, $result];
+}
+
+printf("corpus: %d bytes\n", strlen($str));
+printf("%-28s %10s %12s\n", "operation", "result", "ms");
+
+foreach ([40, 80] as $width) {
+    [$ms, $chunks] = bench(fn() => str_iter_wrap($str, $width));
+    printf("%-28s %10d %12.2f\n", "str_iter_wrap($width)", count($chunks), $ms);
+    [$ms, $wrapped] = bench(fn() => wordwrap($str, $width, "\n", true));
+    printf("%-28s %10d %12.2f\n", "wordwrap($width) (bytes)", substr_count($wrapped, "\n") + 1, $ms);
+}
+
+[$ms, $count] = bench(fn() => count(str_iter($str, "line")));
+printf("%-28s %10d %12.2f\n", "line mode count()", $count, $ms);
+
+if (class_exists("IntlBreakIterator")) {
+    [$ms, $icu_count] = bench(function () use ($str) {
+        $it = IntlBreakIterator::createLineInstance("en");
+        $it->setText($str);
+        $n = 0;
+        while ($it->next() !== IntlBreakIterator::DONE) {
+            $n++;
+        }
+        return $n;
+    });
+    printf("%-28s %10d %12.2f %s\n", "intl line count", $icu_count, $ms,
+        $icu_count === $count ? "agree" : sprintf("differ by %+d", $icu_count - $count));
+} else {
+    echo "intl not loaded, striter timings only\n";
+}
+?>
@@ -0,0 +1,60 @@
+<?php
+// Benchmark: grapheme throughput with 1-32 threads (ZTS builds)
+//
+// Every thread iterates and counts its own copy of the same text. Grapheme
+// pattern reads take no lock, so total throughput should grow with the
+// thread count up to the number of cores.
+// Requires a ZTS build of PHP with ext/parallel.
+// Usage: php bench_zts_scaling.php [native|pcre2] > bench_output.txt
+
+if (!PHP_ZTS || !class_exists(\parallel\Runtime::class)) {
+    fwrite(STDERR, "This benchmark needs a ZTS build with ext/parallel\n");
+    exit(1);
+}
+
+$engine = $argv[1] ?? "pcre2";
+$threads = [1, 2, 4, 8, 16, 32];
+$text = str_repeat("Hello世界🌍 こんにちは 👨‍👩‍👧 café ", 20000);
+$rounds = 5;
+
+$work = function (string $engine, string $text, int $rounds): int {
+    ini_set("striter.grapheme_engine", $engine);
+    $units = 0;
+    for ($i = 0; $i < $rounds; $i++) {
+        foreach (str_iter($text) as $cluster) {
+            $units++;
+        }
+        $units += count(str_iter($text));
+    }
+    return $units;
+};
+
+printf("engine: %s, %d bytes per thread and round\n", $engine, strlen($text));
+printf("%-8s %10s %14s %10s\n", "threads", "ms", "units/s", "speedup");
+$base = null;
+foreach ($threads as $n) {
+    $runtimes = [];
+    for ($t = 0; $t < $n; $t++) {
+        $runtimes[] = new \parallel\Runtime();
+    }
+
+    $start = hrtime(true);
+    $futures = [];
+    foreach ($runtimes as $runtime) {
+        $futures[] = $runtime->run($work, [$engine, $text, $rounds]);
+    }
+    $units = 0;
+    foreach ($futures as $future) {
+        $units += $future->value();
+    }
+    $ns = hrtime(true) - $start;
+
+    foreach ($runtimes as $runtime) {
+        $runtime->close();
+    }
+
+    $rate = $units / ($ns / 1e9);
+    $base ??= $rate;
+    printf("%-8d %10.1f %14.0f %9.2fx\n", $n, $ns / 1e6, $rate, $rate / $base);
+}
+?>
@@ -1,19 +1,37 @@
 PHP_ARG_ENABLE(striter, whether to enable striter support,
 [  --enable-striter        Enable striter support])
 
+PHP_ARG_WITH(striter-pcre2, whether to build the PCRE2 grapheme engine,
+[  --without-striter-pcre2 Build without the PCRE2 cross-check grapheme engine], yes, no)
+
 if test "$PHP_STRITER" != "no"; then
-  PHP_CHECK_LIBRARY(pcre2-8, pcre2_compile_8, [
-    PHP_ADD_LIBRARY(pcre2-8, 1, STRITER_SHARED_LIBADD)
-    AC_DEFINE(HAVE_PCRE2, 1, [Have PCRE2 library])
-    
-    # Check for JIT support
-    PHP_CHECK_LIBRARY(pcre2-8, pcre2_jit_compile, [
-      AC_DEFINE(HAVE_PCRE2_JIT, 1, [Have PCRE2 JIT support])
-    ], [], [-lpcre2-8])
-  ], [
-    AC_MSG_ERROR([PCRE2 library not found. Please install libpcre2-dev])
+  dnl Grapheme segmentation is native (striter_grapheme.c); PCRE2 is an
+  dnl optional second engine selectable with striter.grapheme_engine=pcre2
+  if test "$PHP_STRITER_PCRE2" != "no"; then
+    PHP_CHECK_LIBRARY(pcre2-8, pcre2_compile_8, [
+      PHP_ADD_LIBRARY(pcre2-8, 1, STRITER_SHARED_LIBADD)
+      AC_DEFINE(HAVE_PCRE2, 1, [Have PCRE2 library])
+
+      # Check for JIT support
+      PHP_CHECK_LIBRARY(pcre2-8, pcre2_jit_compile, [
+        AC_DEFINE(HAVE_PCRE2_JIT, 1, [Have PCRE2 JIT support])
+      ], [], [-lpcre2-8])
+    ], [
+      AC_MSG_WARN([PCRE2 library not found, building the native grapheme engine only])
+    ])
+  fi
+
+  dnl str_iter_file() maps files when mmap is available and reads them otherwise
+  AC_CHECK_HEADERS([sys/mman.h])
+  AC_CHECK_FUNCS([mmap madvise])
+
+  dnl striter.threads spreads counting over a pthread pool; serial without it
+  AC_CHECK_HEADERS([pthread.h])
+  PHP_CHECK_LIBRARY(pthread, pthread_create, [
+    PHP_ADD_LIBRARY(pthread, 1, STRITER_SHARED_LIBADD)
   ])
-  
-  PHP_NEW_EXTENSION(striter, striter.c string_iterator.c, $ext_shared)
+
+  PHP_NEW_EXTENSION(striter, striter.c string_iterator.c striter_grapheme.c striter_simd.c striter_stream.c striter_file.c striter_parallel.c striter_segment.c striter_line.c striter_cache.c striter_index.c striter_stats.c striter_normalize.c striter_casefold.c striter_encoding.c, $ext_shared)
+  PHP_ADD_EXTENSION_DEP(striter, spl)
   PHP_SUBST(STRITER_SHARED_LIBADD)
-fi
\ No newline at end of file
+fi
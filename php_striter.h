@@ -19,53 +19,335 @@ extern zend_module_entry striter_module_entry;
 // _StrIterIterator class entry
 extern zend_class_entry *striter_string_iterator_ce;
 
+// _StrIterStreamIterator class entry
+extern zend_class_entry *striter_stream_iterator_ce;
+
 // Iterator mode enumeration
 typedef enum {
     STRITER_MODE_GRAPHEME = 0,
     STRITER_MODE_CODEPOINT = 1,
-    STRITER_MODE_BYTE = 2
+    STRITER_MODE_BYTE = 2,
+    STRITER_MODE_WORD = 3,
+    STRITER_MODE_SENTENCE = 4,
+    STRITER_MODE_LINE = 5
 } striter_mode_t;
 
+// Source encodings of the encoding option (striter_encoding.c)
+typedef enum {
+    STRITER_ENCODING_UTF8 = 0,
+    STRITER_ENCODING_UTF16LE = 1,
+    STRITER_ENCODING_UTF16BE = 2,
+    STRITER_ENCODING_LATIN1 = 3
+} striter_encoding_t;
+
+// Decode the codepoint at the start of s (len > 0). Returns it, or -1 for
+// an invalid sequence; *advance is set to the source bytes used either way.
+typedef int32_t (*striter_decode_func)(const unsigned char *s, size_t len, size_t *advance);
+
+// Transcode whole codepoints from src[0..src_len) into UTF-8 in out, as
+// long as out_cap leaves room for one more. Returns the bytes written and
+// sets *src_used. An invalid sequence becomes the invalid byte 0xFE (one
+// source byte) or 0xFF (two), so that it stays a unit of its own.
+typedef size_t (*striter_transcode_func)(const unsigned char *src, size_t src_len, char *out, size_t out_cap, size_t *src_used);
+
+// Decoder dispatch table entry, indexed by striter_encoding_t. Every
+// function is specialized for its encoding at compile time, so the
+// dispatch costs one indirect call per unit or window, not per codepoint.
+typedef struct _striter_decoder {
+    const char *name;           // Canonical name, as accepted by the option
+    const char *alias;          // Other accepted name, or NULL
+    uint8_t unit;               // Bytes per code unit
+    striter_decode_func decode;
+    striter_transcode_func transcode;
+} striter_decoder;
+
+extern const striter_decoder striter_decoders[];
+
+// Grapheme segmentation engines
+typedef enum {
+    STRITER_ENGINE_NATIVE = 0,  // Built-in UAX #29 tables (striter_grapheme.c)
+    STRITER_ENGINE_PCRE2 = 1    // PCRE2 \X, kept as a cross-check backend
+} striter_grapheme_engine_t;
+
+// Vector instruction levels for the scanning kernels (striter_simd.c)
+typedef enum {
+    STRITER_SIMD_SCALAR = 0,
+    STRITER_SIMD_SSE2 = 1,
+    STRITER_SIMD_AVX2 = 2
+} striter_simd_t;
+
+// Unicode normalization forms of the normalize option (striter_normalize.c)
+typedef enum {
+    STRITER_NORM_NONE = 0,
+    STRITER_NORM_NFC = 1,
+    STRITER_NORM_NFD = 2
+} striter_norm_t;
+
+// Segmentation cache (striter_cache.c)
+typedef struct _striter_cache striter_cache;
+typedef struct _striter_cache_entry striter_cache_entry;
+
+// Units per block of the compact unit index (striter_index.c)
+#define STRITER_UNIT_BLOCK 64
+
+// Start of a block of the unit index
+typedef struct _striter_unit_block {
+    size_t offset;              // Byte offset of the block's first unit
+    size_t long_index;          // Long units before the block
+} striter_unit_block;
+
+// Compact table of every unit boundary, built by the first pass of an
+// iterator created with the indexed option. Unit lengths are stored as
+// single bytes, with 0 as the escape for units over 255 bytes, whose
+// lengths go to long_lengths; each block of STRITER_UNIT_BLOCK units
+// starts with an absolute offset.
+typedef struct _striter_unit_index {
+    uint8_t *lengths;           // Byte length of every unit, 0 if over 255
+    size_t count;               // Units recorded
+    size_t cap;                 // Lengths allocated, a multiple of STRITER_UNIT_BLOCK
+    striter_unit_block *blocks; // One per STRITER_UNIT_BLOCK units
+    size_t *long_lengths;       // Lengths of the units over 255 bytes, in order
+    size_t long_count;          // Long units recorded
+    size_t long_cap;            // Long lengths allocated
+    size_t end;                 // Byte offset after the last unit recorded
+} striter_unit_index;
+
+typedef size_t (*striter_ascii_span_func)(const unsigned char *s, size_t len);
+typedef size_t (*striter_utf8_validate_func)(const unsigned char *s, size_t len);
+
+ZEND_BEGIN_MODULE_GLOBALS(striter)
+    striter_grapheme_engine_t grapheme_engine;
+    striter_simd_t simd;
+    striter_ascii_span_func ascii_span;
+    striter_utf8_validate_func utf8_validate;
+    zend_long index_interval;       // Units between random-access checkpoints
+    zend_long threads;              // Threads for counting and indexing (0 = serial)
+    zend_long cache_size;           // Segmentation cache budget in bytes (0 = off)
+    striter_cache *cache;           // Segmentation cache, created on first store
+    bool cache_in_request;          // Request-interned strings may be cached
+    zend_ulong cache_hits;
+    zend_ulong cache_misses;
+    zend_ulong cache_evictions;
+#ifdef HAVE_PCRE2
+    pcre2_match_data *match_data;   // Reused by every grapheme match on this thread
+#endif
+ZEND_END_MODULE_GLOBALS(striter)
+
+ZEND_EXTERN_MODULE_GLOBALS(striter)
+#define STRITER_G(v) ZEND_MODULE_GLOBALS_ACCESSOR(striter, v)
+
+#if defined(ZTS) && defined(COMPILE_DL_STRITER)
+ZEND_TSRMLS_CACHE_EXTERN()
+#endif
+
+// Byte range [start, end) known to be valid UTF-8, cached between steps
+typedef struct _striter_utf8_run {
+    size_t start;
+    size_t end;
+} striter_utf8_run;
+
+// Options accepted by str_iter() and the constructor
+typedef struct _striter_options {
+    bool strict;                // Reject invalid UTF-8 with a ValueError up front
+    bool substitute;            // Yield U+FFFD for invalid sequences
+    bool offsets;               // Yield [byteOffset, byteLength] instead of strings
+    bool reverse;               // Iterate backwards (str_iter_reverse)
+    bool indexed;               // Record every unit boundary in a compact index
+    size_t chunk;               // Units per step (0 = one)
+    size_t chunk_bytes;         // Bytes per step, rounded down to a unit boundary (0 = off)
+    striter_norm_t normalize;   // Normalization form of yielded units
+    striter_encoding_t encoding; // Encoding of the string
+} striter_options;
+
+// UTF-8 transcoding of part of a source in another encoding, in which
+// units are measured (striter_encoding.c)
+typedef struct _striter_decode_window {
+    char *buf;                  // UTF-8 of source[start..end)
+    size_t len;
+    size_t cap;
+    size_t start;               // Source offset of buf[0]
+    size_t end;                 // Source offset the transcoding stopped at
+    size_t mark;                // Source offset of the last unit end measured
+    size_t mark_at;             // Offset of mark in buf
+} striter_decode_window;
+
 // _StrIterIterator object structure
 typedef struct _striter_string_iterator_obj {
     zend_string *str;           // Source string
     size_t position;            // Current byte position in string
-    size_t char_index;          // Current character index (0-based)
-    size_t total_chars;         // Total characters in string
+    size_t unit_len;            // Byte length of the current unit (0 = not measured yet)
+    striter_utf8_run valid_run; // Known-valid UTF-8 range around the cursor (PCRE2 engine)
+    size_t char_index;          // Current character index (0-based), or with
+                                // index_from_end the units from the cursor on
+    bool index_from_end;        // char_index counts from the end of the string
+    bool reverse;               // Iterate from the last unit to the first
+    size_t total_chars;         // Total characters in string (valid once count_known)
+    bool count_known;           // Whether total_chars has been computed
+    size_t scan_pos;            // Furthest unit boundary reached by any cursor
+    size_t scan_index;          // Unit index at scan_pos
     striter_mode_t mode;        // Iteration mode (grapheme or codepoint)
+    bool substitute;            // Yield U+FFFD for invalid sequences
+    bool offsets;               // Yield [byteOffset, byteLength] instead of strings
+    size_t *checkpoints;        // Byte offset of every index_interval-th unit
+    size_t checkpoint_count;    // Checkpoints recorded so far
+    size_t checkpoint_cap;      // Checkpoints allocated
+    size_t index_interval;      // Units between checkpoints
+    striter_cache_entry *cache_entry; // Cache entry whose checkpoints are shared, or NULL
+    striter_unit_index *unit_index; // Every unit boundary (indexed option), or NULL
+    size_t chunk;               // Units per step (chunk option), 0 if not chunked
+    size_t chunk_bytes;         // Bytes per step (chunk_bytes option), 0 if not chunked
+    striter_norm_t normalize;   // Normalization form of yielded units (normalize option)
+    striter_encoding_t encoding; // Encoding of str (encoding option); byte offsets are in str
+    striter_decode_window window; // Transcoded window of str, if not UTF-8
+    void *mapping;              // mmap region str lives in (str_iter_file), or NULL
+    size_t mapping_len;         // Length of the mmap region
     zend_object std;            // Standard object
 } striter_string_iterator_obj;
 
+// _StrIterStreamIterator object structure. The stream is read in chunks
+// into buf; only the bytes from the current unit on are kept.
+typedef struct _striter_stream_obj {
+    zval stream;                // Stream resource being read
+    striter_mode_t mode;        // Iteration mode
+    char *buf;                  // Read buffer
+    size_t buf_cap;             // Bytes allocated for buf
+    size_t buf_len;             // Bytes of buf filled from the stream
+    size_t buf_pos;             // Offset of the current unit in buf
+    size_t unit_len;            // Byte length of the current unit (0 = not measured yet)
+    size_t char_index;          // Current unit index
+    striter_utf8_run valid_run; // Known-valid UTF-8 range in buf (PCRE2 engine)
+    zend_off_t start_offset;    // Stream position at creation, for rewind()
+    bool eof;                   // No more data will come from the stream
+    bool started;               // Data has been read since the last rewind
+    zend_object std;            // Standard object
+} striter_stream_obj;
+
 // Object accessor macro
 static inline striter_string_iterator_obj *striter_string_iterator_from_obj(zend_object *obj) {
     return (striter_string_iterator_obj*)((char*)(obj) - XtOffsetOf(striter_string_iterator_obj, std));
 }
 
+static inline striter_stream_obj *striter_stream_from_obj(zend_object *obj) {
+    return (striter_stream_obj*)((char*)(obj) - XtOffsetOf(striter_stream_obj, std));
+}
+
 // Internal iterator structure for IteratorAggregate
 typedef struct _striter_iterator {
     zend_object_iterator intern;
-    size_t current_pos;
+    size_t current_pos;         // Current unit index
+    size_t byte_pos;            // Byte offset of the current unit
+    size_t unit_len;            // Byte length of the current unit (0 = not measured yet)
     zval current_value;
 } striter_iterator;
 
 // Function declarations
 PHP_FUNCTION(str_iter);
+PHP_FUNCTION(str_iter_split);
+PHP_FUNCTION(str_iter_stream);
+PHP_FUNCTION(str_iter_file);
+PHP_FUNCTION(str_iter_wrap);
+PHP_FUNCTION(str_iter_reverse);
+PHP_FUNCTION(str_iter_chunks);
+PHP_FUNCTION(str_iter_count_values);
+PHP_FUNCTION(str_iter_stats);
+PHP_FUNCTION(str_iter_casecmp);
+PHP_FUNCTION(str_iter_starts_with_folded);
+PHP_FUNCTION(str_iter_substr);
+PHP_FUNCTION(str_iter_truncate);
 
 // ArgInfo declarations
 ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter, 0, 0, 1)
     ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 0, "[]")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_reverse, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 0, "[]")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_chunks, 0, 0, 2)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, size, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_count_values, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_stats, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_casecmp, 0, 0, 2)
+    ZEND_ARG_TYPE_INFO(0, a, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, b, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, full, _IS_BOOL, 0, "true")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_starts_with_folded, 0, 0, 2)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, prefix, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, full, _IS_BOOL, 0, "true")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_split, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 0, "\"grapheme\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, chunk, IS_LONG, 0, "1")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_substr, 0, 0, 2)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, start, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, length, IS_LONG, 1, "null")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_truncate, 0, 0, 2)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, length, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, suffix, IS_STRING, 0, "\"\\u{2026}\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_stream, 0, 0, 1)
+    ZEND_ARG_INFO(0, stream)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 0, "\"grapheme\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, chunk_size, IS_LONG, 0, "65536")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_file, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, path, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 0, "\"grapheme\"")
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_str_iter_wrap, 0, 0, 2)
+    ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
+    ZEND_ARG_TYPE_INFO(0, width, IS_LONG, 0)
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, cut, _IS_BOOL, 0, "true")
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_construct, 0, 0, 1)
     ZEND_ARG_TYPE_INFO(0, str, IS_STRING, 0)
     ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, mode, IS_STRING, 1, "\"grapheme\"")
+    ZEND_ARG_TYPE_INFO_WITH_DEFAULT_VALUE(0, options, IS_ARRAY, 0, "[]")
 ZEND_END_ARG_INFO()
 
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_current, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_currentoffset, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_key, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
@@ -75,6 +357,12 @@ ZEND_END_ARG_INFO()
 ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_rewind, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_prev, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_end, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_valid, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
@@ -84,8 +372,37 @@ ZEND_END_ARG_INFO()
 ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_count, 0, 0, 0)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_toarray, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_indexsize, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_seek, 0, 0, 1)
+    ZEND_ARG_TYPE_INFO(0, offset, IS_LONG, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_offsetexists, 0, 0, 1)
+    ZEND_ARG_INFO(0, offset)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_offsetget, 0, 0, 1)
+    ZEND_ARG_INFO(0, offset)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_offsetset, 0, 0, 2)
+    ZEND_ARG_INFO(0, offset)
+    ZEND_ARG_INFO(0, value)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_striteriterator_offsetunset, 0, 0, 1)
+    ZEND_ARG_INFO(0, offset)
+ZEND_END_ARG_INFO()
+
 PHP_MINIT_FUNCTION(striter);
 PHP_MSHUTDOWN_FUNCTION(striter);
+PHP_RINIT_FUNCTION(striter);
+PHP_RSHUTDOWN_FUNCTION(striter);
 PHP_MINFO_FUNCTION(striter);
 
 // _StrIterIterator class method declarations
@@ -94,31 +411,194 @@ PHP_METHOD(_StrIterIterator, current);
 PHP_METHOD(_StrIterIterator, key);
 PHP_METHOD(_StrIterIterator, next);
 PHP_METHOD(_StrIterIterator, rewind);
+PHP_METHOD(_StrIterIterator, prev);
+PHP_METHOD(_StrIterIterator, end);
 PHP_METHOD(_StrIterIterator, valid);
 PHP_METHOD(_StrIterIterator, getIterator);
 PHP_METHOD(_StrIterIterator, count);
 
+// _StrIterStreamIterator class method declarations
+PHP_METHOD(_StrIterStreamIterator, getIterator);
+
 // Internal utility functions
+size_t striter_utf8_char_length(const char *str, size_t len, size_t pos);
+size_t striter_utf8_char_length_before(const char *str, size_t len, size_t end);
+size_t striter_unit_length_at(const char *str, size_t len, size_t pos, striter_mode_t mode, striter_utf8_run *valid_run);
+size_t striter_unit_length(striter_string_iterator_obj *obj, size_t pos);
+size_t striter_unit_length_before_at(const char *str, size_t len, size_t end, size_t known, striter_mode_t mode, striter_utf8_run *valid_run);
 size_t striter_count_utf8_chars(const char *str, size_t len);
+size_t striter_count_utf8_chars_with(const char *str, size_t len, striter_ascii_span_func ascii_span);
+size_t striter_count_units(const char *str, size_t len, striter_mode_t mode);
+
+// Decode the UTF-8 sequence at the start of s. Returns the codepoint, or -1
+// for an invalid sequence; *advance is set to the bytes consumed either way
+// (for invalid sequences, the same amount php_next_utf8_char skips).
+static zend_always_inline int32_t striter_utf8_decode(const unsigned char *s, size_t len, size_t *advance)
+{
+    unsigned char c = s[0];
+    
+    if (c < 0x80) {
+        *advance = 1;
+        return c;
+    }
+    if (c >= 0xC2 && c < 0xE0) {
+        if (len >= 2 && (s[1] & 0xC0) == 0x80) {
+            *advance = 2;
+            return ((c & 0x1F) << 6) | (s[1] & 0x3F);
+        }
+    } else if (c >= 0xE0 && c < 0xF0) {
+        if (len >= 3 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80) {
+            int32_t cp = ((c & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+            if (cp >= 0x800 && (cp < 0xD800 || cp > 0xDFFF)) {
+                *advance = 3;
+                return cp;
+            }
+        }
+    } else if (c >= 0xF0 && c < 0xF5) {
+        if (len >= 4 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80) {
+            int32_t cp = ((c & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+            if (cp >= 0x10000 && cp <= 0x10FFFF) {
+                *advance = 4;
+                return cp;
+            }
+        }
+    }
+    
+    *advance = striter_utf8_char_length((const char *)s, len, 0);
+    return -1;
+}
+
+// String holding one unit. Single bytes come from PHP's interned
+// one-character table (ZSTR_CHAR), so byte mode and ASCII units never
+// allocate.
+static zend_always_inline zend_string *striter_unit_string(const char *s, size_t len)
+{
+    if (len == 1) {
+        return ZSTR_CHAR((zend_uchar)s[0]);
+    }
+    return zend_string_init(s, len, 0);
+}
+
+// str[start..end) as a string of its own: the whole string is shared and
+// an empty or single-byte slice is interned, so only other slices allocate
+static zend_always_inline zend_string *striter_substring(zend_string *str, size_t start, size_t end)
+{
+    if (start == 0 && end == ZSTR_LEN(str)) {
+        return zend_string_copy(str);
+    }
+    if (start >= end) {
+        return ZSTR_EMPTY_ALLOC();
+    }
+    return striter_unit_string(ZSTR_VAL(str) + start, end - start);
+}
+
+// Vectorized scanning kernels (striter_simd.c)
+striter_simd_t striter_simd_select(striter_simd_t requested);
+const char *striter_simd_name(striter_simd_t level);
+size_t striter_count_crlf(const unsigned char *s, size_t n);
+
+// Length of the leading run of ASCII bytes in s[0..len)
+static zend_always_inline size_t striter_ascii_span(const unsigned char *s, size_t len)
+{
+    return STRITER_G(ascii_span)(s, len);
+}
+
+// Byte offset of the first invalid UTF-8 sequence in str, or len if the
+// whole string is valid
+static zend_always_inline size_t striter_utf8_validate(const char *str, size_t len)
+{
+    return STRITER_G(utf8_validate)((const unsigned char *)str, len);
+}
+
+// Grapheme cluster segmentation (striter_grapheme.c)
+size_t striter_grapheme_length(const char *str, size_t len, size_t pos, striter_utf8_run *valid_run);
+size_t striter_count_graphemes(const char *str, size_t len);
+size_t striter_grapheme_length_native(const char *str, size_t len, size_t pos);
+size_t striter_count_graphemes_native(const char *str, size_t len);
+size_t striter_count_graphemes_native_with(const char *str, size_t len, striter_ascii_span_func ascii_span);
+bool striter_grapheme_is_safe_break(const char *str, size_t len, size_t pos);
+bool striter_is_extended_pictographic(uint32_t cp);
+
+// Word and sentence segmentation (striter_segment.c)
+size_t striter_word_length(const char *str, size_t len, size_t pos);
+size_t striter_sentence_length(const char *str, size_t len, size_t pos);
+size_t striter_count_words(const char *str, size_t len);
+size_t striter_count_sentences(const char *str, size_t len);
+
+// Line breaking and wrapping (striter_line.c)
+size_t striter_line_length(const char *str, size_t len, size_t pos, bool *mandatory);
+size_t striter_count_line_segments(const char *str, size_t len);
+
+// Parallel counting and indexing (striter_parallel.c). Each thread gets at
+// least this many bytes; smaller strings are always scanned serially.
+#define STRITER_PARALLEL_MIN_BYTES (1024 * 1024)
+
+int striter_parallel_threads(size_t len, striter_mode_t mode);
+size_t striter_parallel_count(const char *str, size_t len, striter_mode_t mode, int nthreads);
+void striter_parallel_index(striter_string_iterator_obj *obj, int nthreads);
+void striter_parallel_shutdown(void);
 zend_string *striter_get_char_at_position(const char *str, size_t str_len, size_t char_index, size_t *byte_pos);
 
 #ifdef HAVE_PCRE2
 extern pcre2_code *striter_grapheme_pattern;
-#ifdef ZTS
-extern zend_mutex_t striter_pattern_mutex;
-#endif
+void striter_compile_grapheme_pattern(void);
 size_t striter_count_graphemes_pcre2(const char *str, size_t len);
+size_t striter_grapheme_length_pcre2(const char *str, size_t len, size_t pos, striter_utf8_run *valid_run);
 zend_string *striter_get_grapheme_at_position(const char *str, size_t str_len, size_t char_index, size_t *byte_pos);
 pcre2_code *striter_get_grapheme_pattern(void);
 int striter_get_jit_status(void);
 #endif
 
 striter_mode_t striter_parse_mode(const char *mode_str);
+zend_result striter_parse_arguments(zend_string *str, zend_string *mode, HashTable *options, striter_mode_t *iter_mode, striter_options *opts);
+
+// Interned "\u{FFFD}" returned for invalid sequences in substitute mode
+extern zend_string *striter_replacement_char;
+// Interned UTF-8 strings of U+0080 to U+00FF, yielded for Latin-1 sources
+extern zend_string *striter_latin1_chars[128];
 size_t striter_count_bytes(const char *str, size_t len);
 zend_string *striter_get_byte_at_position(const char *str, size_t str_len, size_t byte_index);
 
 // _StrIterIterator class initialization
 void striter_string_iterator_init(void);
 zend_object *striter_string_iterator_create_object(zend_class_entry *ce);
+void striter_string_iterator_setup(striter_string_iterator_obj *obj, zend_string *str, striter_mode_t mode, const striter_options *opts);
+size_t striter_string_iterator_count(striter_string_iterator_obj *obj);
+void striter_string_iterator_to_array(striter_string_iterator_obj *obj, size_t chunk, zval *return_value);
+
+// Segmentation cache for interned strings (striter.cache_size)
+void striter_cache_lookup(striter_string_iterator_obj *obj);
+void striter_cache_store(striter_string_iterator_obj *obj);
+void striter_cache_release(striter_cache_entry *entry);
+void striter_cache_resize(void);
+void striter_cache_begin_request(void);
+void striter_cache_end_request(void);
+void striter_cache_destroy(striter_cache *cache);
+void striter_cache_info(void);
+
+// Compact unit index (indexed option)
+striter_unit_index *striter_unit_index_create(void);
+void striter_unit_index_append(striter_unit_index *index, size_t unit_len);
+void striter_unit_index_shrink(striter_unit_index *index);
+size_t striter_unit_index_offset(const striter_unit_index *index, size_t i, size_t *unit_len);
+size_t striter_unit_index_length(const striter_unit_index *index, size_t i);
+size_t striter_unit_index_size(const striter_unit_index *index);
+void striter_unit_index_free(striter_unit_index *index);
+
+// Unicode normalization (normalize option)
+zend_string *striter_normalize(const char *str, size_t len, striter_norm_t form, bool substitute);
+
+// Sources in other encodings (encoding option)
+bool striter_parse_encoding(zend_string *name, striter_encoding_t *encoding);
+size_t striter_decoded_validate(striter_encoding_t encoding, const char *str, size_t len);
+size_t striter_decoded_length(striter_string_iterator_obj *obj, size_t pos);
+zend_string *striter_decoded_string(striter_string_iterator_obj *obj, size_t pos, size_t len);
+void striter_decode_window_free(striter_decode_window *window);
+
+// Memory-mapped files (str_iter_file)
+void striter_file_unmap(void *mapping, size_t mapping_len);
+
+// _StrIterStreamIterator class initialization
+void striter_stream_iterator_init(void);
 
 #endif /* PHP_STRITER_H */
\ No newline at end of file
@@ -3,6 +3,8 @@
 #endif
 
 #include "php.h"
+#include "zend_interfaces.h"
+#include "ext/spl/spl_exceptions.h"
 #include "php_striter.h"
 
 // Object handlers
@@ -21,21 +23,258 @@ zend_object *striter_string_iterator_create_object(zend_class_entry *ce)
     // Initialize fields
     obj->str = NULL;
     obj->position = 0;
+    obj->unit_len = 0;
+    obj->valid_run.start = obj->valid_run.end = 0;
     obj->char_index = 0;
+    obj->index_from_end = 0;
+    obj->reverse = 0;
     obj->total_chars = 0;
+    obj->count_known = 0;
+    obj->scan_pos = 0;
+    obj->scan_index = 0;
     obj->mode = STRITER_MODE_GRAPHEME;
+    obj->substitute = 0;
+    obj->offsets = 0;
+    obj->checkpoints = NULL;
+    obj->checkpoint_count = 0;
+    obj->checkpoint_cap = 0;
+    obj->index_interval = 1;
+    obj->cache_entry = NULL;
+    obj->unit_index = NULL;
+    obj->chunk = 0;
+    obj->chunk_bytes = 0;
+    obj->normalize = STRITER_NORM_NONE;
+    obj->encoding = STRITER_ENCODING_UTF8;
+    memset(&obj->window, 0, sizeof(obj->window));
+    obj->mapping = NULL;
+    obj->mapping_len = 0;
     
     return &obj->std;
 }
 
+// Drop the object's checkpoint and unit indexes, offering what the object
+// learned about its string to the segmentation cache first
+static void striter_string_iterator_release_index(striter_string_iterator_obj *obj)
+{
+    striter_cache_store(obj);
+    if (obj->cache_entry) {
+        striter_cache_release(obj->cache_entry);
+        obj->cache_entry = NULL;
+    } else if (obj->checkpoints) {
+        efree(obj->checkpoints);
+    }
+    obj->checkpoints = NULL;
+    obj->checkpoint_count = 0;
+    obj->checkpoint_cap = 0;
+    if (obj->unit_index) {
+        striter_unit_index_free(obj->unit_index);
+        obj->unit_index = NULL;
+    }
+    striter_decode_window_free(&obj->window);
+}
+
+// Drop the object's string. Strings from str_iter_file() live inside an
+// mmap region, which is unmapped instead of freed.
+static void striter_string_iterator_release_str(striter_string_iterator_obj *obj)
+{
+    if (obj->mapping) {
+        striter_file_unmap(obj->mapping, obj->mapping_len);
+        obj->mapping = NULL;
+        obj->mapping_len = 0;
+    } else if (obj->str) {
+        zend_string_release(obj->str);
+    }
+    obj->str = NULL;
+}
+
+static void striter_cursor_advance(striter_string_iterator_obj *obj, size_t *pos, size_t *unit_len, size_t *index);
+
+// Byte length of the chunk ending at end. Chunks are counted from the
+// start of the string, so the scan is extended to end and the chunks are
+// walked forward from the nearest checkpoint before it. Units of a string
+// in another encoding are found the same way, as only UTF-8 can be
+// segmented backwards, and so are units with no restart point close
+// enough before them.
+static size_t striter_chunk_length_before(striter_string_iterator_obj *obj, size_t end)
+{
+    size_t len = ZSTR_LEN(obj->str);
+    size_t start = 0;
+    
+    if (obj->mode == STRITER_MODE_BYTE) {
+        size_t step = obj->chunk ? obj->chunk : obj->chunk_bytes;
+        return end == len ? len - (len - 1) / step * step : step;
+    }
+    
+    while (obj->scan_pos < end) {
+        size_t scan_pos = obj->scan_pos;
+        size_t scan_index = obj->scan_index;
+        size_t unit_len = 0;
+        striter_cursor_advance(obj, &scan_pos, &unit_len, &scan_index);
+    }
+    if (obj->checkpoint_count > 0) {
+        size_t lo = 0, hi = obj->checkpoint_count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (obj->checkpoints[mid] < end) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        start = lo > 0 ? obj->checkpoints[lo - 1] : 0;
+    }
+    
+    for (;;) {
+        size_t chunk = striter_unit_length(obj, start);
+        if (start + chunk >= end) {
+            return end - start;
+        }
+        start += chunk;
+    }
+}
+
+// Byte length of the unit ending at end. Segmenting backwards restarts
+// from the scan high-water mark or the nearest checkpoint before end when
+// those are closer than the mode's own restart point. Without either in
+// reach, the scan is extended to end once, after which every step back
+// starts from a checkpoint.
+static size_t striter_unit_length_before(striter_string_iterator_obj *obj, size_t end)
+{
+    size_t known = 0;
+    size_t unit_len;
+    
+    if (obj->chunk || obj->chunk_bytes || obj->encoding) {
+        return striter_chunk_length_before(obj, end);
+    }
+    if (obj->scan_pos < end) {
+        known = obj->scan_pos;
+    } else if (obj->checkpoint_count > 0) {
+        size_t lo = 0, hi = obj->checkpoint_count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (obj->checkpoints[mid] < end) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        known = lo > 0 ? obj->checkpoints[lo - 1] : 0;
+    }
+    
+    unit_len = striter_unit_length_before_at(ZSTR_VAL(obj->str), ZSTR_LEN(obj->str), end, known, obj->mode, &obj->valid_run);
+    return unit_len ? unit_len : striter_chunk_length_before(obj, end);
+}
+
+// Move a cursor to the unit before pos (from the end of the string, the
+// last unit); *unit_len is set to its length. Returns false at the start.
+static bool striter_cursor_retreat(striter_string_iterator_obj *obj, size_t *pos, size_t *unit_len)
+{
+    if (*pos == 0) {
+        return 0;
+    }
+    *unit_len = striter_unit_length_before(obj, *pos);
+    *pos -= *unit_len;
+    return 1;
+}
+
+// Length of unit index from the unit index, or 0 if it does not reach it
+static zend_always_inline size_t striter_indexed_length(striter_string_iterator_obj *obj, size_t index)
+{
+    return obj->unit_index && index < obj->unit_index->count ? striter_unit_index_length(obj->unit_index, index) : 0;
+}
+
+// Put the object's cursor on the first unit
+static void striter_object_first(striter_string_iterator_obj *obj)
+{
+    obj->position = 0;
+    obj->unit_len = striter_indexed_length(obj, 0);
+    obj->char_index = 0;
+    obj->index_from_end = 0;
+}
+
+// Put the object's cursor on the last unit without counting: its index is
+// kept relative to the end until the count is needed
+static void striter_object_last(striter_string_iterator_obj *obj)
+{
+    obj->position = ZSTR_LEN(obj->str);
+    obj->unit_len = 0;
+    obj->char_index = 0;
+    obj->index_from_end = 1;
+    if (striter_cursor_retreat(obj, &obj->position, &obj->unit_len)) {
+        obj->char_index = 1;
+    }
+}
+
+// Point a freshly created object at str. Nothing is scanned here: the unit
+// count is computed on first use by striter_string_iterator_count().
+void striter_string_iterator_setup(striter_string_iterator_obj *obj, zend_string *str, striter_mode_t mode, const striter_options *opts)
+{
+    striter_string_iterator_release_index(obj);
+    striter_string_iterator_release_str(obj);
+    obj->str = zend_string_copy(str);
+    obj->position = 0;
+    obj->unit_len = 0;
+    obj->valid_run.start = obj->valid_run.end = 0;
+    obj->char_index = 0;
+    obj->index_from_end = 0;
+    obj->reverse = opts->reverse;
+    obj->total_chars = 0;
+    obj->count_known = 0;
+    obj->scan_pos = 0;
+    obj->scan_index = 0;
+    obj->mode = mode;
+    obj->substitute = opts->substitute && mode != STRITER_MODE_BYTE;
+    obj->offsets = opts->offsets;
+    obj->index_interval = (size_t)STRITER_G(index_interval);
+    obj->chunk = opts->chunk;
+    obj->chunk_bytes = opts->chunk_bytes;
+    obj->normalize = mode != STRITER_MODE_BYTE ? opts->normalize : STRITER_NORM_NONE;
+    obj->encoding = mode != STRITER_MODE_BYTE ? opts->encoding : STRITER_ENCODING_UTF8;
+    if (opts->indexed && mode != STRITER_MODE_BYTE) {
+        obj->unit_index = striter_unit_index_create();
+    }
+    striter_cache_lookup(obj);
+    if (obj->reverse) {
+        striter_object_last(obj);
+    }
+}
+
+static bool striter_locate(striter_string_iterator_obj *obj, size_t index, size_t *pos, size_t *unit_len);
+
+// Total number of units, computed once and cached. The scan resumes from
+// the furthest boundary any cursor has already reached.
+size_t striter_string_iterator_count(striter_string_iterator_obj *obj)
+{
+    if (!obj->count_known && (obj->unit_index || obj->encoding || (obj->chunk_bytes && obj->mode != STRITER_MODE_BYTE))) {
+        // Walk the rest of the string to record every unit, to find chunks
+        // whose unit count depends on their sizes, or to segment a string
+        // the counting kernels cannot read
+        striter_locate(obj, SIZE_MAX, NULL, NULL);
+    }
+    if (!obj->count_known) {
+        if (obj->str) {
+            const char *rest = ZSTR_VAL(obj->str) + obj->scan_pos;
+            size_t rest_len = ZSTR_LEN(obj->str) - obj->scan_pos;
+            int threads = striter_parallel_threads(rest_len, obj->mode);
+            size_t units = threads > 1
+                ? striter_parallel_count(rest, rest_len, obj->mode, threads)
+                : striter_count_units(rest, rest_len, obj->mode);
+            size_t step = obj->chunk ? obj->chunk : obj->chunk_bytes ? obj->chunk_bytes : 1;
+            
+            obj->total_chars = obj->scan_index + (units + step - 1) / step;
+        }
+        obj->count_known = 1;
+    }
+    return obj->total_chars;
+}
+
 // Object destructor
 static void striter_string_iterator_free_object(zend_object *object)
 {
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(object);
     
-    if (obj->str) {
-        zend_string_release(obj->str);
-    }
+    striter_string_iterator_release_index(obj);
+    striter_string_iterator_release_str(obj);
     
     zend_object_std_dtor(&obj->std);
 }
@@ -44,7 +283,428 @@ static void striter_string_iterator_free_object(zend_object *object)
 static zend_result striter_string_iterator_count_elements(zend_object *object, zend_long *count)
 {
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(object);
-    *count = obj->total_chars;
+    *count = striter_string_iterator_count(obj);
+    return SUCCESS;
+}
+
+// The chunk at pos with its invalid sequences replaced by U+FFFD, as
+// they would be unit by unit
+static zend_string *striter_chunk_substitute(striter_string_iterator_obj *obj, size_t pos, size_t chunk_len)
+{
+    const char *str = ZSTR_VAL(obj->str);
+    size_t len = ZSTR_LEN(obj->str);
+    size_t end = pos + chunk_len;
+    size_t out_len = 0;
+    size_t advance;
+    
+    if (striter_utf8_validate(str + pos, chunk_len) >= chunk_len) {
+        return striter_unit_string(str + pos, chunk_len);
+    }
+    
+    // An invalid unit is at least one byte and becomes three
+    zend_string *result = zend_string_safe_alloc(chunk_len, 3, 0, 0);
+    while (pos < end) {
+        const unsigned char *unit = (const unsigned char *)str + pos;
+        size_t unit_len = striter_unit_length_at(str, len, pos, obj->mode, &obj->valid_run);
+        
+        if (unit[0] >= 0x80 && striter_utf8_decode(unit, unit_len, &advance) < 0) {
+            memcpy(ZSTR_VAL(result) + out_len, "\xEF\xBF\xBD", 3);
+            out_len += 3;
+        } else {
+            memcpy(ZSTR_VAL(result) + out_len, unit, unit_len);
+            out_len += unit_len;
+        }
+        pos += unit_len;
+    }
+    ZSTR_VAL(result)[out_len] = '\0';
+    ZSTR_LEN(result) = out_len;
+    return result;
+}
+
+// Cursor helpers shared by the Iterator methods and the foreach iterator.
+// A cursor is a byte offset plus the cached length of the unit found there,
+// so current() and next() never rescan the string from the beginning.
+static zend_string *striter_cursor_current(striter_string_iterator_obj *obj, size_t pos, size_t *unit_len)
+{
+    const unsigned char *unit = (const unsigned char *)ZSTR_VAL(obj->str) + pos;
+    size_t advance;
+    
+    if (*unit_len == 0) {
+        *unit_len = striter_unit_length(obj, pos);
+    }
+    
+    // A string in another encoding is transcoded unit by unit, with U+FFFD
+    // for invalid sequences as there are no UTF-8 bytes to copy
+    if (obj->encoding) {
+        zend_string *decoded = striter_decoded_string(obj, pos, *unit_len);
+        if (obj->normalize) {
+            zend_string *normalized = striter_normalize(ZSTR_VAL(decoded), ZSTR_LEN(decoded), obj->normalize, 0);
+            if (normalized != NULL) {
+                zend_string_release(decoded);
+                return normalized;
+            }
+        }
+        return decoded;
+    }
+    
+    // A unit already in the requested form, the usual case, is yielded as
+    // is below; a changed one comes back with invalid sequences handled
+    if (obj->normalize) {
+        zend_string *normalized = striter_normalize((const char *)unit, *unit_len, obj->normalize, obj->substitute);
+        if (normalized != NULL) {
+            return normalized;
+        }
+    }
+    
+    // Invalid sequences always form a unit of their own; in a chunk they
+    // are replaced one by one
+    if (obj->chunk || obj->chunk_bytes) {
+        if (obj->substitute) {
+            return striter_chunk_substitute(obj, pos, *unit_len);
+        }
+    } else if (obj->substitute && unit[0] >= 0x80 && striter_utf8_decode(unit, *unit_len, &advance) < 0) {
+        return striter_replacement_char;
+    }
+    
+    return striter_unit_string((const char *)unit, *unit_len);
+}
+
+// Sparse offset index for random access. checkpoints[j] is the byte offset
+// of unit (j + 1) * index_interval; unit 0 is always at offset 0. Entries
+// are appended as the scan high-water mark passes them, so the index is
+// built by the first walk over the string and costs nothing before that.
+static void striter_index_record(striter_string_iterator_obj *obj, size_t index, size_t pos)
+{
+    if (index % obj->index_interval != 0 || index / obj->index_interval != obj->checkpoint_count + 1) {
+        return;
+    }
+    if (obj->checkpoint_count == obj->checkpoint_cap) {
+        obj->checkpoint_cap = obj->checkpoint_cap ? obj->checkpoint_cap * 2 : 16;
+        obj->checkpoints = safe_erealloc(obj->checkpoints, obj->checkpoint_cap, sizeof(size_t), 0);
+    }
+    obj->checkpoints[obj->checkpoint_count++] = pos;
+}
+
+// Value yielded for the unit at pos: the unit itself, or with the offsets
+// option a [byteOffset, byteLength] pair that copies nothing from the string
+static void striter_cursor_value(striter_string_iterator_obj *obj, size_t pos, size_t *unit_len, zval *value)
+{
+    if (!obj->offsets) {
+        ZVAL_STR(value, striter_cursor_current(obj, pos, unit_len));
+        return;
+    }
+    
+    if (*unit_len == 0) {
+        *unit_len = striter_unit_length(obj, pos);
+    }
+    
+    array_init_size(value, 2);
+    zend_hash_real_init_packed(Z_ARRVAL_P(value));
+    ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(value)) {
+        ZEND_HASH_FILL_SET_LONG((zend_long)pos);
+        ZEND_HASH_FILL_NEXT();
+        ZEND_HASH_FILL_SET_LONG((zend_long)*unit_len);
+        ZEND_HASH_FILL_NEXT();
+    } ZEND_HASH_FILL_END();
+}
+
+static void striter_cursor_advance(striter_string_iterator_obj *obj, size_t *pos, size_t *unit_len, size_t *index)
+{
+    if (*unit_len == 0) {
+        *unit_len = striter_unit_length(obj, *pos);
+    }
+    *pos += *unit_len;
+    *unit_len = 0;
+    (*index)++;
+    
+    // Remember how far the string has been segmented so a later count()
+    // only has to scan the rest
+    if (*pos > obj->scan_pos) {
+        if (obj->unit_index) {
+            striter_unit_index_append(obj->unit_index, *pos - obj->scan_pos);
+        }
+        obj->scan_pos = *pos;
+        obj->scan_index = *index;
+        striter_index_record(obj, *index, *pos);
+        if (*pos >= ZSTR_LEN(obj->str)) {
+            if (!obj->count_known) {
+                obj->total_chars = *index;
+                obj->count_known = 1;
+            }
+            if (obj->unit_index) {
+                striter_unit_index_shrink(obj->unit_index);
+            }
+        }
+    } else {
+        // Behind the scan, the unit index already knows the next unit
+        *unit_len = striter_indexed_length(obj, *index);
+    }
+}
+
+// Move the object's cursor one unit towards the end of the string
+static void striter_object_forward(striter_string_iterator_obj *obj)
+{
+    if (!obj->index_from_end) {
+        striter_cursor_advance(obj, &obj->position, &obj->unit_len, &obj->char_index);
+        return;
+    }
+    if (obj->unit_len == 0) {
+        obj->unit_len = striter_unit_length(obj, obj->position);
+    }
+    obj->position += obj->unit_len;
+    obj->unit_len = 0;
+    obj->char_index--;
+}
+
+// Move the object's cursor one unit towards the start. Moving off the
+// first unit leaves the cursor invalid, like moving past the last one.
+static void striter_object_backward(striter_string_iterator_obj *obj)
+{
+    if (!obj->index_from_end && obj->char_index > 0 && obj->unit_index && obj->char_index - 1 < obj->unit_index->count) {
+        obj->unit_len = striter_unit_index_length(obj->unit_index, obj->char_index - 1);
+        obj->position -= obj->unit_len;
+        obj->char_index--;
+        return;
+    }
+    if (!striter_cursor_retreat(obj, &obj->position, &obj->unit_len)) {
+        obj->position = ZSTR_LEN(obj->str);
+        obj->unit_len = 0;
+    }
+    if (obj->index_from_end) {
+        obj->char_index++;
+    } else {
+        obj->char_index--;
+    }
+}
+
+// Index of the object's cursor in iteration order. An index kept relative
+// to the end (or a forward index in a reverse iterator) needs the count.
+static zend_long striter_object_key(striter_string_iterator_obj *obj)
+{
+    if (obj->index_from_end) {
+        return obj->reverse
+            ? (zend_long)obj->char_index - 1
+            : (zend_long)striter_string_iterator_count(obj) - (zend_long)obj->char_index;
+    }
+    return obj->reverse
+        ? (zend_long)striter_string_iterator_count(obj) - 1 - (zend_long)obj->char_index
+        : (zend_long)obj->char_index;
+}
+
+// Whether an array of n elements can be created; throws if not. Packed
+// fills do no bounds checks, so arrays are sized only after this.
+static bool striter_array_fits(size_t n)
+{
+    if (n >= HT_MAX_SIZE) {
+        zend_throw_error(NULL, "Cannot create an array of %zu elements, the maximum is %zu", n, (size_t)HT_MAX_SIZE - 1);
+        return 0;
+    }
+    return 1;
+}
+
+// Materialize the units of obj into a packed array, from the last unit to
+// the first. Each step back costs about one unit, as for the cursor.
+static void striter_string_iterator_to_array_reverse(striter_string_iterator_obj *obj, zval *return_value)
+{
+    size_t pos = ZSTR_LEN(obj->str);
+    size_t unit_len;
+    
+    // Without a count the array grows as it is filled, which zend_hash
+    // bounds itself
+    if (obj->count_known && !striter_array_fits(obj->total_chars)) {
+        return;
+    }
+    array_init_size(return_value, obj->count_known ? (uint32_t)obj->total_chars : 0);
+    zend_hash_real_init_packed(Z_ARRVAL_P(return_value));
+    
+    while (striter_cursor_retreat(obj, &pos, &unit_len)) {
+        zval value;
+        striter_cursor_value(obj, pos, &unit_len, &value);
+        zend_hash_next_index_insert_new(Z_ARRVAL_P(return_value), &value);
+    }
+}
+
+// Value of the element of chunk units starting at *pos; *pos is moved past
+// them
+static void striter_array_element(striter_string_iterator_obj *obj, size_t *pos, size_t chunk, zval *value)
+{
+    size_t len = ZSTR_LEN(obj->str);
+    size_t start = *pos;
+    size_t unit_len = 0;
+    
+    if (chunk == 1) {
+        striter_cursor_value(obj, start, &unit_len, value);
+        *pos += unit_len;
+        return;
+    }
+    for (size_t i = 0; i < chunk && *pos < len; i++) {
+        *pos += striter_unit_length(obj, *pos);
+    }
+    ZVAL_STR(value, obj->encoding
+        ? striter_decoded_string(obj, start, *pos - start)
+        : striter_unit_string(ZSTR_VAL(obj->str) + start, *pos - start));
+}
+
+// Materialize the units of obj into a packed array, chunk units per element,
+// in the same pass that segments them. With a known count the array is
+// sized up front and filled in place. The count may be out of date (a
+// cached count, or striter.grapheme_engine changed since), so the fill
+// stops at the allocated size and anything past it is appended with
+// bounds checks; without a count the array grows as it is filled.
+void striter_string_iterator_to_array(striter_string_iterator_obj *obj, size_t chunk, zval *return_value)
+{
+    if (!obj->str || ZSTR_LEN(obj->str) == 0) {
+        RETURN_EMPTY_ARRAY();
+    }
+    if (obj->reverse) {
+        striter_string_iterator_to_array_reverse(obj, return_value);
+        return;
+    }
+    
+    size_t len = ZSTR_LEN(obj->str);
+    size_t allocated = 0;
+    size_t filled = 0;
+    size_t pos = 0;
+    zval value;
+    
+    if (obj->count_known) {
+        allocated = obj->total_chars / chunk + (obj->total_chars % chunk != 0);
+        if (!striter_array_fits(allocated)) {
+            return;
+        }
+    }
+    array_init_size(return_value, (uint32_t)allocated);
+    zend_hash_real_init_packed(Z_ARRVAL_P(return_value));
+    
+    ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(return_value)) {
+        while (pos < len && filled < allocated) {
+            striter_array_element(obj, &pos, chunk, &value);
+            ZEND_HASH_FILL_ADD(&value);
+            filled++;
+        }
+    } ZEND_HASH_FILL_END();
+    
+    while (pos < len) {
+        striter_array_element(obj, &pos, chunk, &value);
+        zend_hash_next_index_insert_new(Z_ARRVAL_P(return_value), &value);
+    }
+}
+
+// Byte offset of unit index. Returns false if the string has fewer units.
+// The scan is extended up to index first if no cursor got that far, after
+// which a lookup costs at most index_interval unit steps, or with a unit
+// index STRITER_UNIT_BLOCK additions. If unit_len is not NULL, it is set
+// to the length of the unit if that is known on the way, to 0 otherwise.
+static bool striter_locate(striter_string_iterator_obj *obj, size_t index, size_t *pos, size_t *unit_len)
+{
+    size_t len = ZSTR_LEN(obj->str);
+    
+    if (unit_len) {
+        *unit_len = 0;
+    }
+    if (obj->mode == STRITER_MODE_BYTE) {
+        size_t step = obj->chunk ? obj->chunk : obj->chunk_bytes ? obj->chunk_bytes : 1;
+        if (index >= (len + step - 1) / step) {
+            return 0;
+        }
+        if (pos) {
+            *pos = index * step;
+        }
+        return 1;
+    }
+    
+    // A long way to go: index the whole rest of the string on the pool,
+    // unless every unit has to be recorded on the way, the checkpoints
+    // are of chunks or the string is not UTF-8
+    if (obj->scan_index < index && obj->scan_pos < len && !obj->unit_index && !obj->chunk && !obj->chunk_bytes
+            && !obj->encoding) {
+        int threads = striter_parallel_threads(len - obj->scan_pos, obj->mode);
+        if (threads > 1) {
+            striter_parallel_index(obj, threads);
+        }
+    }
+    while (obj->scan_index < index && obj->scan_pos < len) {
+        size_t scan_pos = obj->scan_pos;
+        size_t scan_index = obj->scan_index;
+        size_t unit_len = 0;
+        striter_cursor_advance(obj, &scan_pos, &unit_len, &scan_index);
+    }
+    if (index > obj->scan_index || (index == obj->scan_index && obj->scan_pos >= len)) {
+        return 0;
+    }
+    if (obj->unit_index && index < obj->unit_index->count) {
+        *pos = striter_unit_index_offset(obj->unit_index, index, unit_len);
+        return 1;
+    }
+    if (index == obj->scan_index) {
+        *pos = obj->scan_pos;
+        return 1;
+    }
+    
+    // Walk forward from the nearest checkpoint at or before index
+    size_t checkpoint = index / obj->index_interval;
+    size_t current = checkpoint * obj->index_interval;
+    size_t offset = checkpoint == 0 ? 0 : obj->checkpoints[checkpoint - 1];
+    while (current < index) {
+        offset += striter_unit_length(obj, offset);
+        current++;
+    }
+    *pos = offset;
+    return 1;
+}
+
+// Byte offset of the unit k places from the end (k >= 1, the last unit
+// being 1). Returns false if the string has fewer units. Without an index
+// reaching that far, the units are segmented backwards from the end, so
+// the cost depends on k and not on the length of the string.
+static bool striter_locate_from_end(striter_string_iterator_obj *obj, size_t k, size_t *pos, size_t *unit_len)
+{
+    if (obj->count_known) {
+        if (k > obj->total_chars) {
+            return 0;
+        }
+        if (obj->scan_index >= obj->total_chars - k || obj->mode == STRITER_MODE_BYTE) {
+            return striter_locate(obj, obj->total_chars - k, pos, unit_len);
+        }
+    }
+    
+    *pos = ZSTR_LEN(obj->str);
+    while (k-- > 0) {
+        if (!striter_cursor_retreat(obj, pos, unit_len)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Resolve an ArrayAccess offset to the byte offset of its unit. Negative
+// offsets count from the end, like string offsets; in a reverse iterator
+// offsets follow the iteration order, so 0 is the last unit. Returns
+// FAILURE with a TypeError for non-integer offsets; *found is false for
+// offsets past either end. *unit_len is set as by striter_locate().
+static zend_result striter_offset_locate(striter_string_iterator_obj *obj, zval *offset, size_t *pos, size_t *unit_len, bool *found)
+{
+    zend_long value;
+    
+    if (Z_TYPE_P(offset) == IS_LONG) {
+        value = Z_LVAL_P(offset);
+    } else {
+        zend_type_error("Cannot access offset of type %s on _StrIterIterator", zend_zval_type_name(offset));
+        return FAILURE;
+    }
+    
+    *found = 0;
+    if (!obj->str) {
+        return SUCCESS;
+    }
+    if (obj->reverse) {
+        value = -1 - value;
+    }
+    if (value < 0) {
+        *found = striter_locate_from_end(obj, (size_t)-(value + 1) + 1, pos, unit_len);
+    } else {
+        *found = striter_locate(obj, (size_t)value, pos, unit_len);
+    }
     return SUCCESS;
 }
 
@@ -60,7 +720,18 @@ static void striter_iterator_dtor(zend_object_iterator *iter)
 
 static void striter_iterator_rewind(zend_object_iterator *iter)
 {
-    ((striter_iterator*)iter)->current_pos = 0;
+    striter_iterator *iterator = (striter_iterator*)iter;
+    striter_string_iterator_obj *object = striter_string_iterator_from_obj(Z_OBJ(iter->data));
+    
+    iterator->current_pos = 0;
+    iterator->byte_pos = 0;
+    iterator->unit_len = 0;
+    
+    // A reverse iterator starts on the last unit; keys count from there
+    if (object->reverse && object->str) {
+        iterator->byte_pos = ZSTR_LEN(object->str);
+        striter_cursor_retreat(object, &iterator->byte_pos, &iterator->unit_len);
+    }
 }
 
 static zend_result striter_iterator_valid(zend_object_iterator *iter)
@@ -68,7 +739,7 @@ static zend_result striter_iterator_valid(zend_object_iterator *iter)
     striter_iterator *iterator = (striter_iterator*)iter;
     striter_string_iterator_obj *object = striter_string_iterator_from_obj(Z_OBJ(iter->data));
 
-    if (iterator->current_pos < object->total_chars) {
+    if (object->str && iterator->byte_pos < ZSTR_LEN(object->str)) {
         return SUCCESS;
     }
     return FAILURE;
@@ -79,58 +750,16 @@ static zval *striter_iterator_get_current(zend_object_iterator *iter)
     striter_iterator *iterator = (striter_iterator*)iter;
     striter_string_iterator_obj *object = striter_string_iterator_from_obj(Z_OBJ(iter->data));
 
-    if (iterator->current_pos >= object->total_chars) {
+    if (!object->str || iterator->byte_pos >= ZSTR_LEN(object->str)) {
         return &EG(uninitialized_zval);
     }
 
-    size_t byte_pos;
-    zend_string *char_str = NULL;
-    
-    // Mode-dependent character extraction
-    if (object->mode == STRITER_MODE_GRAPHEME) {
-#ifdef HAVE_PCRE2
-        char_str = striter_get_grapheme_at_position(
-            ZSTR_VAL(object->str), 
-            ZSTR_LEN(object->str), 
-            iterator->current_pos, 
-            &byte_pos
-        );
-#endif
-        // Fallback to codepoint mode if PCRE2 not available or fails
-        if (char_str == NULL) {
-            char_str = striter_get_char_at_position(
-                ZSTR_VAL(object->str), 
-                ZSTR_LEN(object->str), 
-                iterator->current_pos, 
-                &byte_pos
-            );
-        }
-    } else if (object->mode == STRITER_MODE_CODEPOINT) {
-        char_str = striter_get_char_at_position(
-            ZSTR_VAL(object->str), 
-            ZSTR_LEN(object->str), 
-            iterator->current_pos, 
-            &byte_pos
-        );
-    } else if (object->mode == STRITER_MODE_BYTE) {
-        char_str = striter_get_byte_at_position(
-            ZSTR_VAL(object->str), 
-            ZSTR_LEN(object->str), 
-            iterator->current_pos
-        );
-    }
-
-    if (char_str) {
-        // Store the current value in the iterator structure
-        striter_iterator *iterator = (striter_iterator*)iter;
-        if (Z_TYPE(iterator->current_value) != IS_UNDEF) {
-            zval_ptr_dtor(&iterator->current_value);
-        }
-        ZVAL_STR(&iterator->current_value, char_str);
-        return &iterator->current_value;
-    } else {
-        return &EG(uninitialized_zval);
+    // Store the current value in the iterator structure
+    if (Z_TYPE(iterator->current_value) != IS_UNDEF) {
+        zval_ptr_dtor(&iterator->current_value);
     }
+    striter_cursor_value(object, iterator->byte_pos, &iterator->unit_len, &iterator->current_value);
+    return &iterator->current_value;
 }
 
 static void striter_iterator_get_key(zend_object_iterator *iter, zval *key)
@@ -141,7 +770,20 @@ static void striter_iterator_get_key(zend_object_iterator *iter, zval *key)
 
 static void striter_iterator_move_forward(zend_object_iterator *iter)
 {
-    ((striter_iterator*)iter)->current_pos++;
+    striter_iterator *iterator = (striter_iterator*)iter;
+    striter_string_iterator_obj *object = striter_string_iterator_from_obj(Z_OBJ(iter->data));
+
+    if (!object->str || iterator->byte_pos >= ZSTR_LEN(object->str)) {
+        return;
+    }
+    if (!object->reverse) {
+        striter_cursor_advance(object, &iterator->byte_pos, &iterator->unit_len, &iterator->current_pos);
+        return;
+    }
+    if (!striter_cursor_retreat(object, &iterator->byte_pos, &iterator->unit_len)) {
+        iterator->byte_pos = ZSTR_LEN(object->str);
+    }
+    iterator->current_pos++;
 }
 
 // Iterator function table
@@ -170,8 +812,8 @@ static zend_object_iterator *striter_string_iterator_get_iterator(zend_class_ent
 
     ZVAL_OBJ_COPY(&iterator->intern.data, Z_OBJ_P(object));
     iterator->intern.funcs = &striter_iterator_funcs;
-    iterator->current_pos = 0;
     ZVAL_UNDEF(&iterator->current_value);
+    striter_iterator_rewind(&iterator->intern);
 
     return &iterator->intern;
 }
@@ -181,41 +823,26 @@ PHP_METHOD(_StrIterIterator, __construct)
 {
     zend_string *str;
     zend_string *mode = NULL;
+    HashTable *options = NULL;
     
-    ZEND_PARSE_PARAMETERS_START(1, 2)
+    ZEND_PARSE_PARAMETERS_START(1, 3)
         Z_PARAM_STR(str)
         Z_PARAM_OPTIONAL
         Z_PARAM_STR_OR_NULL(mode)
+        Z_PARAM_ARRAY_HT(options)
     ZEND_PARSE_PARAMETERS_END();
     
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
     
-    // Parse mode parameter
-    striter_mode_t iter_mode = STRITER_MODE_GRAPHEME; // Default
-    if (mode != NULL) {
-        iter_mode = striter_parse_mode(ZSTR_VAL(mode));
+    // Parse mode and options
+    striter_mode_t iter_mode;
+    striter_options opts;
+    if (striter_parse_arguments(str, mode, options, &iter_mode, &opts) == FAILURE) {
+        RETURN_THROWS();
     }
     
-    // Initialize the iterator
-    obj->str = zend_string_copy(str);
-    obj->position = 0;
-    obj->char_index = 0;
-    obj->mode = iter_mode;
-    
-    // Calculate total character count based on mode
-    if (iter_mode == STRITER_MODE_GRAPHEME) {
-#ifdef HAVE_PCRE2
-        obj->total_chars = striter_count_graphemes_pcre2(ZSTR_VAL(str), ZSTR_LEN(str));
-#else
-        // Fallback to codepoint mode if PCRE2 not available
-        obj->total_chars = striter_count_utf8_chars(ZSTR_VAL(str), ZSTR_LEN(str));
-        obj->mode = STRITER_MODE_CODEPOINT;
-#endif
-    } else if (iter_mode == STRITER_MODE_CODEPOINT) {
-        obj->total_chars = striter_count_utf8_chars(ZSTR_VAL(str), ZSTR_LEN(str));
-    } else if (iter_mode == STRITER_MODE_BYTE) {
-        obj->total_chars = striter_count_bytes(ZSTR_VAL(str), ZSTR_LEN(str));
-    }
+    // Initialize the iterator; units are counted lazily on first use
+    striter_string_iterator_setup(obj, str, iter_mode, &opts);
 }
 
 
@@ -226,52 +853,25 @@ PHP_METHOD(_StrIterIterator, current)
     
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
     
-    if (!obj->str || obj->char_index >= obj->total_chars) {
+    if (!obj->str || obj->position >= ZSTR_LEN(obj->str)) {
         RETURN_NULL();
     }
     
-    size_t byte_pos;
-    zend_string *char_str = NULL;
+    striter_cursor_value(obj, obj->position, &obj->unit_len, return_value);
+}
+
+// _StrIterIterator::currentOffset method
+PHP_METHOD(_StrIterIterator, currentOffset)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
     
-    // Mode-dependent character extraction
-    if (obj->mode == STRITER_MODE_GRAPHEME) {
-#ifdef HAVE_PCRE2
-        char_str = striter_get_grapheme_at_position(
-            ZSTR_VAL(obj->str), 
-            ZSTR_LEN(obj->str), 
-            obj->char_index, 
-            &byte_pos
-        );
-#endif
-        // Fallback to codepoint mode if PCRE2 not available or fails
-        if (char_str == NULL) {
-            char_str = striter_get_char_at_position(
-                ZSTR_VAL(obj->str), 
-                ZSTR_LEN(obj->str), 
-                obj->char_index, 
-                &byte_pos
-            );
-        }
-    } else if (obj->mode == STRITER_MODE_CODEPOINT) {
-        char_str = striter_get_char_at_position(
-            ZSTR_VAL(obj->str), 
-            ZSTR_LEN(obj->str), 
-            obj->char_index, 
-            &byte_pos
-        );
-    } else if (obj->mode == STRITER_MODE_BYTE) {
-        char_str = striter_get_byte_at_position(
-            ZSTR_VAL(obj->str), 
-            ZSTR_LEN(obj->str), 
-            obj->char_index
-        );
-    }
-    
-    if (char_str) {
-        RETURN_STR(char_str);
-    } else {
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    
+    if (!obj->str || obj->position >= ZSTR_LEN(obj->str)) {
         RETURN_NULL();
     }
+    
+    RETURN_LONG((zend_long)obj->position);
 }
 
 // _StrIterIterator::key method
@@ -281,7 +881,7 @@ PHP_METHOD(_StrIterIterator, key)
     
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
     
-    RETURN_LONG(obj->char_index);
+    RETURN_LONG(striter_object_key(obj));
 }
 
 // _StrIterIterator::next method
@@ -291,12 +891,34 @@ PHP_METHOD(_StrIterIterator, next)
     
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
     
-    if (!obj->str || obj->char_index >= obj->total_chars) {
+    if (!obj->str || obj->position >= ZSTR_LEN(obj->str)) {
         return;
     }
     
     // Advance to next character
-    obj->char_index++;
+    if (obj->reverse) {
+        striter_object_backward(obj);
+    } else {
+        striter_object_forward(obj);
+    }
+}
+
+// _StrIterIterator::prev method
+PHP_METHOD(_StrIterIterator, prev)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+    
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    
+    if (!obj->str || obj->position >= ZSTR_LEN(obj->str)) {
+        return;
+    }
+    
+    if (obj->reverse) {
+        striter_object_forward(obj);
+    } else {
+        striter_object_backward(obj);
+    }
 }
 
 // _StrIterIterator::rewind method
@@ -306,8 +928,31 @@ PHP_METHOD(_StrIterIterator, rewind)
     
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
     
-    obj->position = 0;
-    obj->char_index = 0;
+    if (!obj->str) {
+        return;
+    }
+    if (obj->reverse) {
+        striter_object_last(obj);
+    } else {
+        striter_object_first(obj);
+    }
+}
+
+// _StrIterIterator::end method
+PHP_METHOD(_StrIterIterator, end)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+    
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    
+    if (!obj->str) {
+        return;
+    }
+    if (obj->reverse) {
+        striter_object_first(obj);
+    } else {
+        striter_object_last(obj);
+    }
 }
 
 // _StrIterIterator::valid method
@@ -317,7 +962,7 @@ PHP_METHOD(_StrIterIterator, valid)
     
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
     
-    RETURN_BOOL(obj->str && obj->char_index < obj->total_chars);
+    RETURN_BOOL(obj->str && obj->position < ZSTR_LEN(obj->str));
 }
 
 // _StrIterIterator::getIterator method  
@@ -336,19 +981,151 @@ PHP_METHOD(_StrIterIterator, count)
     
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
     
-    RETURN_LONG(obj->total_chars);
+    RETURN_LONG(striter_string_iterator_count(obj));
+}
+
+// _StrIterIterator::toArray method
+PHP_METHOD(_StrIterIterator, toArray)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+    
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    
+    striter_string_iterator_to_array(obj, 1, return_value);
+}
+
+// _StrIterIterator::indexSize method: bytes held by the object's boundary
+// indexes, checkpoints and unit index. Checkpoints shared with the
+// segmentation cache are not counted.
+PHP_METHOD(_StrIterIterator, indexSize)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+    
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    size_t size = obj->cache_entry ? 0 : obj->checkpoint_cap * sizeof(size_t);
+    
+    if (obj->unit_index) {
+        size += striter_unit_index_size(obj->unit_index);
+    }
+    RETURN_LONG((zend_long)size);
+}
+
+// _StrIterIterator::seek method
+PHP_METHOD(_StrIterIterator, seek)
+{
+    zend_long offset;
+    size_t pos, unit_len;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_LONG(offset)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    
+    // A reverse iterator seeks in iteration order, from the last unit
+    if (offset < 0 || !obj->str || !(obj->reverse
+            ? striter_locate_from_end(obj, (size_t)offset + 1, &pos, &unit_len)
+            : striter_locate(obj, (size_t)offset, &pos, &unit_len))) {
+        zend_throw_exception_ex(spl_ce_OutOfBoundsException, 0, "Seek position " ZEND_LONG_FMT " is out of range", offset);
+        RETURN_THROWS();
+    }
+    
+    obj->position = pos;
+    obj->unit_len = unit_len;
+    obj->char_index = obj->reverse ? (size_t)offset + 1 : (size_t)offset;
+    obj->index_from_end = obj->reverse;
+}
+
+// _StrIterIterator::offsetExists method
+PHP_METHOD(_StrIterIterator, offsetExists)
+{
+    zval *offset;
+    size_t pos, unit_len;
+    bool found;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ZVAL(offset)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    
+    if (striter_offset_locate(obj, offset, &pos, &unit_len, &found) == FAILURE) {
+        RETURN_THROWS();
+    }
+    
+    RETURN_BOOL(found);
+}
+
+// _StrIterIterator::offsetGet method
+PHP_METHOD(_StrIterIterator, offsetGet)
+{
+    zval *offset;
+    size_t pos;
+    size_t unit_len;
+    bool found;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ZVAL(offset)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(ZEND_THIS));
+    
+    if (striter_offset_locate(obj, offset, &pos, &unit_len, &found) == FAILURE) {
+        RETURN_THROWS();
+    }
+    if (!found) {
+        zend_throw_exception_ex(spl_ce_OutOfBoundsException, 0, "Offset " ZEND_LONG_FMT " is out of range", Z_LVAL_P(offset));
+        RETURN_THROWS();
+    }
+    
+    striter_cursor_value(obj, pos, &unit_len, return_value);
+}
+
+// _StrIterIterator::offsetSet method
+PHP_METHOD(_StrIterIterator, offsetSet)
+{
+    zval *offset, *value;
+    
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+        Z_PARAM_ZVAL(offset)
+        Z_PARAM_ZVAL(value)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    zend_throw_error(NULL, "Cannot modify _StrIterIterator");
+}
+
+// _StrIterIterator::offsetUnset method
+PHP_METHOD(_StrIterIterator, offsetUnset)
+{
+    zval *offset;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+        Z_PARAM_ZVAL(offset)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    zend_throw_error(NULL, "Cannot modify _StrIterIterator");
 }
 
 // Method entries for _StrIterIterator class
 static const zend_function_entry striter_string_iterator_methods[] = {
     PHP_ME(_StrIterIterator, __construct, arginfo_striteriterator_construct, ZEND_ACC_PUBLIC)
     PHP_ME(_StrIterIterator, current, arginfo_striteriterator_current, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, currentOffset, arginfo_striteriterator_currentoffset, ZEND_ACC_PUBLIC)
     PHP_ME(_StrIterIterator, key, arginfo_striteriterator_key, ZEND_ACC_PUBLIC)
     PHP_ME(_StrIterIterator, next, arginfo_striteriterator_next, ZEND_ACC_PUBLIC)
     PHP_ME(_StrIterIterator, rewind, arginfo_striteriterator_rewind, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, prev, arginfo_striteriterator_prev, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, end, arginfo_striteriterator_end, ZEND_ACC_PUBLIC)
     PHP_ME(_StrIterIterator, valid, arginfo_striteriterator_valid, ZEND_ACC_PUBLIC)
     PHP_ME(_StrIterIterator, getIterator, arginfo_striteriterator_getiterator, ZEND_ACC_PUBLIC)
     PHP_ME(_StrIterIterator, count, arginfo_striteriterator_count, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, toArray, arginfo_striteriterator_toarray, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, indexSize, arginfo_striteriterator_indexsize, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, seek, arginfo_striteriterator_seek, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, offsetExists, arginfo_striteriterator_offsetexists, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, offsetGet, arginfo_striteriterator_offsetget, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, offsetSet, arginfo_striteriterator_offsetset, ZEND_ACC_PUBLIC)
+    PHP_ME(_StrIterIterator, offsetUnset, arginfo_striteriterator_offsetunset, ZEND_ACC_PUBLIC)
     PHP_FE_END
 };
 
@@ -369,6 +1146,9 @@ void striter_string_iterator_init(void)
     // Set get_iterator handler for IteratorAggregate
     striter_string_iterator_ce->get_iterator = striter_string_iterator_get_iterator;
     
-    // Implement IteratorAggregate and Countable interfaces
-    zend_class_implements(striter_string_iterator_ce, 2, zend_ce_aggregate, zend_ce_countable);
+    // Implement IteratorAggregate, Countable and ArrayAccess interfaces.
+    // seek() follows SeekableIterator, which cannot be declared: it extends
+    // Iterator, and a class may not implement both Iterator and
+    // IteratorAggregate.
+    zend_class_implements(striter_string_iterator_ce, 3, zend_ce_aggregate, zend_ce_countable, zend_ce_arrayaccess);
 }
\ No newline at end of file
@@ -7,25 +7,138 @@
 #include "ext/standard/info.h"
 #include "php_striter.h"
 
+ZEND_DECLARE_MODULE_GLOBALS(striter)
+
 // Global class entry
 zend_class_entry *striter_string_iterator_ce;
 
+zend_string *striter_replacement_char;
+
+// INI handler for striter.grapheme_engine
+static PHP_INI_MH(OnUpdateGraphemeEngine)
+{
+    striter_grapheme_engine_t engine;
+    
+    if (zend_string_equals_literal(new_value, "native")) {
+        engine = STRITER_ENGINE_NATIVE;
+#ifdef HAVE_PCRE2
+    } else if (zend_string_equals_literal(new_value, "pcre2")) {
+        engine = STRITER_ENGINE_PCRE2;
+#endif
+    } else {
+        php_error_docref(NULL, E_WARNING, "Unknown grapheme engine \"%s\"", ZSTR_VAL(new_value));
+        return FAILURE;
+    }
+    
+    STRITER_G(grapheme_engine) = engine;
+    return SUCCESS;
+}
+
+// INI handler for striter.simd
+static PHP_INI_MH(OnUpdateSimd)
+{
+    striter_simd_t level;
+    
+    if (zend_string_equals_literal(new_value, "auto") || zend_string_equals_literal(new_value, "avx2")) {
+        level = STRITER_SIMD_AVX2;
+    } else if (zend_string_equals_literal(new_value, "sse2")) {
+        level = STRITER_SIMD_SSE2;
+    } else if (zend_string_equals_literal(new_value, "scalar")) {
+        level = STRITER_SIMD_SCALAR;
+    } else {
+        php_error_docref(NULL, E_WARNING, "Unknown SIMD level \"%s\"", ZSTR_VAL(new_value));
+        return FAILURE;
+    }
+    
+    // Levels the CPU lacks fall back to the best available one
+    striter_simd_select(level);
+    return SUCCESS;
+}
+
+// INI handler for striter.index_interval
+static PHP_INI_MH(OnUpdateIndexInterval)
+{
+    zend_long interval = ZEND_STRTOL(ZSTR_VAL(new_value), NULL, 10);
+    
+    if (interval < 1 || interval > 65536) {
+        php_error_docref(NULL, E_WARNING, "striter.index_interval must be between 1 and 65536");
+        return FAILURE;
+    }
+    
+    STRITER_G(index_interval) = interval;
+    return SUCCESS;
+}
+
+// INI handler for striter.threads
+static PHP_INI_MH(OnUpdateThreads)
+{
+    zend_long threads = ZEND_STRTOL(ZSTR_VAL(new_value), NULL, 10);
+    
+    if (threads < 0 || threads > 64) {
+        php_error_docref(NULL, E_WARNING, "striter.threads must be between 0 and 64");
+        return FAILURE;
+    }
+    
+    STRITER_G(threads) = threads;
+    return SUCCESS;
+}
+
+// INI handler for striter.cache_size: bytes, with an optional K, M or G
+// suffix
+static PHP_INI_MH(OnUpdateCacheSize)
+{
+    char *end;
+    zend_long size = ZEND_STRTOL(ZSTR_VAL(new_value), &end, 10);
+    
+    switch (*end) {
+        case 'g': case 'G':
+            size *= 1024;
+            ZEND_FALLTHROUGH;
+        case 'm': case 'M':
+            size *= 1024;
+            ZEND_FALLTHROUGH;
+        case 'k': case 'K':
+            size *= 1024;
+            end++;
+            break;
+    }
+    if (size < 0 || *end != '\0') {
+        php_error_docref(NULL, E_WARNING, "striter.cache_size must be a byte count such as 0, 65536 or 4M");
+        return FAILURE;
+    }
+    
+    STRITER_G(cache_size) = size;
+    striter_cache_resize();
+    return SUCCESS;
+}
+
+PHP_INI_BEGIN()
+    PHP_INI_ENTRY("striter.grapheme_engine", "native", PHP_INI_ALL, OnUpdateGraphemeEngine)
+    PHP_INI_ENTRY("striter.simd", "auto", PHP_INI_ALL, OnUpdateSimd)
+    PHP_INI_ENTRY("striter.index_interval", "128", PHP_INI_ALL, OnUpdateIndexInterval)
+    PHP_INI_ENTRY("striter.threads", "0", PHP_INI_ALL, OnUpdateThreads)
+    PHP_INI_ENTRY("striter.cache_size", "0", PHP_INI_ALL, OnUpdateCacheSize)
+PHP_INI_END()
+
 // str_iter function implementation
 PHP_FUNCTION(str_iter)
 {
     zend_string *str;
     zend_string *mode = NULL;
+    HashTable *options = NULL;
     
-    ZEND_PARSE_PARAMETERS_START(1, 2)
+    ZEND_PARSE_PARAMETERS_START(1, 3)
         Z_PARAM_STR(str)
         Z_PARAM_OPTIONAL
         Z_PARAM_STR_OR_NULL(mode)
+        Z_PARAM_ARRAY_HT(options)
     ZEND_PARSE_PARAMETERS_END();
     
-    // Parse mode parameter
-    striter_mode_t iter_mode = STRITER_MODE_GRAPHEME; // Default
-    if (mode != NULL) {
-        iter_mode = striter_parse_mode(ZSTR_VAL(mode));
+    // Parse mode and options
+    striter_mode_t iter_mode;
+    striter_options opts;
+    if (striter_parse_arguments(str, mode, options, &iter_mode, &opts) == FAILURE) {
+        RETURN_THROWS();
     }
     
     // Create new StringIterator object
@@ -34,53 +147,312 @@ PHP_FUNCTION(str_iter)
     // Get the object structure
     striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(return_value));
     
-    // Initialize the iterator
-    obj->str = zend_string_copy(str);
-    obj->position = 0;
-    obj->char_index = 0;
-    obj->mode = iter_mode;
+    // Initialize the iterator; units are counted lazily on first use
+    striter_string_iterator_setup(obj, str, iter_mode, &opts);
+}
+
+// str_iter_reverse function implementation
+PHP_FUNCTION(str_iter_reverse)
+{
+    zend_string *str;
+    zend_string *mode = NULL;
+    HashTable *options = NULL;
     
-    // Calculate total character count based on mode
-    if (iter_mode == STRITER_MODE_GRAPHEME) {
-#ifdef HAVE_PCRE2
-        obj->total_chars = striter_count_graphemes_pcre2(ZSTR_VAL(str), ZSTR_LEN(str));
-#else
-        // Fallback to codepoint mode if PCRE2 not available
-        obj->total_chars = striter_count_utf8_chars(ZSTR_VAL(str), ZSTR_LEN(str));
-        obj->mode = STRITER_MODE_CODEPOINT;
-#endif
-    } else if (iter_mode == STRITER_MODE_CODEPOINT) {
-        obj->total_chars = striter_count_utf8_chars(ZSTR_VAL(str), ZSTR_LEN(str));
-    } else if (iter_mode == STRITER_MODE_BYTE) {
-        obj->total_chars = striter_count_bytes(ZSTR_VAL(str), ZSTR_LEN(str));
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_STR(str)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR_OR_NULL(mode)
+        Z_PARAM_ARRAY_HT(options)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_mode_t iter_mode;
+    striter_options opts;
+    if (striter_parse_arguments(str, mode, options, &iter_mode, &opts) == FAILURE) {
+        RETURN_THROWS();
     }
+    opts.reverse = 1;
+    
+    object_init_ex(return_value, striter_string_iterator_ce);
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(return_value));
+    
+    // The cursor starts on the last unit, found by segmenting backwards
+    striter_string_iterator_setup(obj, str, iter_mode, &opts);
+}
+
+// str_iter_chunks function implementation
+PHP_FUNCTION(str_iter_chunks)
+{
+    zend_string *str;
+    zend_long size;
+    zend_string *mode = NULL;
+    
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_STR(str)
+        Z_PARAM_LONG(size)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR_OR_NULL(mode)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    if (size < 1) {
+        zend_argument_value_error(2, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    
+    striter_mode_t iter_mode;
+    striter_options opts;
+    if (striter_parse_arguments(str, mode, NULL, &iter_mode, &opts) == FAILURE) {
+        RETURN_THROWS();
+    }
+    opts.chunk = (size_t)size;
+    
+    object_init_ex(return_value, striter_string_iterator_ce);
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(return_value));
+    
+    striter_string_iterator_setup(obj, str, iter_mode, &opts);
+}
+
+// Byte length of the UTF-8 character starting at pos
+size_t striter_utf8_char_length(const char *str, size_t len, size_t pos) {
+    size_t advance = 0;
+    zend_result status;
+    
+    php_next_utf8_char((unsigned char *)str + pos, len - pos, &advance, &status);
+    
+    // Status is ignored - all sequences are treated as characters
+    if (advance == 0) {
+        advance = 1; // Ensure we advance at least 1 byte
+    }
+    return advance;
+}
+
+// Byte length of the UTF-8 character ending at end, a character boundary,
+// as the forward decoder cut it. Decoders never swallow an ASCII or lead
+// byte, so the character starts at the last such byte among the four
+// before end if its sequence reaches end; otherwise the byte before end is
+// an invalid unit of its own.
+size_t striter_utf8_char_length_before(const char *str, size_t len, size_t end) {
+    const unsigned char *s = (const unsigned char *)str;
+    size_t min = end > 4 ? end - 4 : 0;
+    
+    for (size_t lead = end; lead > min; lead--) {
+        unsigned char c = s[lead - 1];
+        if (c < 0x80 || (c >= 0xC2 && c <= 0xF4)) {
+            return lead - 1 + striter_utf8_char_length(str, len, lead - 1) == end ? end - lead + 1 : 1;
+        }
+    }
+    return 1;
 }
 
 // Utility function to count UTF-8 characters
 size_t striter_count_utf8_chars(const char *str, size_t len) {
+    return striter_count_utf8_chars_with(str, len, STRITER_G(ascii_span));
+}
+
+// Same, with an explicit ASCII kernel, for threads without module globals
+size_t striter_count_utf8_chars_with(const char *str, size_t len, striter_ascii_span_func ascii_span) {
     if (str == NULL || len == 0) {
         return 0;
     }
     
+    const unsigned char *s = (const unsigned char *)str;
     size_t char_count = 0;
     size_t pos = 0;
     
     while (pos < len) {
-        size_t advance = 0;
-        zend_result status;
-        php_next_utf8_char((unsigned char *)str + pos, len - pos, &advance, &status);
-        
-        // Status is ignored - all sequences are treated as characters
-        if (advance == 0) {
-            advance = 1; // Ensure we advance at least 1 byte
+        // ASCII runs are one codepoint per byte; skip them a vector at a time
+        if (s[pos] < 0x80) {
+            size_t run = ascii_span(s + pos, len - pos);
+            char_count += run;
+            pos += run;
+            continue;
         }
-        pos += advance;
+        pos += striter_utf8_char_length(str, len, pos);
         char_count++;
     }
     
     return char_count;
 }
 
+// str_iter_split function implementation
+PHP_FUNCTION(str_iter_split)
+{
+    zend_string *str;
+    zend_string *mode = NULL;
+    zend_long chunk = 1;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_STR(str)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR(mode)
+        Z_PARAM_LONG(chunk)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    if (chunk < 1) {
+        zend_argument_value_error(3, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    
+    // A temporary iterator does the work, so the split goes through the
+    // same count, cache and array filling as toArray()
+    striter_options opts;
+    zval iterator;
+    memset(&opts, 0, sizeof(opts));
+    object_init_ex(&iterator, striter_string_iterator_ce);
+    striter_string_iterator_setup(striter_string_iterator_from_obj(Z_OBJ(iterator)), str,
+        mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME, &opts);
+    striter_string_iterator_to_array(striter_string_iterator_from_obj(Z_OBJ(iterator)), (size_t)chunk, return_value);
+    zval_ptr_dtor(&iterator);
+}
+
+// Byte offset n units after pos, or len if the string ends first. Only
+// the units skipped are segmented. *skipped, if not NULL, is set to their
+// number.
+static size_t striter_skip_units(const char *str, size_t len, size_t pos, size_t n, striter_mode_t mode, striter_utf8_run *valid_run, size_t *skipped)
+{
+    size_t i = 0;
+    
+    if (mode == STRITER_MODE_BYTE) {
+        i = MIN(n, len - pos);
+        pos += i;
+    } else {
+        while (i < n && pos < len) {
+            pos += striter_unit_length_at(str, len, pos, mode, valid_run);
+            i++;
+        }
+    }
+    if (skipped) {
+        *skipped = i;
+    }
+    return pos;
+}
+
+// Byte offset n units before end, or 0 if the string starts first,
+// segmenting backwards from end. Where there is no restart point to step
+// back to, the units before end are counted forward once instead.
+static size_t striter_skip_units_before(const char *str, size_t len, size_t end, size_t n, striter_mode_t mode, striter_utf8_run *valid_run)
+{
+    if (mode == STRITER_MODE_BYTE) {
+        return n < end ? end - n : 0;
+    }
+    while (n > 0 && end > 0) {
+        size_t unit = striter_unit_length_before_at(str, len, end, 0, mode, valid_run);
+        if (unit == 0) {
+            size_t before = 0;
+            for (size_t pos = 0; pos < end; before++) {
+                pos += striter_unit_length_at(str, len, pos, mode, valid_run);
+            }
+            return n < before ? striter_skip_units(str, len, 0, before - n, mode, valid_run, NULL) : 0;
+        }
+        end -= unit;
+        n--;
+    }
+    return end;
+}
+
+// str_iter_substr function implementation
+PHP_FUNCTION(str_iter_substr)
+{
+    zend_string *str;
+    zend_long start;
+    zend_long length = 0;
+    bool length_is_null = 1;
+    zend_string *mode = NULL;
+    
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+        Z_PARAM_STR(str)
+        Z_PARAM_LONG(start)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(length, length_is_null)
+        Z_PARAM_STR_OR_NULL(mode)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    const char *s = ZSTR_VAL(str);
+    size_t len = ZSTR_LEN(str);
+    striter_mode_t iter_mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    striter_utf8_run valid_run = {0, 0};
+    size_t begin, end = len;
+    
+    // Like mb_substr(), negative values count from the end. Those are
+    // found by segmenting backwards, so no call scans past the units it
+    // returns or skips from its side of the string.
+    if (start >= 0) {
+        begin = striter_skip_units(s, len, 0, (size_t)start, iter_mode, &valid_run, NULL);
+    } else {
+        begin = striter_skip_units_before(s, len, len, (size_t)-(start + 1) + 1, iter_mode, &valid_run);
+    }
+    
+    if (!length_is_null) {
+        if (length >= 0) {
+            end = striter_skip_units(s, len, begin, (size_t)length, iter_mode, &valid_run, NULL);
+        } else {
+            end = striter_skip_units_before(s, len, len, (size_t)-(length + 1) + 1, iter_mode, &valid_run);
+        }
+    }
+    
+    RETURN_STR(striter_substring(str, begin, end));
+}
+
+// str_iter_truncate function implementation
+PHP_FUNCTION(str_iter_truncate)
+{
+    zend_string *str;
+    zend_long length;
+    zend_string *suffix = NULL;
+    zend_string *mode = NULL;
+    
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+        Z_PARAM_STR(str)
+        Z_PARAM_LONG(length)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR(suffix)
+        Z_PARAM_STR_OR_NULL(mode)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    if (length < 0) {
+        zend_argument_value_error(2, "must be greater than or equal to 0");
+        RETURN_THROWS();
+    }
+    
+    const char *s = ZSTR_VAL(str);
+    size_t len = ZSTR_LEN(str);
+    size_t limit = (size_t)length;
+    striter_mode_t iter_mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    striter_utf8_run valid_run = {0, 0};
+    const char *suffix_val = suffix != NULL ? ZSTR_VAL(suffix) : "\xE2\x80\xA6";
+    size_t suffix_len = suffix != NULL ? ZSTR_LEN(suffix) : 3;
+    size_t suffix_units;
+    size_t rest;
+    
+    // The suffix takes its units out of the limit. Keep as many units as
+    // are left, then look at most one unit past the limit to see whether
+    // the string fits as it is.
+    striter_skip_units(suffix_val, suffix_len, 0, limit + 1, iter_mode, &valid_run, &suffix_units);
+    size_t keep = suffix_units < limit ? limit - suffix_units : 0;
+    
+    valid_run.start = valid_run.end = 0;
+    size_t cut = striter_skip_units(s, len, 0, keep, iter_mode, &valid_run, NULL);
+    striter_skip_units(s, len, cut, limit - keep + 1, iter_mode, &valid_run, &rest);
+    if (rest <= limit - keep) {
+        RETURN_STR_COPY(str);
+    }
+    
+    // A suffix longer than the limit is cut to it
+    if (suffix_units > limit) {
+        valid_run.start = valid_run.end = 0;
+        suffix_len = striter_skip_units(suffix_val, suffix_len, 0, limit, iter_mode, &valid_run, NULL);
+        RETURN_STRINGL(suffix_val, suffix_len);
+    }
+    if (cut == 0 && suffix != NULL) {
+        RETURN_STR_COPY(suffix);
+    }
+    
+    zend_string *result = zend_string_alloc(cut + suffix_len, 0);
+    memcpy(ZSTR_VAL(result), s, cut);
+    memcpy(ZSTR_VAL(result) + cut, suffix_val, suffix_len);
+    ZSTR_VAL(result)[cut + suffix_len] = '\0';
+    RETURN_NEW_STR(result);
+}
+
 // Utility function to get character at specific position
 zend_string *striter_get_char_at_position(const char *str, size_t str_len, size_t char_index, size_t *byte_pos) {
     if (str == NULL || str_len == 0) {
@@ -90,25 +462,17 @@ zend_string *striter_get_char_at_position(const char *str, size_t str_len, size_
     size_t current_char = 0;
     size_t pos = 0;
     
-    while (pos < str_len && current_char <= char_index) {
-        size_t advance = 0;
-        zend_result status;
-        unsigned int char_code = php_next_utf8_char((unsigned char *)str + pos, str_len - pos, &advance, &status);
+    while (pos < str_len) {
+        size_t advance = striter_utf8_char_length(str, str_len, pos);
         
         if (current_char == char_index) {
             // Found the character, extract it
-            if (advance == 0) {
-                advance = 1; // Ensure we advance at least 1 byte
-            }
             if (byte_pos) {
                 *byte_pos = pos;
             }
-            return zend_string_init(str + pos, advance, 0);
+            return striter_unit_string(str + pos, advance);
         }
         
-        if (advance == 0) {
-            advance = 1; // Ensure we advance at least 1 byte
-        }
         pos += advance;
         current_char++;
     }
@@ -116,6 +480,240 @@ zend_string *striter_get_char_at_position(const char *str, size_t str_len, size_
     return NULL;
 }
 
+// Byte length of the unit (grapheme, codepoint, byte, word, sentence or
+// line segment) starting at pos in the buffer str of len bytes. Shared by
+// string and stream iterators.
+size_t striter_unit_length_at(const char *str, size_t len, size_t pos, striter_mode_t mode, striter_utf8_run *valid_run) {
+    if (pos >= len) {
+        return 0;
+    }
+    
+    switch (mode) {
+        case STRITER_MODE_BYTE:
+            return 1;
+        case STRITER_MODE_GRAPHEME:
+            return striter_grapheme_length(str, len, pos, valid_run);
+        case STRITER_MODE_WORD:
+            return striter_word_length(str, len, pos);
+        case STRITER_MODE_SENTENCE:
+            return striter_sentence_length(str, len, pos);
+        case STRITER_MODE_LINE:
+            return striter_line_length(str, len, pos, NULL);
+        case STRITER_MODE_CODEPOINT:
+        default:
+            if ((unsigned char)str[pos] < 0x80) {
+                return 1;
+            }
+            return striter_utf8_char_length(str, len, pos);
+    }
+}
+
+static zend_always_inline bool striter_is_ascii_alnum(unsigned char c)
+{
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+// Whether a word, sentence or line segment always starts at pos, judging
+// from the ASCII text around it only: after a hard line break (WB3a, SB4,
+// LB4/LB5), and for a letter or digit after a space, unless a rule can
+// reach across that space (an opening bracket before it, LB14; anything
+// but a terminator, which continues a sentence until an uppercase letter
+// comes after it, SB8/SB11)
+static bool striter_segment_starts_at(const unsigned char *s, size_t pos, striter_mode_t mode)
+{
+    unsigned char c = s[pos - 1];
+    
+    if (c == '\n' || (c == '\r' && s[pos] != '\n')
+            || (c == 0x85 && pos >= 2 && s[pos - 2] == 0xC2)
+            || ((c == 0xA8 || c == 0xA9) && pos >= 3 && s[pos - 2] == 0x80 && s[pos - 3] == 0xE2)) {
+        return 1;
+    }
+    if (c != ' ' || !striter_is_ascii_alnum(s[pos])) {
+        return 0;
+    }
+    if (mode == STRITER_MODE_WORD) {
+        return 1;
+    }
+    
+    while (pos > 1 && s[pos - 2] == ' ') {
+        pos--;
+    }
+    if (pos < 2) {
+        return 0;
+    }
+    c = s[pos - 2];
+    if (mode == STRITER_MODE_LINE) {
+        return c > 0x20 && c < 0x7F && c != '(' && c != '[' && c != '{';
+    }
+    
+    // Sentences: terminator, closing punctuation, spaces, uppercase letter
+    if (s[pos] < 'A' || s[pos] > 'Z') {
+        return 0;
+    }
+    for (pos -= 2; pos > 0 && (c == '"' || c == '\'' || c == ')'); c = s[--pos]);
+    return c == '.' || c == '!' || c == '?';
+}
+
+// Bytes searched back for a word, sentence or line restart point. Text
+// without spaces or line breaks (CJK, Thai) may have none for its whole
+// length, and searching it all on every step back would make each step
+// linear.
+#define STRITER_RESTART_SEARCH 1024
+
+// Last position after floor and before end where a word, sentence or line
+// segment always starts, or floor
+static size_t striter_segment_restart_before(const char *str, size_t end, size_t floor, striter_mode_t mode)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    
+    for (size_t pos = end - 1; pos > floor; pos--) {
+        if (striter_segment_starts_at(s, pos, mode)) {
+            return pos;
+        }
+    }
+    return floor;
+}
+
+// Byte length of the unit ending at end, a unit boundary. Codepoints and
+// bytes are decoded backwards directly. The other modes step back to a
+// position where segmentation can restart without knowing anything before
+// it, then segment forward up to end: for grapheme clusters the nearest
+// break that the pair rules make unconditional, usually the start of the
+// very cluster, and for words, sentences and lines the last hard line
+// break or plain ASCII word after a space. known is a unit boundary before
+// end that the caller already has, used when it is closer. Those restart
+// points are only searched for STRITER_RESTART_SEARCH bytes back from end
+// (or down to known); returns 0 if there is none in that range, and the
+// caller has to find the unit from a boundary it knows of.
+size_t striter_unit_length_before_at(const char *str, size_t len, size_t end, size_t known, striter_mode_t mode, striter_utf8_run *valid_run) {
+    size_t start;
+    size_t floor;
+    
+    if (end == 0) {
+        return 0;
+    }
+    
+    switch (mode) {
+        case STRITER_MODE_BYTE:
+            return 1;
+        case STRITER_MODE_CODEPOINT:
+            return striter_utf8_char_length_before(str, len, end);
+        case STRITER_MODE_GRAPHEME:
+            start = end;
+            do {
+                start -= striter_utf8_char_length_before(str, len, start);
+            } while (start > 0 && !striter_grapheme_is_safe_break(str, len, start));
+            break;
+        default:
+            floor = end > STRITER_RESTART_SEARCH ? end - STRITER_RESTART_SEARCH : 0;
+            if (known > floor && known < end) {
+                floor = known;
+            }
+            start = striter_segment_restart_before(str, end, floor, mode);
+            if (start == floor && floor > 0 && floor != known) {
+                return 0;
+            }
+            break;
+    }
+    if (known > start && known < end) {
+        start = known;
+    }
+    
+    // The PCRE2 engine rescans its valid run from every new start, which
+    // would make each step back linear, so grapheme clusters are measured
+    // natively here
+    for (;;) {
+        size_t unit = mode == STRITER_MODE_GRAPHEME
+            ? striter_grapheme_length_native(str, len, start)
+            : striter_unit_length_at(str, len, start, mode, valid_run);
+        if (start + unit >= end) {
+            return end - start;
+        }
+        start += unit;
+    }
+}
+
+// Byte length of the single unit starting at pos in an iterator's string
+static zend_always_inline size_t striter_single_unit_length(striter_string_iterator_obj *obj, size_t pos) {
+    if (obj->encoding) {
+        return striter_decoded_length(obj, pos);
+    }
+    return striter_unit_length_at(ZSTR_VAL(obj->str), ZSTR_LEN(obj->str), pos, obj->mode, &obj->valid_run);
+}
+
+// Byte length of the chunk starting at pos: chunk units, or as many whole
+// units as fit in chunk_bytes bytes, but at least one
+static size_t striter_chunk_length(striter_string_iterator_obj *obj, size_t pos) {
+    const unsigned char *s = (const unsigned char *)ZSTR_VAL(obj->str);
+    size_t len = ZSTR_LEN(obj->str);
+    bool codepoint = obj->mode == STRITER_MODE_CODEPOINT && !obj->encoding;
+    size_t end = pos;
+    
+    if (obj->mode == STRITER_MODE_BYTE) {
+        return MIN(obj->chunk ? obj->chunk : obj->chunk_bytes, len - pos);
+    }
+    
+    // ASCII runs are one codepoint per byte and are taken a vector at a time
+    if (obj->chunk) {
+        size_t i = 0;
+        while (i < obj->chunk && end < len) {
+            if (codepoint && s[end] < 0x80) {
+                size_t run = striter_ascii_span(s + end, MIN(obj->chunk - i, len - end));
+                end += run;
+                i += run;
+                continue;
+            }
+            end += striter_single_unit_length(obj, end);
+            i++;
+        }
+        return end - pos;
+    }
+    
+    size_t limit = len - pos > obj->chunk_bytes ? pos + obj->chunk_bytes : len;
+    while (end < limit) {
+        if (codepoint && s[end] < 0x80) {
+            end += striter_ascii_span(s + end, limit - end);
+            continue;
+        }
+        size_t unit = striter_single_unit_length(obj, end);
+        if (end > pos && end + unit > limit) {
+            break;
+        }
+        end += unit;
+    }
+    return end - pos;
+}
+
+// Byte length of the unit starting at pos in an iterator's string, or of
+// the chunk of units with the chunk options. This is the single step of
+// the cursor engine: iterating a string costs one call per unit, each
+// proportional to the size of that unit.
+size_t striter_unit_length(striter_string_iterator_obj *obj, size_t pos) {
+    if (obj->chunk || obj->chunk_bytes) {
+        return striter_chunk_length(obj, pos);
+    }
+    return striter_single_unit_length(obj, pos);
+}
+
+// Count the units of a string in the given mode
+size_t striter_count_units(const char *str, size_t len, striter_mode_t mode) {
+    switch (mode) {
+        case STRITER_MODE_BYTE:
+            return striter_count_bytes(str, len);
+        case STRITER_MODE_GRAPHEME:
+            return striter_count_graphemes(str, len);
+        case STRITER_MODE_WORD:
+            return striter_count_words(str, len);
+        case STRITER_MODE_SENTENCE:
+            return striter_count_sentences(str, len);
+        case STRITER_MODE_LINE:
+            return striter_count_line_segments(str, len);
+        case STRITER_MODE_CODEPOINT:
+        default:
+            return striter_count_utf8_chars(str, len);
+    }
+}
+
 // Parse mode string to enum
 striter_mode_t striter_parse_mode(const char *mode_str) {
     if (mode_str == NULL) {
@@ -126,20 +724,97 @@ striter_mode_t striter_parse_mode(const char *mode_str) {
         return STRITER_MODE_CODEPOINT;
     } else if (strcmp(mode_str, "byte") == 0) {
         return STRITER_MODE_BYTE;
+    } else if (strcmp(mode_str, "word") == 0) {
+        return STRITER_MODE_WORD;
+    } else if (strcmp(mode_str, "sentence") == 0) {
+        return STRITER_MODE_SENTENCE;
+    } else if (strcmp(mode_str, "line") == 0) {
+        return STRITER_MODE_LINE;
     }
     
     // Default to grapheme mode for any other value
     return STRITER_MODE_GRAPHEME;
 }
 
+// Resolve the mode and options arguments shared by str_iter() and the
+// constructor. In strict mode the string is validated here, before any
+// iteration starts. Throws and returns FAILURE on bad arguments.
+zend_result striter_parse_arguments(zend_string *str, zend_string *mode, HashTable *options, striter_mode_t *iter_mode, striter_options *opts)
+{
+    zend_string *key;
+    zval *value;
+    
+    *iter_mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    memset(opts, 0, sizeof(*opts));
+    
+    if (options != NULL) {
+        ZEND_HASH_FOREACH_STR_KEY_VAL(options, key, value) {
+            if (key == NULL) {
+                zend_argument_value_error(3, "must only contain string keys");
+                return FAILURE;
+            }
+            if (zend_string_equals_literal(key, "strict")) {
+                opts->strict = zend_is_true(value);
+            } else if (zend_string_equals_literal(key, "substitute")) {
+                opts->substitute = zend_is_true(value);
+            } else if (zend_string_equals_literal(key, "offsets")) {
+                opts->offsets = zend_is_true(value);
+            } else if (zend_string_equals_literal(key, "indexed")) {
+                opts->indexed = zend_is_true(value);
+            } else if (zend_string_equals_literal(key, "normalize")) {
+                if (Z_TYPE_P(value) == IS_STRING && zend_string_equals_literal_ci(Z_STR_P(value), "NFC")) {
+                    opts->normalize = STRITER_NORM_NFC;
+                } else if (Z_TYPE_P(value) == IS_STRING && zend_string_equals_literal_ci(Z_STR_P(value), "NFD")) {
+                    opts->normalize = STRITER_NORM_NFD;
+                } else {
+                    zend_argument_value_error(3, "option \"normalize\" must be \"NFC\" or \"NFD\"");
+                    return FAILURE;
+                }
+            } else if (zend_string_equals_literal(key, "encoding")) {
+                if (Z_TYPE_P(value) != IS_STRING || !striter_parse_encoding(Z_STR_P(value), &opts->encoding)) {
+                    zend_argument_value_error(3, "option \"encoding\" must be \"UTF-8\", \"UTF-16LE\", \"UTF-16BE\" or \"ISO-8859-1\"");
+                    return FAILURE;
+                }
+            } else if (zend_string_equals_literal(key, "chunk") || zend_string_equals_literal(key, "chunk_bytes")) {
+                if (Z_TYPE_P(value) != IS_LONG || Z_LVAL_P(value) < 1) {
+                    zend_argument_value_error(3, "option \"%s\" must be an integer greater than 0", ZSTR_VAL(key));
+                    return FAILURE;
+                }
+                if (ZSTR_LEN(key) == 5) {
+                    opts->chunk = (size_t)Z_LVAL_P(value);
+                } else {
+                    opts->chunk_bytes = (size_t)Z_LVAL_P(value);
+                }
+            } else {
+                zend_argument_value_error(3, "contains unknown option \"%s\"", ZSTR_VAL(key));
+                return FAILURE;
+            }
+        } ZEND_HASH_FOREACH_END();
+    }
+    
+    if (opts->chunk && opts->chunk_bytes) {
+        zend_argument_value_error(3, "cannot combine the \"chunk\" and \"chunk_bytes\" options");
+        return FAILURE;
+    }
+    
+    if (opts->strict) {
+        size_t bad = striter_decoded_validate(opts->encoding, ZSTR_VAL(str), ZSTR_LEN(str));
+        if (bad < ZSTR_LEN(str)) {
+            zend_value_error("Invalid %s sequence at byte offset %zu", striter_decoders[opts->encoding].name, bad);
+            return FAILURE;
+        }
+    }
+    
+    return SUCCESS;
+}
+
 #ifdef HAVE_PCRE2
 // Global cached compiled pattern for grapheme clusters
 pcre2_code *striter_grapheme_pattern = NULL;
 // JIT availability flag: -1 = not checked, 0 = not available, 1 = available
 static int striter_jit_available = -1;
-#ifdef ZTS
-zend_mutex_t striter_pattern_mutex;
-#endif
+// Whether pcre2_jit_compile() succeeded for the grapheme pattern
+static bool striter_grapheme_pattern_jit = 0;
 
 // Check JIT availability at runtime
 static int striter_check_jit_support(void)
@@ -158,41 +833,118 @@ int striter_get_jit_status(void)
     return striter_check_jit_support();
 }
 
-// Thread-safe getter for grapheme pattern
+// Compile the grapheme pattern. Called once from MINIT, before any request
+// thread starts, so the pattern is read-only afterwards and every thread
+// can use it without locking.
+//
+// The pattern is compiled anchored rather than matched with PCRE2_ANCHORED:
+// pcre2_match() never runs JIT code for a match-time ANCHORED option.
+void striter_compile_grapheme_pattern(void)
+{
+    PCRE2_SPTR pattern = (PCRE2_SPTR)"\\X";
+    int errorcode;
+    PCRE2_SIZE erroroffset;
+    
+    striter_grapheme_pattern = pcre2_compile(
+        pattern,
+        PCRE2_ZERO_TERMINATED,
+        PCRE2_UTF | PCRE2_UCP | PCRE2_ANCHORED,
+        &errorcode,
+        &erroroffset,
+        NULL
+    );
+    
+    // Try JIT compilation if available; without it the interpreter is used
+    if (striter_grapheme_pattern != NULL && striter_check_jit_support()) {
+        striter_grapheme_pattern_jit = pcre2_jit_compile(striter_grapheme_pattern, PCRE2_JIT_COMPLETE) == 0;
+    }
+}
+
+// Compiled grapheme pattern, or NULL if compiling it failed
 pcre2_code *striter_get_grapheme_pattern(void)
 {
-#ifdef ZTS
-    zend_mutex_lock(&striter_pattern_mutex);
-#endif
+    return striter_grapheme_pattern;
+}
+
+// Match data for the grapheme pattern, created on first use and kept in
+// the module globals, so there is one per thread and none per call. \X
+// has no capture groups, so it never needs resizing.
+static pcre2_match_data *striter_get_match_data(pcre2_code *pattern)
+{
+    if (STRITER_G(match_data) == NULL) {
+        STRITER_G(match_data) = pcre2_match_data_create_from_pattern(pattern, NULL);
+    }
+    return STRITER_G(match_data);
+}
+
+// Record the valid UTF-8 run starting at pos in *valid_run.
+// Returns 0 if the sequence at pos itself is invalid.
+static int striter_find_valid_run(const char *str, size_t len, size_t pos, striter_utf8_run *valid_run)
+{
+    size_t end = pos;
     
-    if (striter_grapheme_pattern == NULL) {
-        PCRE2_SPTR pattern = (PCRE2_SPTR)"\\X";
-        int errorcode;
-        PCRE2_SIZE erroroffset;
-        
-        striter_grapheme_pattern = pcre2_compile(
-            pattern,
-            PCRE2_ZERO_TERMINATED,
-            PCRE2_UTF | PCRE2_UCP,
-            &errorcode,
-            &erroroffset,
-            NULL
-        );
-        
-        // Try JIT compilation if available
-        if (striter_grapheme_pattern != NULL && striter_check_jit_support()) {
-            int jit_result = pcre2_jit_compile(striter_grapheme_pattern, PCRE2_JIT_COMPLETE);
-            // JIT compilation failure is not fatal - pattern still works without JIT
+    while (end < len) {
+        size_t advance = 0;
+        zend_result status;
+        php_next_utf8_char((unsigned char *)str + end, len - end, &advance, &status);
+        if (status != SUCCESS) {
+            break;
         }
+        end += advance;
     }
     
-    pcre2_code *result = striter_grapheme_pattern;
+    valid_run->start = pos;
+    valid_run->end = end;
+    return end > pos;
+}
+
+// Byte length of the grapheme cluster starting at pos using PCRE2.
+//
+// *valid_run caches the valid UTF-8 run containing pos, so the
+// subject handed to pcre2_match is always known-valid and PCRE2_NO_UTF_CHECK
+// can skip the per-call validation of the whole string. Invalid sequences
+// are returned as single units, like in codepoint mode.
+size_t striter_grapheme_length_pcre2(const char *str, size_t len, size_t pos, striter_utf8_run *valid_run) {
+    if (pos >= len) {
+        return 0;
+    }
     
-#ifdef ZTS
-    zend_mutex_unlock(&striter_pattern_mutex);
-#endif
+    if ((pos < valid_run->start || pos >= valid_run->end)
+        && !striter_find_valid_run(str, len, pos, valid_run)) {
+        return striter_utf8_char_length(str, len, pos);
+    }
     
-    return result;
+    // Use thread-safe pattern getter
+    pcre2_code *pattern = striter_get_grapheme_pattern();
+    if (pattern == NULL) {
+        return striter_utf8_char_length(str, len, pos);
+    }
+    
+    pcre2_match_data *match_data = striter_get_match_data(pattern);
+    if (match_data == NULL) {
+        return striter_utf8_char_length(str, len, pos);
+    }
+    
+    // Match \X at the start of the remaining valid run. pcre2_jit_match()
+    // skips the option and UTF checks that pcre2_match() repeats per call.
+    int rc;
+    if (striter_grapheme_pattern_jit) {
+        rc = pcre2_jit_match(pattern, (PCRE2_SPTR)str + pos, valid_run->end - pos, 0, 0, match_data, NULL);
+    } else {
+        rc = pcre2_match(pattern, (PCRE2_SPTR)str + pos, valid_run->end - pos, 0, PCRE2_NO_UTF_CHECK, match_data, NULL);
+    }
+    
+    size_t cluster_len = 0;
+    if (rc >= 0) {
+        cluster_len = pcre2_get_ovector_pointer(match_data)[1];
+    }
+    
+    // Prevent infinite loop on empty matches or errors
+    if (cluster_len == 0) {
+        cluster_len = striter_utf8_char_length(str, len, pos);
+    }
+    
+    return cluster_len;
 }
 
 // Count grapheme clusters using PCRE2
@@ -202,70 +954,21 @@ size_t striter_count_graphemes_pcre2(const char *str, size_t len) {
     }
     
     // Use thread-safe pattern getter
-    pcre2_code *pattern = striter_get_grapheme_pattern();
-    if (pattern == NULL) {
+    if (striter_get_grapheme_pattern() == NULL) {
         // Fallback to byte-by-byte counting if pattern not available
         return len;
     }
     
-    pcre2_match_data *match_data;
-    PCRE2_SPTR subject = (PCRE2_SPTR)str;
     size_t count = 0;
-    PCRE2_SIZE start_offset = 0;
-    int rc;
-    
-    // Create match data
-    match_data = pcre2_match_data_create_from_pattern(pattern, NULL);
-    if (match_data == NULL) {
-        return len;
-    }
+    size_t pos = 0;
+    striter_utf8_run valid_run = {0, 0};
     
     // Scan string for grapheme clusters
-    while (start_offset < len) {
-        rc = pcre2_match(
-            pattern,
-            subject,
-            len,
-            start_offset,
-            0,
-            match_data,
-            NULL
-        );
-        
-        if (rc < 0) {
-            if (rc == PCRE2_ERROR_NOMATCH) {
-                break;
-            } else {
-                // Error: skip one byte and continue
-                // This ensures we don't get stuck in infinite loops
-                if (start_offset < len) {
-                    start_offset++;
-                    count++;
-                }
-                continue;
-            }
-        }
-        
+    while (pos < len) {
+        pos += striter_grapheme_length_pcre2(str, len, pos, &valid_run);
         count++;
-        
-        // Get match boundaries
-        PCRE2_SIZE *ovector = pcre2_get_ovector_pointer(match_data);
-        PCRE2_SIZE match_start = ovector[0];
-        PCRE2_SIZE match_end = ovector[1];
-        
-        start_offset = match_end;
-        
-        // Prevent infinite loop
-        if (match_end == match_start) {
-            if (start_offset >= len) {
-                break;
-            }
-            start_offset++;
-        }
     }
     
-    pcre2_match_data_free(match_data);
-    
     return count;
 }
 
@@ -275,92 +978,28 @@ zend_string *striter_get_grapheme_at_position(const char *str, size_t str_len, s
         return NULL;
     }
     
-    // Use thread-safe pattern getter
-    pcre2_code *pattern = striter_get_grapheme_pattern();
-    if (pattern == NULL) {
-        // Fallback to single byte
-        if (byte_pos) {
-            *byte_pos = char_index < str_len ? char_index : str_len - 1;
-        }
-        return zend_string_init(str + (char_index < str_len ? char_index : str_len - 1), 1, 0);
-    }
-    
-    pcre2_match_data *match_data;
-    PCRE2_SPTR subject = (PCRE2_SPTR)str;
+    zend_string *result = NULL;
     size_t current_char = 0;
-    PCRE2_SIZE start_offset = 0;
-    int rc;
-    
-    match_data = pcre2_match_data_create_from_pattern(pattern, NULL);
-    if (match_data == NULL) {
-        if (byte_pos) {
-            *byte_pos = char_index < str_len ? char_index : str_len - 1;
-        }
-        return zend_string_init(str + (char_index < str_len ? char_index : str_len - 1), 1, 0);
-    }
+    size_t pos = 0;
+    striter_utf8_run valid_run = {0, 0};
     
     // Find the char_index-th grapheme cluster
-    while (start_offset < str_len && current_char <= char_index) {
-        rc = pcre2_match(
-            pattern,
-            subject,
-            str_len,
-            start_offset,
-            0,
-            match_data,
-            NULL
-        );
-        
-        if (rc < 0) {
-            if (rc == PCRE2_ERROR_NOMATCH) {
-                break;
-            } else {
-                // Error: treat as single byte
-                if (current_char == char_index) {
-                    if (byte_pos) {
-                        *byte_pos = start_offset;
-                    }
-                    pcre2_match_data_free(match_data);
-                    return zend_string_init(str + start_offset, 
-                        start_offset < str_len ? 1 : 0, 0);
-                }
-                if (start_offset < str_len) {
-                    start_offset++;
-                    current_char++;
-                }
-                continue;
-            }
-        }
-        
-        PCRE2_SIZE *ovector = pcre2_get_ovector_pointer(match_data);
-        PCRE2_SIZE match_start = ovector[0];
-        PCRE2_SIZE match_end = ovector[1];
+    while (pos < str_len) {
+        size_t cluster_len = striter_grapheme_length_pcre2(str, str_len, pos, &valid_run);
         
         if (current_char == char_index) {
             if (byte_pos) {
-                *byte_pos = match_start;
+                *byte_pos = pos;
             }
-            size_t cluster_len = match_end - match_start;
-            zend_string *result = zend_string_init(str + match_start, cluster_len, 0);
-            
-            pcre2_match_data_free(match_data);
-            return result;
+            result = striter_unit_string(str + pos, cluster_len);
+            break;
         }
         
-        start_offset = match_end;
+        pos += cluster_len;
         current_char++;
-        
-        // Prevent infinite loop
-        if (match_end == match_start) {
-            if (start_offset >= str_len) {
-                break;
-            }
-            start_offset++;
-        }
     }
     
-    pcre2_match_data_free(match_data);
-    return NULL;
+    return result;
 }
 #endif
 
@@ -375,13 +1014,60 @@ zend_string *striter_get_byte_at_position(const char *str, size_t str_len, size_
         return NULL;
     }
     
-    // Return single byte as string
-    return zend_string_init(str + byte_index, 1, 0);
+    // Interned one-character string, no allocation
+    return ZSTR_CHAR((zend_uchar)str[byte_index]);
+}
+
+// Module globals initialization
+static PHP_GINIT_FUNCTION(striter)
+{
+#if defined(COMPILE_DL_STRITER) && defined(ZTS)
+    ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+    striter_globals->grapheme_engine = STRITER_ENGINE_NATIVE;
+    striter_globals->simd = STRITER_SIMD_SCALAR;
+    striter_globals->ascii_span = NULL;
+    striter_globals->index_interval = 128;
+    striter_globals->threads = 0;
+    striter_globals->cache_size = 0;
+    striter_globals->cache = NULL;
+    striter_globals->cache_in_request = 0;
+    striter_globals->cache_hits = 0;
+    striter_globals->cache_misses = 0;
+    striter_globals->cache_evictions = 0;
+#ifdef HAVE_PCRE2
+    striter_globals->match_data = NULL;
+#endif
+}
+
+// Module globals destruction
+static PHP_GSHUTDOWN_FUNCTION(striter)
+{
+    striter_cache_destroy(striter_globals->cache);
+    striter_globals->cache = NULL;
+#ifdef HAVE_PCRE2
+    if (striter_globals->match_data != NULL) {
+        pcre2_match_data_free(striter_globals->match_data);
+        striter_globals->match_data = NULL;
+    }
+#endif
 }
 
 // Function entries
 const zend_function_entry striter_functions[] = {
     PHP_FE(str_iter, arginfo_str_iter)
+    PHP_FE(str_iter_reverse, arginfo_str_iter_reverse)
+    PHP_FE(str_iter_chunks, arginfo_str_iter_chunks)
+    PHP_FE(str_iter_count_values, arginfo_str_iter_count_values)
+    PHP_FE(str_iter_stats, arginfo_str_iter_stats)
+    PHP_FE(str_iter_casecmp, arginfo_str_iter_casecmp)
+    PHP_FE(str_iter_starts_with_folded, arginfo_str_iter_starts_with_folded)
+    PHP_FE(str_iter_split, arginfo_str_iter_split)
+    PHP_FE(str_iter_substr, arginfo_str_iter_substr)
+    PHP_FE(str_iter_truncate, arginfo_str_iter_truncate)
+    PHP_FE(str_iter_stream, arginfo_str_iter_stream)
+    PHP_FE(str_iter_file, arginfo_str_iter_file)
+    PHP_FE(str_iter_wrap, arginfo_str_iter_wrap)
     PHP_FE_END
 };
 
@@ -392,11 +1078,15 @@ zend_module_entry striter_module_entry = {
     striter_functions,
     PHP_MINIT(striter),
     PHP_MSHUTDOWN(striter),
-    NULL,
-    NULL,
+    PHP_RINIT(striter),
+    PHP_RSHUTDOWN(striter),
     PHP_MINFO(striter),
     PHP_STRITER_VERSION,
-    STANDARD_MODULE_PROPERTIES
+    PHP_MODULE_GLOBALS(striter),
+    PHP_GINIT(striter),
+    PHP_GSHUTDOWN(striter),
+    NULL,
+    STANDARD_MODULE_PROPERTIES_EX
 };
 
 #ifdef COMPILE_DL_STRITER
@@ -409,17 +1099,21 @@ ZEND_GET_MODULE(striter)
 // Module initialization
 PHP_MINIT_FUNCTION(striter)
 {
+    REGISTER_INI_ENTRIES();
+    
+    striter_replacement_char = zend_string_init_interned("\xEF\xBF\xBD", 3, 1);
+    for (int i = 0; i < 128; i++) {
+        char latin1[2] = {(char)(0xC2 + (i >= 0x40)), (char)(0x80 + i % 0x40)};
+        striter_latin1_chars[i] = zend_string_init_interned(latin1, 2, 1);
+    }
+    
     // Initialize StringIterator class
     striter_string_iterator_init();
+    striter_stream_iterator_init();
     
 #ifdef HAVE_PCRE2
-#ifdef ZTS
-    // Initialize mutex for thread safety
-    zend_mutex_alloc(&striter_pattern_mutex);
-#endif
-    
-    // Pattern will be lazily compiled in thread-safe manner
-    striter_grapheme_pattern = NULL;
+    // Compiled here, before threads exist, so reads never need a lock
+    striter_compile_grapheme_pattern();
 #endif
     
     return SUCCESS;
@@ -428,18 +1122,37 @@ PHP_MINIT_FUNCTION(striter)
 // Module shutdown
 PHP_MSHUTDOWN_FUNCTION(striter)
 {
+    UNREGISTER_INI_ENTRIES();
+    
+    striter_parallel_shutdown();
+    
 #ifdef HAVE_PCRE2
     // Free the cached compiled pattern
     if (striter_grapheme_pattern != NULL) {
         pcre2_code_free(striter_grapheme_pattern);
         striter_grapheme_pattern = NULL;
     }
-    
-#ifdef ZTS
-    // Free mutex
-    zend_mutex_free(&striter_pattern_mutex);
 #endif
+    
+    return SUCCESS;
+}
+
+// Request initialization
+PHP_RINIT_FUNCTION(striter)
+{
+#if defined(COMPILE_DL_STRITER) && defined(ZTS)
+    ZEND_TSRMLS_CACHE_UPDATE();
 #endif
+    striter_cache_begin_request();
+    
+    return SUCCESS;
+}
+
+// Request shutdown
+PHP_RSHUTDOWN_FUNCTION(striter)
+{
+    // The request's interned strings are freed after this
+    striter_cache_end_request();
     
     return SUCCESS;
 }
@@ -450,12 +1163,25 @@ PHP_MINFO_FUNCTION(striter)
     php_info_print_table_start();
     php_info_print_table_header(2, "striter support", "enabled");
     php_info_print_table_row(2, "Version", PHP_STRITER_VERSION);
+    php_info_print_table_row(2, "Grapheme engine",
+        STRITER_G(grapheme_engine) == STRITER_ENGINE_PCRE2 ? "PCRE2 \\X" : "native UAX #29");
+    php_info_print_table_row(2, "SIMD kernels", striter_simd_name(STRITER_G(simd)));
+#ifdef HAVE_PTHREAD_H
+    php_info_print_table_row(2, "Parallel counting", "available (striter.threads)");
+#else
+    php_info_print_table_row(2, "Parallel counting", "unavailable");
+#endif
+    striter_cache_info();
 #ifdef HAVE_PCRE2
     php_info_print_table_row(2, "PCRE2 support", "enabled");
     php_info_print_table_row(2, "PCRE2 JIT support", 
         striter_get_jit_status() ? "enabled" : "disabled");
+    php_info_print_table_row(2, "Grapheme pattern JIT",
+        striter_grapheme_pattern == NULL ? "compile failed" : (striter_grapheme_pattern_jit ? "yes" : "no"));
 #else
     php_info_print_table_row(2, "PCRE2 support", "disabled");
 #endif
     php_info_print_table_end();
+    
+    DISPLAY_INI_ENTRIES();
 }
\ No newline at end of file
@@ -0,0 +1,314 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "ext/standard/info.h"
+#include "php_striter.h"
+
+// Segmentation cache for interned strings.
+//
+// Literals and configuration values are wrapped by str_iter() over and
+// over. Interned strings are never modified or freed while in use, so the
+// cache finds them by address: it maps (string, mode) to the unit count
+// and, once a cursor has walked the whole string, to the checkpoint index
+// as well. A new iterator over a cached string starts with both, and
+// shares the index read-only instead of copying it. An address is reused
+// once its string is freed, so an entry also keeps the hash, length and
+// bytes of its string and only serves a string equal to them, segmented
+// by the same grapheme engine.
+//
+// Permanent interned strings (opcache's shared memory, strings interned at
+// startup) stay cached from one request to the next. opcache_reset() and
+// opcache's own restarts free them without telling extensions; the stale
+// entries fail the comparison and are dropped. Entries for strings
+// interned by a request are dropped when the request ends. The cache is in
+// the module globals, so there is one per thread in ZTS builds and no
+// locking. It holds at most striter.cache_size bytes, evicting the least
+// recently used entries first.
+
+struct _striter_cache_entry {
+    striter_cache_entry *newer; // Next more recently used entry
+    striter_cache_entry *older; // Next less recently used entry
+    zend_string *str;           // Key string (interned, not owned)
+    striter_mode_t mode;
+    size_t count;               // Units in str
+    bool indexed;               // checkpoints cover the whole string
+    size_t *checkpoints;        // Byte offset of every index_interval-th unit
+    size_t checkpoint_count;
+    size_t index_interval;
+    size_t size;                // Bytes charged to the budget
+    uint32_t refcount;          // One for the cache, one per sharing iterator
+    bool permanent;             // str outlives the request
+    striter_grapheme_engine_t engine; // Grapheme engine that segmented str
+    zend_ulong hash;            // Hash of str
+    size_t len;                 // Length of str
+    char val[1];                // Copy of the bytes of str
+};
+
+struct _striter_cache {
+    HashTable entries;          // Key -> entry
+    striter_cache_entry *newest;
+    striter_cache_entry *oldest;
+    size_t used;                // Bytes charged by all entries
+};
+
+// zend_strings are 8-byte aligned and larger than 8 bytes, so adding the
+// mode to the address never makes two keys collide
+static zend_always_inline zend_ulong striter_cache_key(zend_string *str, striter_mode_t mode)
+{
+    return (zend_ulong)(uintptr_t)str + (zend_ulong)mode;
+}
+
+// Whether what obj finds out about its string can be cached. Byte mode
+// needs no scan, the counts and checkpoints of chunks are not those of
+// units, and the key does not tell the encoding.
+static bool striter_cache_accepts(striter_string_iterator_obj *obj)
+{
+    if (STRITER_G(cache_size) == 0 || obj->mode == STRITER_MODE_BYTE || obj->chunk || obj->chunk_bytes || obj->encoding
+            || !ZSTR_IS_INTERNED(obj->str)) {
+        return 0;
+    }
+    return (GC_FLAGS(obj->str) & IS_STR_PERMANENT) || STRITER_G(cache_in_request);
+}
+
+// Whether entry holds what obj would find: stored for the contents of its
+// string, not for an earlier string at the same address, and segmented by
+// the grapheme engine now selected (striter.grapheme_engine is PHP_INI_ALL,
+// and the engines may disagree, e.g. on GB9c)
+static zend_always_inline bool striter_cache_matches(striter_cache_entry *entry, striter_string_iterator_obj *obj)
+{
+    zend_string *str = obj->str;
+    
+    return entry->engine == STRITER_G(grapheme_engine)
+        && entry->hash == zend_string_hash_val(str) && entry->len == ZSTR_LEN(str)
+        && memcmp(entry->val, ZSTR_VAL(str), entry->len) == 0;
+}
+
+static void striter_cache_unlink(striter_cache *cache, striter_cache_entry *entry)
+{
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+}
+
+static void striter_cache_push(striter_cache *cache, striter_cache_entry *entry)
+{
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+// Drop a reference to an entry, freeing it with the last one
+void striter_cache_release(striter_cache_entry *entry)
+{
+    if (--entry->refcount == 0) {
+        if (entry->checkpoints) {
+            pefree(entry->checkpoints, 1);
+        }
+        pefree(entry, 1);
+    }
+}
+
+static void striter_cache_remove(striter_cache *cache, striter_cache_entry *entry)
+{
+    striter_cache_unlink(cache, entry);
+    zend_hash_index_del(&cache->entries, striter_cache_key(entry->str, entry->mode));
+    cache->used -= entry->size;
+    striter_cache_release(entry);
+}
+
+// Evict least recently used entries until the cache fits in budget bytes
+static void striter_cache_trim(striter_cache *cache, size_t budget)
+{
+    while (cache->used > budget && cache->oldest) {
+        striter_cache_remove(cache, cache->oldest);
+        STRITER_G(cache_evictions)++;
+    }
+}
+
+// Start obj, just set up, with what the cache knows about its string
+void striter_cache_lookup(striter_string_iterator_obj *obj)
+{
+    striter_cache *cache = STRITER_G(cache);
+    striter_cache_entry *entry;
+    
+    if (!striter_cache_accepts(obj)) {
+        return;
+    }
+    entry = cache ? zend_hash_index_find_ptr(&cache->entries, striter_cache_key(obj->str, obj->mode)) : NULL;
+    if (entry != NULL && !striter_cache_matches(entry, obj)) {
+        // Left by a freed string whose address has been reused, or by
+        // another engine
+        striter_cache_remove(cache, entry);
+        entry = NULL;
+    }
+    if (entry == NULL) {
+        STRITER_G(cache_misses)++;
+        return;
+    }
+    
+    STRITER_G(cache_hits)++;
+    striter_cache_unlink(cache, entry);
+    striter_cache_push(cache, entry);
+    
+    obj->total_chars = entry->count;
+    obj->count_known = 1;
+    // An iterator with a unit index still has to walk the string to build
+    // it, so only the count is taken
+    if (entry->indexed && entry->index_interval == obj->index_interval && obj->unit_index == NULL) {
+        // As if a cursor had walked the whole string; nothing is ever
+        // appended to a complete index, so it can be shared
+        obj->checkpoints = entry->checkpoints;
+        obj->checkpoint_count = entry->checkpoint_count;
+        obj->scan_pos = ZSTR_LEN(obj->str);
+        obj->scan_index = entry->count;
+        obj->cache_entry = entry;
+        entry->refcount++;
+    }
+}
+
+// Remember what obj found out about its string, before it is released.
+// A count is stored once; a complete index replaces an entry without one.
+void striter_cache_store(striter_string_iterator_obj *obj)
+{
+    striter_cache *cache = STRITER_G(cache);
+    striter_cache_entry *entry;
+    zend_ulong key;
+    
+    if (!obj->str || !obj->count_known || obj->cache_entry || !striter_cache_accepts(obj)) {
+        return;
+    }
+    
+    bool indexed = obj->scan_pos >= ZSTR_LEN(obj->str);
+    size_t size = sizeof(striter_cache_entry) + ZSTR_LEN(obj->str) + sizeof(Bucket)
+        + (indexed ? obj->checkpoint_count * sizeof(size_t) : 0);
+    if (size > (size_t)STRITER_G(cache_size)) {
+        return;
+    }
+    
+    if (cache == NULL) {
+        cache = pemalloc(sizeof(striter_cache), 1);
+        zend_hash_init(&cache->entries, 64, NULL, NULL, 1);
+        cache->newest = cache->oldest = NULL;
+        cache->used = 0;
+        STRITER_G(cache) = cache;
+    }
+    
+    key = striter_cache_key(obj->str, obj->mode);
+    entry = zend_hash_index_find_ptr(&cache->entries, key);
+    if (entry != NULL) {
+        if ((entry->indexed || !indexed) && striter_cache_matches(entry, obj)) {
+            return;
+        }
+        striter_cache_remove(cache, entry);
+    }
+    
+    entry = pemalloc(XtOffsetOf(striter_cache_entry, val) + ZSTR_LEN(obj->str) + 1, 1);
+    entry->str = obj->str;
+    entry->mode = obj->mode;
+    entry->count = obj->total_chars;
+    entry->indexed = indexed;
+    entry->checkpoints = NULL;
+    entry->checkpoint_count = 0;
+    entry->index_interval = obj->index_interval;
+    entry->size = size;
+    entry->refcount = 1;
+    entry->permanent = (GC_FLAGS(obj->str) & IS_STR_PERMANENT) != 0;
+    entry->engine = STRITER_G(grapheme_engine);
+    entry->hash = zend_string_hash_val(obj->str);
+    entry->len = ZSTR_LEN(obj->str);
+    memcpy(entry->val, ZSTR_VAL(obj->str), entry->len + 1);
+    if (indexed && obj->checkpoint_count > 0) {
+        entry->checkpoints = safe_pemalloc(obj->checkpoint_count, sizeof(size_t), 0, 1);
+        memcpy(entry->checkpoints, obj->checkpoints, obj->checkpoint_count * sizeof(size_t));
+        entry->checkpoint_count = obj->checkpoint_count;
+    }
+    
+    zend_hash_index_add_new_ptr(&cache->entries, key, entry);
+    striter_cache_push(cache, entry);
+    cache->used += size;
+    striter_cache_trim(cache, (size_t)STRITER_G(cache_size));
+}
+
+// striter.cache_size changed: shrink the cache to the new budget
+void striter_cache_resize(void)
+{
+    if (STRITER_G(cache)) {
+        striter_cache_trim(STRITER_G(cache), (size_t)STRITER_G(cache_size));
+    }
+}
+
+// Start of a request: its interned strings may be cached
+void striter_cache_begin_request(void)
+{
+    STRITER_G(cache_in_request) = 1;
+}
+
+// End of a request: its interned strings are about to be freed
+void striter_cache_end_request(void)
+{
+    striter_cache *cache = STRITER_G(cache);
+    striter_cache_entry *entry, *older;
+    
+    STRITER_G(cache_in_request) = 0;
+    if (cache == NULL) {
+        return;
+    }
+    for (entry = cache->newest; entry != NULL; entry = older) {
+        older = entry->older;
+        if (!entry->permanent) {
+            striter_cache_remove(cache, entry);
+        }
+    }
+}
+
+// Free a thread's cache. Entries still shared by iterators are freed by
+// the last of them.
+void striter_cache_destroy(striter_cache *cache)
+{
+    striter_cache_entry *entry, *older;
+    
+    if (cache == NULL) {
+        return;
+    }
+    for (entry = cache->newest; entry != NULL; entry = older) {
+        older = entry->older;
+        striter_cache_release(entry);
+    }
+    zend_hash_destroy(&cache->entries);
+    pefree(cache, 1);
+}
+
+// phpinfo() rows
+void striter_cache_info(void)
+{
+    striter_cache *cache = STRITER_G(cache);
+    char buf[64];
+    
+    if (STRITER_G(cache_size) == 0) {
+        php_info_print_table_row(2, "Segmentation cache", "disabled (striter.cache_size)");
+        return;
+    }
+    snprintf(buf, sizeof(buf), "%u entries, %zu of " ZEND_LONG_FMT " bytes",
+        cache ? zend_hash_num_elements(&cache->entries) : 0, cache ? cache->used : 0, STRITER_G(cache_size));
+    php_info_print_table_row(2, "Segmentation cache", buf);
+    snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, STRITER_G(cache_hits));
+    php_info_print_table_row(2, "Cache hits", buf);
+    snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, STRITER_G(cache_misses));
+    php_info_print_table_row(2, "Cache misses", buf);
+    snprintf(buf, sizeof(buf), ZEND_ULONG_FMT, STRITER_G(cache_evictions));
+    php_info_print_table_row(2, "Cache evictions", buf);
+}
@@ -0,0 +1,197 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+#include "striter_unicode_tables.h"
+
+// Caseless comparison without folded copies.
+//
+// Both strings are decoded and folded one codepoint at a time, side by
+// side, so comparison stops at the first difference and nothing is
+// allocated. Full folding may turn one codepoint into up to
+// STRITER_FOLD_MAX (ß into ss); the rest of the expansion is held in the
+// folder until it has been compared. Bytes the two strings share are
+// skipped up front, and ASCII is folded without a table lookup. In byte
+// mode only ASCII letters fold, as with strcasecmp(). An invalid UTF-8
+// byte folds to itself above every codepoint, so it only ever matches the
+// same byte.
+
+// Value of an invalid byte in the folded sequence
+#define STRITER_FOLD_INVALID 0x110000
+
+// Folding cursor over one string
+typedef struct _striter_folder {
+    const unsigned char *s;
+    size_t len;
+    size_t pos;                 // Next byte to decode
+    uint32_t pending[STRITER_FOLD_MAX]; // Full folding of the last codepoint
+    uint8_t pending_next;       // Next of pending to return
+    uint8_t pending_count;
+    bool full;                  // Full rather than simple folding
+    bool ascii_only;            // Byte mode: fold ASCII letters only
+} striter_folder;
+
+static void striter_folder_init(striter_folder *folder, zend_string *str, size_t pos, striter_mode_t mode, bool full)
+{
+    folder->s = (const unsigned char *)ZSTR_VAL(str);
+    folder->len = ZSTR_LEN(str);
+    folder->pos = pos;
+    folder->pending_next = folder->pending_count = 0;
+    folder->full = full;
+    folder->ascii_only = mode == STRITER_MODE_BYTE;
+}
+
+// Next value of the folded sequence, or -1 at the end of the string
+static zend_always_inline int32_t striter_fold_next(striter_folder *folder)
+{
+    if (folder->pending_next < folder->pending_count) {
+        return (int32_t)folder->pending[folder->pending_next++];
+    }
+    if (folder->pos >= folder->len) {
+        return -1;
+    }
+    
+    unsigned char c = folder->s[folder->pos];
+    if (c < 0x80 || folder->ascii_only) {
+        folder->pos++;
+        return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+    }
+    
+    size_t advance;
+    int32_t cp = striter_utf8_decode(folder->s + folder->pos, folder->len - folder->pos, &advance);
+    if (cp < 0) {
+        // One byte at a time: only the same bytes match
+        folder->pos++;
+        return STRITER_FOLD_INVALID + c;
+    }
+    folder->pos += advance;
+    
+    uint8_t kind = striter_fold_stage2[
+        ((size_t)striter_fold_stage1[cp >> STRITER_FOLD_SHIFT] << STRITER_FOLD_SHIFT) | (cp & STRITER_FOLD_MASK)
+    ];
+    if (kind == 0) {
+        return cp;
+    }
+    if (folder->full && striter_fold_offsets[kind + 1] > striter_fold_offsets[kind]) {
+        const uint16_t *full = striter_fold_data + striter_fold_offsets[kind];
+        uint8_t count = striter_fold_offsets[kind + 1] - striter_fold_offsets[kind];
+        for (uint8_t i = 1; i < count; i++) {
+            folder->pending[i] = full[i];
+        }
+        folder->pending_next = 1;
+        folder->pending_count = count;
+        return full[0];
+    }
+    return cp + striter_fold_deltas[kind];
+}
+
+// Length of the common prefix of a and b, backed up to the start of a
+// codepoint in both so that folding can resume there. A byte that is not a
+// continuation byte always starts a codepoint or an invalid byte.
+static size_t striter_fold_common_prefix(zend_string *a, zend_string *b, striter_mode_t mode)
+{
+    const unsigned char *s = (const unsigned char *)ZSTR_VAL(a);
+    const unsigned char *t = (const unsigned char *)ZSTR_VAL(b);
+    size_t len = MIN(ZSTR_LEN(a), ZSTR_LEN(b));
+    size_t n = 0;
+    
+    while (n + sizeof(uint64_t) <= len && memcmp(s + n, t + n, sizeof(uint64_t)) == 0) {
+        n += sizeof(uint64_t);
+    }
+    while (n < len && s[n] == t[n]) {
+        n++;
+    }
+    if (mode != STRITER_MODE_BYTE) {
+        while (n > 0 && ((n < ZSTR_LEN(a) && (s[n] & 0xC0) == 0x80) || (n < ZSTR_LEN(b) && (t[n] & 0xC0) == 0x80))) {
+            n--;
+        }
+    }
+    return n;
+}
+
+// str_iter_casecmp function implementation
+PHP_FUNCTION(str_iter_casecmp)
+{
+    zend_string *a;
+    zend_string *b;
+    zend_string *mode = NULL;
+    bool full = 1;
+    
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+        Z_PARAM_STR(a)
+        Z_PARAM_STR(b)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR_OR_NULL(mode)
+        Z_PARAM_BOOL(full)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_mode_t iter_mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    size_t shared = striter_fold_common_prefix(a, b, iter_mode);
+    striter_folder fa, fb;
+    int32_t x, y;
+    
+    // Units are made of whole codepoints, so the first differing unit
+    // holds the first differing codepoint and the mode only matters for
+    // how much is folded
+    striter_folder_init(&fa, a, shared, iter_mode, full);
+    striter_folder_init(&fb, b, shared, iter_mode, full);
+    do {
+        x = striter_fold_next(&fa);
+        y = striter_fold_next(&fb);
+        if (x != y) {
+            RETURN_LONG(x < y ? -1 : 1);
+        }
+    } while (x >= 0);
+    RETURN_LONG(0);
+}
+
+// str_iter_starts_with_folded function implementation
+PHP_FUNCTION(str_iter_starts_with_folded)
+{
+    zend_string *str;
+    zend_string *prefix;
+    zend_string *mode = NULL;
+    bool full = 1;
+    
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+        Z_PARAM_STR(str)
+        Z_PARAM_STR(prefix)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR_OR_NULL(mode)
+        Z_PARAM_BOOL(full)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_mode_t iter_mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    size_t shared = striter_fold_common_prefix(str, prefix, iter_mode);
+    striter_folder fs, fp;
+    int32_t x;
+    
+    striter_folder_init(&fs, str, shared, iter_mode, full);
+    striter_folder_init(&fp, prefix, shared, iter_mode, full);
+    while ((x = striter_fold_next(&fp)) >= 0) {
+        if (striter_fold_next(&fs) != x) {
+            RETURN_FALSE;
+        }
+    }
+    
+    // The match has to end between two units of str: not inside the
+    // folding of a codepoint (s against ß), nor inside a grapheme cluster
+    // (e against e with an accent) or a word
+    if (fs.pending_next < fs.pending_count) {
+        RETURN_FALSE;
+    }
+    if (iter_mode == STRITER_MODE_BYTE || iter_mode == STRITER_MODE_CODEPOINT || fs.pos == ZSTR_LEN(str)) {
+        RETURN_TRUE;
+    }
+    
+    const char *s = ZSTR_VAL(str);
+    size_t len = ZSTR_LEN(str);
+    striter_utf8_run valid_run = {0, 0};
+    size_t pos = 0;
+    while (pos < fs.pos) {
+        pos += striter_unit_length_at(s, len, pos, iter_mode, &valid_run);
+    }
+    RETURN_BOOL(pos == fs.pos);
+}
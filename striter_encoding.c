@@ -0,0 +1,339 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+
+// Iteration over UTF-16 and Latin-1 strings without converting them.
+//
+// The string keeps its encoding and every byte offset of the cursor
+// engine (positions, checkpoints, the unit index, the offsets option) is
+// an offset into it. Units are measured in a window of the string
+// transcoded to UTF-8, which the segmenters work on unchanged, and each
+// unit is transcoded again when it is yielded, so only one window and one
+// unit are ever held in UTF-8. Forward iteration reuses the window from
+// one unit to the next and moves it when a unit gets near its end.
+//
+// Most units never reach the window. A codepoint is decoded on its own,
+// and two codepoints below U+0300 always have a grapheme cluster boundary
+// between them unless they are CR LF: that covers every cluster of a
+// Latin-1 string and of Latin text in UTF-16. Units of a single codepoint
+// up to U+00FF are yielded as interned strings.
+
+// UTF-8 bytes of a fresh window
+#define STRITER_WINDOW_SIZE 4096
+
+// UTF-8 bytes that must follow a unit in the window before it is known to
+// be complete, as for stream iterators: one codepoint for the grapheme and
+// line rules, more for the word and sentence rules that look further ahead
+#define STRITER_WINDOW_LOOKAHEAD 4
+#define STRITER_WINDOW_SEGMENT_LOOKAHEAD 256
+
+// Stand-ins for invalid sequences in a window
+#define STRITER_WINDOW_INVALID_1 0xFE
+#define STRITER_WINDOW_INVALID_2 0xFF
+
+zend_string *striter_latin1_chars[128];
+
+static zend_always_inline int32_t striter_utf16_decode(const unsigned char *s, size_t len, size_t *advance, bool big_endian)
+{
+    if (len < 2) {
+        // A trailing odd byte
+        *advance = 1;
+        return -1;
+    }
+    
+    uint32_t unit = big_endian ? (uint32_t)s[0] << 8 | s[1] : (uint32_t)s[1] << 8 | s[0];
+    *advance = 2;
+    if (unit < 0xD800 || unit > 0xDFFF) {
+        return (int32_t)unit;
+    }
+    if (unit < 0xDC00 && len >= 4) {
+        uint32_t low = big_endian ? (uint32_t)s[2] << 8 | s[3] : (uint32_t)s[3] << 8 | s[2];
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            *advance = 4;
+            return (int32_t)(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+        }
+    }
+    // An unpaired surrogate
+    return -1;
+}
+
+static int32_t striter_decode_utf8(const unsigned char *s, size_t len, size_t *advance)
+{
+    return striter_utf8_decode(s, len, advance);
+}
+
+static int32_t striter_decode_utf16le(const unsigned char *s, size_t len, size_t *advance)
+{
+    return striter_utf16_decode(s, len, advance, 0);
+}
+
+static int32_t striter_decode_utf16be(const unsigned char *s, size_t len, size_t *advance)
+{
+    return striter_utf16_decode(s, len, advance, 1);
+}
+
+static int32_t striter_decode_latin1(const unsigned char *s, size_t len, size_t *advance)
+{
+    *advance = 1;
+    return s[0];
+}
+
+static zend_always_inline size_t striter_encode_utf8(uint32_t cp, char *out)
+{
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | cp >> 12);
+        out[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | cp >> 18);
+    out[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    out[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// The transcoding loop, instantiated once per decoder so that the decoder
+// is inlined into it
+static zend_always_inline size_t striter_transcode_with(const unsigned char *src, size_t src_len, char *out, size_t out_cap,
+        size_t *src_used, striter_decode_func decode)
+{
+    size_t pos = 0;
+    size_t n = 0;
+    size_t advance;
+    
+    while (pos < src_len && n + 4 <= out_cap) {
+        // ASCII needs no decoding in Latin-1
+        if (decode == striter_decode_latin1 && src[pos] < 0x80) {
+            out[n++] = (char)src[pos++];
+            continue;
+        }
+        int32_t cp = decode(src + pos, src_len - pos, &advance);
+        if (cp < 0) {
+            out[n++] = (char)(advance == 1 ? STRITER_WINDOW_INVALID_1 : STRITER_WINDOW_INVALID_2);
+        } else {
+            n += striter_encode_utf8((uint32_t)cp, out + n);
+        }
+        pos += advance;
+    }
+    *src_used = pos;
+    return n;
+}
+
+static size_t striter_transcode_utf16le(const unsigned char *src, size_t src_len, char *out, size_t out_cap, size_t *src_used)
+{
+    return striter_transcode_with(src, src_len, out, out_cap, src_used, striter_decode_utf16le);
+}
+
+static size_t striter_transcode_utf16be(const unsigned char *src, size_t src_len, char *out, size_t out_cap, size_t *src_used)
+{
+    return striter_transcode_with(src, src_len, out, out_cap, src_used, striter_decode_utf16be);
+}
+
+static size_t striter_transcode_latin1(const unsigned char *src, size_t src_len, char *out, size_t out_cap, size_t *src_used)
+{
+    return striter_transcode_with(src, src_len, out, out_cap, src_used, striter_decode_latin1);
+}
+
+// UTF-8 sources are never transcoded
+const striter_decoder striter_decoders[] = {
+    [STRITER_ENCODING_UTF8] = {"UTF-8", "UTF8", 1, striter_decode_utf8, NULL},
+    [STRITER_ENCODING_UTF16LE] = {"UTF-16LE", NULL, 2, striter_decode_utf16le, striter_transcode_utf16le},
+    [STRITER_ENCODING_UTF16BE] = {"UTF-16BE", NULL, 2, striter_decode_utf16be, striter_transcode_utf16be},
+    [STRITER_ENCODING_LATIN1] = {"ISO-8859-1", "Latin-1", 1, striter_decode_latin1, striter_transcode_latin1},
+};
+
+// Look up an encoding by name or alias, ignoring case
+bool striter_parse_encoding(zend_string *name, striter_encoding_t *encoding)
+{
+    for (size_t i = 0; i < sizeof(striter_decoders) / sizeof(striter_decoders[0]); i++) {
+        const striter_decoder *decoder = &striter_decoders[i];
+        if (zend_binary_strcasecmp(ZSTR_VAL(name), ZSTR_LEN(name), decoder->name, strlen(decoder->name)) == 0
+                || (decoder->alias && zend_binary_strcasecmp(ZSTR_VAL(name), ZSTR_LEN(name), decoder->alias, strlen(decoder->alias)) == 0)) {
+            *encoding = (striter_encoding_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Offset of the first invalid sequence in str, or len if there is none
+size_t striter_decoded_validate(striter_encoding_t encoding, const char *str, size_t len)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    striter_decode_func decode = striter_decoders[encoding].decode;
+    size_t pos = 0;
+    size_t advance;
+    
+    if (encoding == STRITER_ENCODING_UTF8) {
+        return striter_utf8_validate(str, len);
+    }
+    if (encoding == STRITER_ENCODING_LATIN1) {
+        return len;
+    }
+    while (pos < len) {
+        if (decode(s + pos, len - pos, &advance) < 0) {
+            return pos;
+        }
+        pos += advance;
+    }
+    return len;
+}
+
+// Source bytes of the UTF-8 text s[0..n) of a window
+static size_t striter_window_source_length(const striter_decoder *decoder, const unsigned char *s, size_t n)
+{
+    size_t pos = 0;
+    size_t source = 0;
+    
+    while (pos < n) {
+        unsigned char c = s[pos];
+        if (c < 0x80) {
+            pos++;
+            source += decoder->unit;
+        } else if (c == STRITER_WINDOW_INVALID_1 || c == STRITER_WINDOW_INVALID_2) {
+            pos++;
+            source += c == STRITER_WINDOW_INVALID_1 ? 1 : 2;
+        } else if (c >= 0xF0) {
+            // Outside the BMP: a surrogate pair
+            pos += 4;
+            source += 2 * decoder->unit;
+        } else {
+            pos += c >= 0xE0 ? 3 : 2;
+            source += decoder->unit;
+        }
+    }
+    return source;
+}
+
+// Transcode the window afresh from pos, holding up to cap bytes
+static void striter_window_fill(striter_string_iterator_obj *obj, size_t pos, size_t cap)
+{
+    striter_decode_window *window = &obj->window;
+    const unsigned char *s = (const unsigned char *)ZSTR_VAL(obj->str);
+    size_t used;
+    
+    if (window->cap < cap) {
+        window->buf = erealloc(window->buf, cap);
+        window->cap = cap;
+    }
+    window->len = striter_decoders[obj->encoding].transcode(s + pos, ZSTR_LEN(obj->str) - pos, window->buf, window->cap, &used);
+    window->start = pos;
+    window->end = pos + used;
+    window->mark = pos;
+    window->mark_at = 0;
+}
+
+// Byte length in the source of the unit starting at pos
+size_t striter_decoded_length(striter_string_iterator_obj *obj, size_t pos)
+{
+    const striter_decoder *decoder = &striter_decoders[obj->encoding];
+    const unsigned char *s = (const unsigned char *)ZSTR_VAL(obj->str);
+    size_t len = ZSTR_LEN(obj->str);
+    size_t advance, next_advance;
+    
+    int32_t cp = decoder->decode(s + pos, len - pos, &advance);
+    if (cp < 0 || obj->mode == STRITER_MODE_CODEPOINT || pos + advance == len) {
+        return advance;
+    }
+    if (obj->mode == STRITER_MODE_GRAPHEME && cp < 0x300) {
+        int32_t next = decoder->decode(s + pos + advance, len - pos - advance, &next_advance);
+        if (next >= 0 && next < 0x300 && !(cp == '\r' && next == '\n')) {
+            return advance;
+        }
+    }
+    
+    // Measure the unit in the window, moving the window to pos unless a
+    // cursor is continuing from the last unit measured in it
+    striter_decode_window *window = &obj->window;
+    size_t lookahead = obj->mode == STRITER_MODE_WORD || obj->mode == STRITER_MODE_SENTENCE
+        ? STRITER_WINDOW_SEGMENT_LOOKAHEAD : STRITER_WINDOW_LOOKAHEAD;
+    size_t at;
+    
+    if (window->buf != NULL && pos == window->mark) {
+        at = window->mark_at;
+    } else {
+        striter_window_fill(obj, pos, MAX(window->cap, STRITER_WINDOW_SIZE));
+        at = 0;
+    }
+    for (;;) {
+        striter_utf8_run valid_run = {0, 0};
+        size_t unit_len = striter_unit_length_at(window->buf, window->len, at, obj->mode, &valid_run);
+    
+        // A unit running close to the end of the window may go on past it
+        if (window->end == len || at + unit_len + lookahead <= window->len) {
+            size_t source = striter_window_source_length(decoder, (const unsigned char *)window->buf + at, unit_len);
+            window->mark = pos + source;
+            window->mark_at = at + unit_len;
+            return source;
+        }
+        striter_window_fill(obj, pos, at == 0 ? window->cap * 2 : window->cap);
+        at = 0;
+    }
+}
+
+// The source bytes str[pos..pos + len) in UTF-8, with U+FFFD for invalid
+// sequences
+zend_string *striter_decoded_string(striter_string_iterator_obj *obj, size_t pos, size_t len)
+{
+    const striter_decoder *decoder = &striter_decoders[obj->encoding];
+    const unsigned char *s = (const unsigned char *)ZSTR_VAL(obj->str) + pos;
+    size_t advance;
+    
+    int32_t cp = decoder->decode(s, len, &advance);
+    if (advance == len) {
+        if (cp < 0) {
+            return striter_replacement_char;
+        }
+        if (cp < 0x80) {
+            return ZSTR_CHAR((zend_uchar)cp);
+        }
+        if (cp < 0x100) {
+            return striter_latin1_chars[cp - 0x80];
+        }
+    }
+    
+    // Size the result, then transcode into it
+    size_t out_len = 0;
+    for (size_t i = 0; i < len; i += advance) {
+        cp = decoder->decode(s + i, len - i, &advance);
+        out_len += cp < 0 ? 3 : cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+    }
+    
+    zend_string *result = zend_string_alloc(out_len, 0);
+    char *out = ZSTR_VAL(result);
+    for (size_t i = 0; i < len; i += advance) {
+        cp = decoder->decode(s + i, len - i, &advance);
+        if (cp < 0) {
+            memcpy(out, "\xEF\xBF\xBD", 3);
+            out += 3;
+        } else {
+            out += striter_encode_utf8((uint32_t)cp, out);
+        }
+    }
+    *out = '\0';
+    return result;
+}
+
+void striter_decode_window_free(striter_decode_window *window)
+{
+    if (window->buf) {
+        efree(window->buf);
+    }
+    window->buf = NULL;
+    window->len = window->cap = 0;
+    window->start = window->end = 0;
+    window->mark = window->mark_at = 0;
+}
@@ -0,0 +1,122 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_streams.h"
+#include "php_striter.h"
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#include <sys/mman.h>
+#include <unistd.h>
+#define STRITER_USE_MMAP 1
+#endif
+
+#ifdef STRITER_USE_MMAP
+// Map the file behind fd and put a zend_string header in front of it, so
+// the iterator segments the mapped pages directly. The layout is one
+// anonymous page holding the header, then the file mapped MAP_SHARED
+// (shared with every process reading the same file through the page
+// cache), then one anonymous zero page that provides the terminating NUL
+// when the file size is a multiple of the page size.
+static zend_string *striter_file_map(int fd, size_t size, void **mapping, size_t *mapping_len)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t data_len = ZEND_MM_ALIGNED_SIZE_EX(size, page);
+    size_t total = page + data_len + page;
+    
+    char *base = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    if (mmap(base + page, size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, total);
+        return NULL;
+    }
+    
+#ifdef HAVE_MADVISE
+    madvise(base + page, size, MADV_SEQUENTIAL);
+#endif
+    
+    // The header is never freed as a string: the iterator unmaps the whole
+    // region instead (see striter_string_iterator_release_str). It is only
+    // used by the request that mapped it, which GC_PERSISTENT_LOCAL tells
+    // the refcount checks of debug builds.
+    zend_string *str = (zend_string *)(base + page - _ZSTR_HEADER_SIZE);
+    GC_SET_REFCOUNT(str, 1);
+    GC_TYPE_INFO(str) = GC_STRING | ((IS_STR_PERSISTENT | GC_PERSISTENT_LOCAL) << GC_FLAGS_SHIFT);
+    ZSTR_H(str) = 0;
+    ZSTR_LEN(str) = size;
+    
+    *mapping = base;
+    *mapping_len = total;
+    return str;
+}
+#endif
+
+// Release a region created by striter_file_map()
+void striter_file_unmap(void *mapping, size_t mapping_len)
+{
+#ifdef STRITER_USE_MMAP
+    munmap(mapping, mapping_len);
+#endif
+}
+
+// str_iter_file function implementation
+PHP_FUNCTION(str_iter_file)
+{
+    zend_string *path;
+    zend_string *mode = NULL;
+    php_stream *stream;
+    zend_string *str = NULL;
+    void *mapping = NULL;
+    size_t mapping_len = 0;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_PATH_STR(path)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR(mode)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    stream = php_stream_open_wrapper(ZSTR_VAL(path), "rb", REPORT_ERRORS, NULL);
+    if (stream == NULL) {
+        RETURN_FALSE;
+    }
+    
+#ifdef STRITER_USE_MMAP
+    // Plain files are mapped; the cost does not depend on the file size.
+    // Devices, pipes and the like may not map, or map something else than
+    // what reading them gives, so they are read like other streams.
+    php_stream_statbuf ssb;
+    int fd;
+    if (php_stream_stat(stream, &ssb) == 0 && S_ISREG(ssb.sb.st_mode) && ssb.sb.st_size > 0
+        && php_stream_can_cast(stream, PHP_STREAM_AS_FD) == SUCCESS
+        && php_stream_cast(stream, PHP_STREAM_AS_FD, (void **)&fd, 0) == SUCCESS) {
+        str = striter_file_map(fd, (size_t)ssb.sb.st_size, &mapping, &mapping_len);
+    }
+#endif
+    
+    // Other streams (and platforms without mmap) are read into memory
+    if (str == NULL) {
+        str = php_stream_copy_to_mem(stream, PHP_STREAM_COPY_ALL, 0);
+        if (str == NULL) {
+            str = ZSTR_EMPTY_ALLOC();
+        }
+    }
+    php_stream_close(stream);
+    
+    striter_options opts;
+    memset(&opts, 0, sizeof(opts));
+    
+    object_init_ex(return_value, striter_string_iterator_ce);
+    striter_string_iterator_obj *obj = striter_string_iterator_from_obj(Z_OBJ_P(return_value));
+    
+    striter_string_iterator_setup(obj, str, mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME, &opts);
+    if (mapping) {
+        obj->mapping = mapping;
+        obj->mapping_len = mapping_len;
+    } else {
+        // setup() took its own reference
+        zend_string_release(str);
+    }
+}
@@ -0,0 +1,199 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+#include "striter_unicode_tables.h"
+
+// Native UAX #29 extended grapheme cluster segmentation.
+//
+// Codepoints are classified through the generated two-stage
+// Grapheme_Cluster_Break table, and each boundary is decided by the
+// generated (previous, current) rule table. The only context the pair
+// table cannot carry is kept in two small counters: the GB11 emoji ZWJ
+// sequence state and the length of the current Regional_Indicator run.
+
+// GB11 state: nothing, \p{ExtPict} Extend*, or \p{ExtPict} Extend* ZWJ
+#define STRITER_GB11_NONE 0
+#define STRITER_GB11_PICT 1
+#define STRITER_GB11_ZWJ  2
+
+static zend_always_inline uint8_t striter_gcb_class(uint32_t cp)
+{
+    return striter_gcb_stage2[
+        ((size_t)striter_gcb_stage1[cp >> STRITER_GCB_SHIFT] << STRITER_GCB_SHIFT) | (cp & STRITER_GCB_MASK)
+    ];
+}
+
+static zend_always_inline int striter_gb11_next(int state, uint8_t cls)
+{
+    switch (cls) {
+        case STRITER_GCB_EXTENDED_PICTOGRAPHIC:
+            return STRITER_GB11_PICT;
+        case STRITER_GCB_EXTEND:
+            return state == STRITER_GB11_PICT ? STRITER_GB11_PICT : STRITER_GB11_NONE;
+        case STRITER_GCB_ZWJ:
+            return state == STRITER_GB11_PICT ? STRITER_GB11_ZWJ : STRITER_GB11_NONE;
+        default:
+            return STRITER_GB11_NONE;
+    }
+}
+
+// Byte length of the grapheme cluster starting at pos.
+// Invalid UTF-8 sequences are returned as units of their own, like in
+// codepoint mode, and never join a cluster.
+size_t striter_grapheme_length_native(const char *str, size_t len, size_t pos)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    size_t advance;
+    
+    if (pos >= len) {
+        return 0;
+    }
+    
+    // An ASCII byte followed by another ASCII byte is a complete cluster,
+    // unless the two are CR LF
+    if (s[pos] < 0x80 && (pos + 1 == len
+            || (s[pos + 1] < 0x80 && !(s[pos] == '\r' && s[pos + 1] == '\n')))) {
+        return 1;
+    }
+    
+    int32_t cp = striter_utf8_decode(s + pos, len - pos, &advance);
+    if (cp < 0) {
+        return advance;
+    }
+    
+    size_t end = pos + advance;
+    uint8_t prev = striter_gcb_class(cp);
+    int gb11 = striter_gb11_next(STRITER_GB11_NONE, prev);
+    size_t ri_run = prev == STRITER_GCB_REGIONAL_INDICATOR;
+    
+    while (end < len) {
+        cp = striter_utf8_decode(s + end, len - end, &advance);
+        if (cp < 0) {
+            break;
+        }
+        
+        uint8_t cur = striter_gcb_class(cp);
+        switch (striter_gcb_rules[prev][cur]) {
+            case STRITER_GB_BREAK:
+                return end - pos;
+            case STRITER_GB_NO_BREAK_EMOJI:
+                if (gb11 != STRITER_GB11_ZWJ) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_GB_NO_BREAK_RI:
+                if (ri_run % 2 == 0) {
+                    return end - pos;
+                }
+                break;
+        }
+        
+        gb11 = striter_gb11_next(gb11, cur);
+        ri_run = cur == STRITER_GCB_REGIONAL_INDICATOR ? ri_run + 1 : 0;
+        prev = cur;
+        end += advance;
+    }
+    
+    return end - pos;
+}
+
+// Whether pos is a cluster boundary whatever comes before it, so that
+// segmentation can restart there (used to split work between threads).
+// That holds when the codepoints on both sides are valid and their pair
+// rule is a plain break: only GB11 and GB12/13 depend on earlier context,
+// and those have their own rule values. The codepoint before pos must
+// also start at a lead byte, which every decoder lands on.
+bool striter_grapheme_is_safe_break(const char *str, size_t len, size_t pos)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    size_t advance;
+    
+    if (pos == 0 || pos >= len) {
+        return 1;
+    }
+    
+    size_t lead = pos - 1;
+    while (lead > 0 && pos - lead < 4 && (s[lead] & 0xC0) == 0x80) {
+        lead--;
+    }
+    
+    int32_t before = striter_utf8_decode(s + lead, len - lead, &advance);
+    if (before < 0 || lead + advance != pos) {
+        return 0;
+    }
+    int32_t after = striter_utf8_decode(s + pos, len - pos, &advance);
+    if (after < 0) {
+        return 0;
+    }
+    
+    return striter_gcb_rules[striter_gcb_class(before)][striter_gcb_class(after)] == STRITER_GB_BREAK;
+}
+
+// Extended_Pictographic, for the word rules (WB3c)
+bool striter_is_extended_pictographic(uint32_t cp)
+{
+    return striter_gcb_class(cp) == STRITER_GCB_EXTENDED_PICTOGRAPHIC;
+}
+
+// Count grapheme clusters with the native segmenter
+size_t striter_count_graphemes_native(const char *str, size_t len)
+{
+    return striter_count_graphemes_native_with(str, len, STRITER_G(ascii_span));
+}
+
+// Same, with an explicit ASCII kernel, for threads without module globals
+size_t striter_count_graphemes_native_with(const char *str, size_t len, striter_ascii_span_func ascii_span)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    size_t count = 0;
+    size_t pos = 0;
+    
+    while (pos < len) {
+        if (s[pos] < 0x80) {
+            // Inside an ASCII run every byte is a cluster except for CR LF
+            // pairs. The last byte of a run may still take combining marks
+            // from what follows, and a trailing CR may pair with an LF, so
+            // both are left to the full rules.
+            size_t run = ascii_span(s + pos, len - pos);
+            size_t n = pos + run < len ? run - 1 : run;
+            if (n > 0 && s[pos + n - 1] == '\r') {
+                n--;
+            }
+            count += n - striter_count_crlf(s + pos, n);
+            pos += n;
+            if (pos >= len) {
+                break;
+            }
+        }
+        pos += striter_grapheme_length_native(str, len, pos);
+        count++;
+    }
+    
+    return count;
+}
+
+// Byte length of the grapheme cluster at pos using the configured engine.
+// valid_run is only used by the PCRE2 engine.
+size_t striter_grapheme_length(const char *str, size_t len, size_t pos, striter_utf8_run *valid_run)
+{
+#ifdef HAVE_PCRE2
+    if (STRITER_G(grapheme_engine) == STRITER_ENGINE_PCRE2) {
+        return striter_grapheme_length_pcre2(str, len, pos, valid_run);
+    }
+#endif
+    return striter_grapheme_length_native(str, len, pos);
+}
+
+// Count grapheme clusters using the configured engine
+size_t striter_count_graphemes(const char *str, size_t len)
+{
+#ifdef HAVE_PCRE2
+    if (STRITER_G(grapheme_engine) == STRITER_ENGINE_PCRE2) {
+        return striter_count_graphemes_pcre2(str, len);
+    }
+#endif
+    return striter_count_graphemes_native(str, len);
+}
@@ -0,0 +1,131 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+
+// Compact unit index for the indexed option.
+//
+// The sparse checkpoints of an iterator cost nothing until a cursor walks
+// the string, but every lookup still segments up to index_interval units.
+// The unit index trades memory for that: the first pass records the
+// length of every unit, one byte each, so a lookup only adds up byte
+// deltas from the start of its block and never segments anything. Units
+// of 256 bytes or more (long ZWJ sequences, unbroken words, lines) are
+// stored as the escape 0 with their length in a side table. With the
+// absolute offset at the start of every block, the index takes about
+// 1.25 bytes per unit, against the 8 of a size_t per unit.
+
+striter_unit_index *striter_unit_index_create(void)
+{
+    striter_unit_index *index = emalloc(sizeof(striter_unit_index));
+    
+    index->lengths = NULL;
+    index->count = 0;
+    index->cap = 0;
+    index->blocks = NULL;
+    index->long_lengths = NULL;
+    index->long_count = 0;
+    index->long_cap = 0;
+    index->end = 0;
+    return index;
+}
+
+// Record the unit after the last one recorded
+void striter_unit_index_append(striter_unit_index *index, size_t unit_len)
+{
+    if (index->count == index->cap) {
+        index->cap = index->cap ? index->cap * 2 : 4 * STRITER_UNIT_BLOCK;
+        index->lengths = safe_erealloc(index->lengths, index->cap, 1, 0);
+        index->blocks = safe_erealloc(index->blocks, index->cap / STRITER_UNIT_BLOCK, sizeof(striter_unit_block), 0);
+    }
+    if (index->count % STRITER_UNIT_BLOCK == 0) {
+        striter_unit_block *block = &index->blocks[index->count / STRITER_UNIT_BLOCK];
+        block->offset = index->end;
+        block->long_index = index->long_count;
+    }
+    
+    if (unit_len <= UINT8_MAX) {
+        index->lengths[index->count] = (uint8_t)unit_len;
+    } else {
+        if (index->long_count == index->long_cap) {
+            index->long_cap = index->long_cap ? index->long_cap * 2 : 16;
+            index->long_lengths = safe_erealloc(index->long_lengths, index->long_cap, sizeof(size_t), 0);
+        }
+        index->long_lengths[index->long_count++] = unit_len;
+        index->lengths[index->count] = 0;
+    }
+    index->count++;
+    index->end += unit_len;
+}
+
+// The whole string is recorded: give back what doubling over-allocated
+void striter_unit_index_shrink(striter_unit_index *index)
+{
+    size_t cap = (index->count + STRITER_UNIT_BLOCK - 1) / STRITER_UNIT_BLOCK * STRITER_UNIT_BLOCK;
+    
+    if (cap > 0 && cap < index->cap) {
+        index->cap = cap;
+        index->lengths = erealloc(index->lengths, cap);
+        index->blocks = erealloc(index->blocks, cap / STRITER_UNIT_BLOCK * sizeof(striter_unit_block));
+    }
+    if (index->long_count > 0 && index->long_count < index->long_cap) {
+        index->long_cap = index->long_count;
+        index->long_lengths = erealloc(index->long_lengths, index->long_cap * sizeof(size_t));
+    }
+}
+
+// Byte offset of unit i (i < count). If unit_len is not NULL, it is set to
+// the length of the unit. Costs at most STRITER_UNIT_BLOCK - 1 additions.
+size_t striter_unit_index_offset(const striter_unit_index *index, size_t i, size_t *unit_len)
+{
+    const striter_unit_block *block = &index->blocks[i / STRITER_UNIT_BLOCK];
+    size_t offset = block->offset;
+    size_t long_index = block->long_index;
+    
+    for (size_t k = i - i % STRITER_UNIT_BLOCK; k < i; k++) {
+        uint8_t delta = index->lengths[k];
+        offset += delta ? delta : index->long_lengths[long_index++];
+    }
+    if (unit_len) {
+        *unit_len = index->lengths[i] ? index->lengths[i] : index->long_lengths[long_index];
+    }
+    return offset;
+}
+
+// Byte length of unit i (i < count)
+size_t striter_unit_index_length(const striter_unit_index *index, size_t i)
+{
+    if (index->lengths[i]) {
+        return index->lengths[i];
+    }
+    
+    // A long unit: its length is after those of the long units before it
+    size_t long_index = index->blocks[i / STRITER_UNIT_BLOCK].long_index;
+    for (size_t k = i - i % STRITER_UNIT_BLOCK; k < i; k++) {
+        long_index += index->lengths[k] == 0;
+    }
+    return index->long_lengths[long_index];
+}
+
+// Bytes allocated for the index
+size_t striter_unit_index_size(const striter_unit_index *index)
+{
+    return sizeof(striter_unit_index)
+        + index->cap
+        + index->cap / STRITER_UNIT_BLOCK * sizeof(striter_unit_block)
+        + index->long_cap * sizeof(size_t);
+}
+
+void striter_unit_index_free(striter_unit_index *index)
+{
+    if (index->lengths) {
+        efree(index->lengths);
+        efree(index->blocks);
+    }
+    if (index->long_lengths) {
+        efree(index->long_lengths);
+    }
+    efree(index);
+}
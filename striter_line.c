@@ -0,0 +1,311 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+#include "striter_unicode_tables.h"
+
+// Native UAX #14 line breaking and display-width aware wrapping.
+//
+// Codepoints are classified through the generated two-stage Line_Break
+// table, with LB1 already resolved by the generator. Hard breaks, spaces,
+// ZW, ZWJ and combining marks (LB4-LB10) are handled here; every other
+// rule is in the generated (previous, current) pair table, whose values
+// say whether a pair breaks when adjacent, when separated by spaces, or
+// depends on the Regional_Indicator run (LB30a) or on an HL before a
+// hyphen (LB21a). A line segment is the text up to the next break
+// opportunity: a word with its trailing spaces, a hyphenated part, or a
+// single ideograph. No language tailoring is applied.
+
+static zend_always_inline uint8_t striter_lb_class(uint32_t cp)
+{
+    return striter_lb_stage2[
+        ((size_t)striter_lb_stage1[cp >> STRITER_LB_SHIFT] << STRITER_LB_SHIFT) | (cp & STRITER_LB_MASK)
+    ];
+}
+
+static zend_always_inline uint8_t striter_width_class(uint32_t cp)
+{
+    return striter_width_stage2[
+        ((size_t)striter_width_stage1[cp >> STRITER_WIDTH_SHIFT] << STRITER_WIDTH_SHIFT) | (cp & STRITER_WIDTH_MASK)
+    ];
+}
+
+// Decode the codepoint at pos, with ASCII kept out of the decoder
+static zend_always_inline int32_t striter_line_decode(const unsigned char *s, size_t len, size_t pos, size_t *advance)
+{
+    if (s[pos] < 0x80) {
+        *advance = 1;
+        return s[pos];
+    }
+    return striter_utf8_decode(s + pos, len - pos, advance);
+}
+
+static zend_always_inline bool striter_lb_is_hard(int cls)
+{
+    return cls == STRITER_LB_BK || cls == STRITER_LB_CR || cls == STRITER_LB_LF || cls == STRITER_LB_NL;
+}
+
+// Byte length of the line segment starting at pos. If mandatory is not
+// NULL, it is set when the segment ends with a hard line break.
+size_t striter_line_length(const char *str, size_t len, size_t pos, bool *mandatory)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    size_t advance;
+    
+    if (mandatory) {
+        *mandatory = 0;
+    }
+    if (pos >= len) {
+        return 0;
+    }
+    
+    int32_t cp = striter_line_decode(s, len, pos, &advance);
+    if (cp < 0) {
+        return advance;
+    }
+    
+    size_t end = pos + advance;
+    uint8_t raw = striter_lb_class(cp);     // Class of the codepoint just before end
+    uint8_t prev = raw;                     // Class the pair rules see (LB9, LB10)
+    int prev2 = -1;                         // The one before prev, if adjacent (LB21a)
+    bool spaces = 0;                        // Spaces between prev and end
+    size_t ri_run = raw == STRITER_LB_RI;
+    
+    if (raw == STRITER_LB_CM || raw == STRITER_LB_ZWJ) {
+        prev = STRITER_LB_AL;                                   // LB10
+    } else if (raw == STRITER_LB_SP) {
+        prev = STRITER_LB_WJ;                                   // No break at sot
+        spaces = 1;
+    }
+    
+    while (end < len) {
+        if (striter_lb_is_hard(raw)) {
+            // LB4, LB5: CR LF stays together, everything else breaks
+            if (raw != STRITER_LB_CR || s[end] != '\n') {
+                break;
+            }
+        }
+    
+        cp = striter_line_decode(s, len, end, &advance);
+        if (cp < 0) {
+            return end - pos;
+        }
+    
+        uint8_t cur = striter_lb_class(cp);
+    
+        if (striter_lb_is_hard(cur) || cur == STRITER_LB_ZW) {
+            goto no_break;                                      // LB6, LB7
+        }
+        if (cur == STRITER_LB_SP) {
+            raw = cur;                                          // LB7
+            spaces = 1;
+            end += advance;
+            continue;
+        }
+        if (prev == STRITER_LB_ZW) {
+            return end - pos;                                   // LB8
+        }
+        if (cur == STRITER_LB_CM || cur == STRITER_LB_ZWJ) {
+            if (!spaces) {
+                raw = cur;                                      // LB9
+                end += advance;
+                continue;
+            }
+            cur = STRITER_LB_AL;                                // LB10
+        }
+        if (raw == STRITER_LB_ZWJ) {
+            goto no_break;                                      // LB8a
+        }
+    
+        switch (striter_lb_rules[prev][cur]) {
+            case STRITER_LBR_BREAK:
+                return end - pos;
+            case STRITER_LBR_INDIRECT:
+                if (spaces) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_LBR_RI:
+                if (spaces || ri_run % 2 == 0) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_LBR_HL_HY:
+                if (spaces || prev2 != STRITER_LB_HL) {
+                    return end - pos;
+                }
+                break;
+        }
+    
+no_break:
+        ri_run = cur == STRITER_LB_RI ? ri_run + 1 : 0;
+        prev2 = spaces ? -1 : prev;
+        prev = cur;
+        raw = striter_lb_class(cp);
+        spaces = 0;
+        end += advance;
+    }
+    
+    if (mandatory) {
+        *mandatory = striter_lb_is_hard(raw);
+    }
+    return end - pos;
+}
+
+// Count line segments
+size_t striter_count_line_segments(const char *str, size_t len)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    
+    while (pos < len) {
+        pos += striter_line_length(str, len, pos, NULL);
+        count++;
+    }
+    return count;
+}
+
+// Display width of the grapheme cluster s[0..len) in terminal columns:
+// that of its first codepoint with a nonzero width, 2 for emoji turned
+// into emoji presentation by U+FE0F and for flags. Invalid sequences are
+// shown as U+FFFD, one column wide. Control characters take none.
+static size_t striter_cluster_width(const unsigned char *s, size_t len)
+{
+    size_t pos = 0;
+    size_t advance;
+    size_t width = 0;
+    bool pict = 0;
+    
+    if (len == 1 && s[0] < 0x80) {
+        return s[0] >= 0x20 && s[0] < 0x7F;
+    }
+    
+    while (pos < len) {
+        int32_t cp = striter_line_decode(s, len, pos, &advance);
+        if (cp < 0) {
+            return 1;
+        }
+        if (cp == 0xFE0F && pict) {
+            return 2;
+        }
+        if (width == 0) {
+            width = striter_width_class(cp);
+            pict = striter_is_extended_pictographic(cp);
+        }
+        pos += advance;
+    }
+    
+    // A pair of Regional_Indicators is a flag
+    if (len == 8 && s[0] == 0xF0 && s[1] == 0x9F && s[2] == 0x87 && s[3] >= 0xA6) {
+        return 2;
+    }
+    return width;
+}
+
+// Columns of the line segment s[0..len), without its trailing spaces and
+// hard break (text) and of those alone (space). Trailing spaces hang past
+// the end of a line. text_len is set to the byte length of the text part.
+static void striter_line_measure(const unsigned char *s, size_t len, size_t *text, size_t *space, size_t *text_len)
+{
+    size_t pos = 0;
+    size_t advance;
+    
+    *text = *space = *text_len = 0;
+    while (pos < len) {
+        size_t cluster = striter_grapheme_length_native((const char *)s, len, pos);
+        size_t width = striter_cluster_width(s + pos, cluster);
+        int32_t cp = striter_line_decode(s, len, pos, &advance);
+    
+        pos += cluster;
+        if (cp >= 0 && (striter_lb_class(cp) == STRITER_LB_SP || striter_lb_is_hard(striter_lb_class(cp)))) {
+            *space += width;
+        } else {
+            *text += *space + width;
+            *space = 0;
+            *text_len = pos;
+        }
+    }
+}
+
+// Append str[start..end) to the chunk array
+static void striter_wrap_add(zval *chunks, zend_string *str, size_t start, size_t end)
+{
+    add_next_index_str(chunks, striter_substring(str, start, end));
+}
+
+// str_iter_wrap function implementation
+PHP_FUNCTION(str_iter_wrap)
+{
+    zend_string *str;
+    zend_long width;
+    bool cut = 1;
+    
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_STR(str)
+        Z_PARAM_LONG(width)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_BOOL(cut)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    if (width < 1) {
+        zend_argument_value_error(2, "must be greater than 0");
+        RETURN_THROWS();
+    }
+    
+    const unsigned char *s = (const unsigned char *)ZSTR_VAL(str);
+    size_t len = ZSTR_LEN(str);
+    size_t limit = (size_t)width;
+    size_t line_start = 0;      // Start of the chunk being filled
+    size_t line_width = 0;      // Its columns so far, trailing spaces included
+    size_t pos = 0;
+    
+    array_init(return_value);
+    
+    // Line segments are added to the chunk while they fit; one that does
+    // not starts the next chunk, and one that fits no chunk is cut between
+    // grapheme clusters
+    while (pos < len) {
+        bool mandatory;
+        size_t text, space, text_len;
+        size_t seg_len = striter_line_length(ZSTR_VAL(str), len, pos, &mandatory);
+    
+        striter_line_measure(s + pos, seg_len, &text, &space, &text_len);
+        if (pos > line_start && line_width + text > limit) {
+            striter_wrap_add(return_value, str, line_start, pos);
+            line_start = pos;
+            line_width = 0;
+        }
+    
+        if (text > limit && cut) {
+            size_t p = pos;
+            line_width = 0;
+            while (p < pos + text_len) {
+                size_t cluster = striter_grapheme_length_native(ZSTR_VAL(str), pos + text_len, p);
+                size_t w = striter_cluster_width(s + p, cluster);
+                if (p > line_start && line_width + w > limit) {
+                    striter_wrap_add(return_value, str, line_start, p);
+                    line_start = p;
+                    line_width = 0;
+                }
+                line_width += w;
+                p += cluster;
+            }
+            line_width += space;
+        } else {
+            line_width += text + space;
+        }
+    
+        pos += seg_len;
+        if (mandatory) {
+            striter_wrap_add(return_value, str, line_start, pos);
+            line_start = pos;
+            line_width = 0;
+        }
+    }
+    
+    if (line_start < len) {
+        striter_wrap_add(return_value, str, line_start, len);
+    }
+}
@@ -0,0 +1,297 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+#include "striter_unicode_tables.h"
+
+// Unicode normalization (UAX #15) of the units an iterator yields.
+//
+// Each unit is normalized on its own when it is yielded, right after the
+// segmenter has measured it. Every mark with a nonzero combining class and
+// the second codepoint of every primary composite has Grapheme_Cluster_Break
+// Extend or SpacingMark, or is a Hangul jamo held by GB6-GB8, so neither
+// reordering nor composition ever crosses a grapheme cluster boundary:
+// normalizing the clusters one by one gives the string's normalization.
+// The quick check comes first. Codepoints below U+0300 are all NFC_QC=Yes
+// with combining class 0, and those below U+00C0 NFD_QC=Yes, so for most
+// Latin text a byte comparison settles it and the unit is yielded as is.
+// Invalid UTF-8 sequences block reordering and composition like a starter
+// that composes with nothing, and are copied through (or substituted).
+
+#define STRITER_HANGUL_S_BASE 0xAC00
+#define STRITER_HANGUL_L_BASE 0x1100
+#define STRITER_HANGUL_V_BASE 0x1161
+#define STRITER_HANGUL_T_BASE 0x11A7
+#define STRITER_HANGUL_L_COUNT 19
+#define STRITER_HANGUL_V_COUNT 21
+#define STRITER_HANGUL_T_COUNT 28
+#define STRITER_HANGUL_N_COUNT (STRITER_HANGUL_V_COUNT * STRITER_HANGUL_T_COUNT)
+#define STRITER_HANGUL_S_COUNT (STRITER_HANGUL_L_COUNT * STRITER_HANGUL_N_COUNT)
+
+// Codepoints normalized on the stack before falling back to the heap
+#define STRITER_NORM_STACK 64
+
+static zend_always_inline uint16_t striter_norm_props(uint32_t cp)
+{
+    return striter_norm_stage2[
+        ((size_t)striter_norm_stage1[cp >> STRITER_NORM_SHIFT] << STRITER_NORM_SHIFT) | (cp & STRITER_NORM_MASK)
+    ];
+}
+
+// Lowest byte that can start a codepoint the quick check has to look at
+static zend_always_inline unsigned char striter_norm_first_byte(striter_norm_t form)
+{
+    return form == STRITER_NORM_NFC ? 0xCC : 0xC3;
+}
+
+// Whether s[0..len) is certainly in the form already
+static bool striter_norm_quick_check(const unsigned char *s, size_t len, striter_norm_t form)
+{
+    unsigned char first = striter_norm_first_byte(form);
+    uint8_t last_ccc = 0;
+    size_t pos = 0;
+    size_t advance;
+    
+    while (pos < len) {
+        if (s[pos] < first) {
+            pos++;
+            last_ccc = 0;
+            continue;
+        }
+    
+        int32_t cp = striter_utf8_decode(s + pos, len - pos, &advance);
+        if (cp < 0) {
+            return 0;
+        }
+    
+        uint16_t props = striter_norm_props((uint32_t)cp);
+        uint8_t ccc = STRITER_NORM_CCC(props);
+        if (ccc != 0 && last_ccc > ccc) {
+            return 0;
+        }
+        if (form == STRITER_NORM_NFC ? STRITER_NORM_NFC_QC(props) != STRITER_NFC_QC_YES : STRITER_NORM_NFD_NO(props)) {
+            return 0;
+        }
+        last_ccc = ccc;
+        pos += advance;
+    }
+    return 1;
+}
+
+// Append the full canonical decomposition of cp to out
+static size_t striter_norm_decompose(uint32_t cp, uint32_t *out)
+{
+    if (cp >= STRITER_HANGUL_S_BASE && cp < STRITER_HANGUL_S_BASE + STRITER_HANGUL_S_COUNT) {
+        uint32_t s = cp - STRITER_HANGUL_S_BASE;
+        out[0] = STRITER_HANGUL_L_BASE + s / STRITER_HANGUL_N_COUNT;
+        out[1] = STRITER_HANGUL_V_BASE + s % STRITER_HANGUL_N_COUNT / STRITER_HANGUL_T_COUNT;
+        if (s % STRITER_HANGUL_T_COUNT == 0) {
+            return 2;
+        }
+        out[2] = STRITER_HANGUL_T_BASE + s % STRITER_HANGUL_T_COUNT;
+        return 3;
+    }
+    
+    if (STRITER_NORM_NFD_NO(striter_norm_props(cp))) {
+        size_t lo = 0, hi = STRITER_DECOMP_COUNT;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (striter_decomp_cps[mid] < cp) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        size_t n = striter_decomp_offsets[lo + 1] - striter_decomp_offsets[lo];
+        for (size_t i = 0; i < n; i++) {
+            out[i] = striter_decomp_data[striter_decomp_offsets[lo] + i];
+        }
+        return n;
+    }
+    
+    out[0] = cp;
+    return 1;
+}
+
+// Primary composite of first and second, or 0
+static uint32_t striter_norm_compose(uint32_t first, uint32_t second)
+{
+    if (first >= STRITER_HANGUL_L_BASE && first < STRITER_HANGUL_L_BASE + STRITER_HANGUL_L_COUNT
+            && second >= STRITER_HANGUL_V_BASE && second < STRITER_HANGUL_V_BASE + STRITER_HANGUL_V_COUNT) {
+        return STRITER_HANGUL_S_BASE
+            + ((first - STRITER_HANGUL_L_BASE) * STRITER_HANGUL_V_COUNT + second - STRITER_HANGUL_V_BASE) * STRITER_HANGUL_T_COUNT;
+    }
+    if (first >= STRITER_HANGUL_S_BASE && first < STRITER_HANGUL_S_BASE + STRITER_HANGUL_S_COUNT
+            && (first - STRITER_HANGUL_S_BASE) % STRITER_HANGUL_T_COUNT == 0
+            && second > STRITER_HANGUL_T_BASE && second < STRITER_HANGUL_T_BASE + STRITER_HANGUL_T_COUNT) {
+        return first + second - STRITER_HANGUL_T_BASE;
+    }
+    
+    uint64_t key = (uint64_t)first << 21 | second;
+    size_t lo = 0, hi = STRITER_COMP_COUNT;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (striter_comp_pairs[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < STRITER_COMP_COUNT && striter_comp_pairs[lo] == key ? striter_comp_results[lo] : 0;
+}
+
+// Normalize the codepoints cps[0..n), decomposed already, in place:
+// canonical ordering, then for NFC canonical composition. Returns the new
+// number of codepoints.
+static size_t striter_norm_finish(uint32_t *cps, size_t n, striter_norm_t form)
+{
+    // Stable insertion sort of each run of nonzero combining classes
+    for (size_t i = 1; i < n; i++) {
+        uint8_t ccc = STRITER_NORM_CCC(striter_norm_props(cps[i]));
+        if (ccc == 0) {
+            continue;
+        }
+        uint32_t cp = cps[i];
+        size_t j = i;
+        while (j > 0) {
+            uint8_t prev = STRITER_NORM_CCC(striter_norm_props(cps[j - 1]));
+            if (prev <= ccc) {
+                break;
+            }
+            cps[j] = cps[j - 1];
+            j--;
+        }
+        cps[j] = cp;
+    }
+    if (form != STRITER_NORM_NFC || n < 2) {
+        return n;
+    }
+    
+    // A codepoint composes with the last starter unless a codepoint of the
+    // same or a higher class stands between them. A leading nonstarter has
+    // no starter to compose with.
+    size_t starter = 0;
+    int last_ccc = STRITER_NORM_CCC(striter_norm_props(cps[0])) ? 256 : 0;
+    size_t out = 1;
+    for (size_t i = 1; i < n; i++) {
+        uint32_t cp = cps[i];
+        int ccc = STRITER_NORM_CCC(striter_norm_props(cp));
+        uint32_t composite = last_ccc < 256 ? striter_norm_compose(cps[starter], cp) : 0;
+        if (composite && (last_ccc < ccc || last_ccc == 0)) {
+            cps[starter] = composite;
+            continue;
+        }
+        if (ccc == 0) {
+            starter = out;
+        }
+        last_ccc = ccc;
+        cps[out++] = cp;
+    }
+    return out;
+}
+
+static size_t striter_utf8_encode(uint32_t cp, char *out)
+{
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | cp >> 12);
+        out[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | cp >> 18);
+    out[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    out[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// s[0..len) in the given form, or NULL if it is in that form already.
+// Invalid UTF-8 sequences are copied, or with substitute replaced by
+// U+FFFD.
+zend_string *striter_normalize(const char *str, size_t len, striter_norm_t form, bool substitute)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    uint32_t stack[STRITER_NORM_STACK * STRITER_DECOMP_MAX];
+    uint32_t *cps = stack;
+    size_t n = 0;           // Codepoints decoded into cps
+    size_t pending = 0;     // Start of those not normalized yet
+    size_t pos = 0;
+    size_t advance;
+    
+    if (striter_norm_quick_check(s, len, form)) {
+        return NULL;
+    }
+    
+    // Each byte is at most one codepoint, which decomposes into at most
+    // STRITER_DECOMP_MAX. An invalid sequence is stored as its byte offset
+    // with the high bit set, and only expanded when encoding.
+    if (len > STRITER_NORM_STACK) {
+        cps = safe_emalloc(len, STRITER_DECOMP_MAX * sizeof(uint32_t), 0);
+    }
+    
+    while (pos < len) {
+        int32_t cp = striter_utf8_decode(s + pos, len - pos, &advance);
+        if (cp < 0) {
+            // An invalid sequence ends a normalization run
+            n = pending + striter_norm_finish(cps + pending, n - pending, form);
+            cps[n++] = 0x80000000u | (uint32_t)pos;
+            pending = n;
+        } else {
+            n += striter_norm_decompose((uint32_t)cp, cps + n);
+        }
+        pos += advance;
+    }
+    n = pending + striter_norm_finish(cps + pending, n - pending, form);
+    
+    // Size the result, then encode it
+    size_t out_len = 0;
+    char buf[4];
+    for (size_t i = 0; i < n; i++) {
+        if (cps[i] & 0x80000000u) {
+            size_t at = cps[i] & 0x7FFFFFFFu;
+            out_len += substitute ? 3 : striter_utf8_char_length(str, len, at);
+        } else {
+            out_len += striter_utf8_encode(cps[i], buf);
+        }
+    }
+    
+    zend_string *result = zend_string_alloc(out_len, 0);
+    char *out = ZSTR_VAL(result);
+    for (size_t i = 0; i < n; i++) {
+        if (cps[i] & 0x80000000u) {
+            size_t at = cps[i] & 0x7FFFFFFFu;
+            if (substitute) {
+                memcpy(out, "\xEF\xBF\xBD", 3);
+                out += 3;
+            } else {
+                size_t bad = striter_utf8_char_length(str, len, at);
+                memcpy(out, str + at, bad);
+                out += bad;
+            }
+        } else {
+            out += striter_utf8_encode(cps[i], out);
+        }
+    }
+    *out = '\0';
+    if (cps != stack) {
+        efree(cps);
+    }
+    
+    // A quick check answer of maybe often turns out to be yes
+    if (out_len == len && memcmp(ZSTR_VAL(result), str, len) == 0) {
+        zend_string_efree(result);
+        return NULL;
+    }
+    return result;
+}
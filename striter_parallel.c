@@ -0,0 +1,345 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+
+// Opt-in parallel counting and index building for large strings.
+//
+// The string is cut into one range per thread, and each cut is moved
+// forward to a position where a unit boundary is certain without looking
+// back (striter_parallel_resync). Segmenting the ranges independently
+// then gives exactly the boundaries of a serial scan, whatever the number
+// of threads. Workers run plain C: they never touch module globals or the
+// Zend allocator, so the kernels they need are passed in explicitly.
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+
+#define STRITER_POOL_MAX_THREADS 64
+
+typedef struct _striter_task striter_task;
+
+// Tasks submitted together; the submitter waits until pending drops to 0
+typedef struct _striter_batch {
+    size_t pending;
+} striter_batch;
+
+struct _striter_task {
+    striter_task *next;         // Next task in the pool queue
+    striter_batch *batch;       // Batch this task belongs to
+    const char *str;            // Range to segment
+    size_t len;
+    striter_mode_t mode;
+    striter_ascii_span_func ascii_span;
+    size_t count;               // Units in the range (count pass result)
+    size_t *checkpoints;        // Index pass: checkpoint array to fill, or NULL
+    size_t base;                // Index pass: byte offset of str in the full string
+    size_t first_index;         // Index pass: global index of the first unit
+    size_t interval;            // Index pass: units between checkpoints
+};
+
+// Small process-wide thread pool, started on first use
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work;        // Signalled when tasks are queued
+    pthread_cond_t done;        // Signalled when a batch may have finished
+    pthread_t threads[STRITER_POOL_MAX_THREADS];
+    int nthreads;
+    bool stopping;
+    striter_task *head;
+    striter_task *tail;
+} striter_pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+};
+
+// Byte length of the unit at pos, without going through module globals
+static size_t striter_task_unit_length(const char *str, size_t len, size_t pos, striter_mode_t mode)
+{
+    if (mode == STRITER_MODE_GRAPHEME) {
+        return striter_grapheme_length_native(str, len, pos);
+    }
+    return (unsigned char)str[pos] < 0x80 ? 1 : striter_utf8_char_length(str, len, pos);
+}
+
+static void striter_task_run(striter_task *task)
+{
+    if (task->checkpoints == NULL) {
+        task->count = task->mode == STRITER_MODE_GRAPHEME
+            ? striter_count_graphemes_native_with(task->str, task->len, task->ascii_span)
+            : striter_count_utf8_chars_with(task->str, task->len, task->ascii_span);
+        return;
+    }
+    
+    // Record the offset of every unit whose global index is a nonzero
+    // multiple of the interval; each range owns a disjoint set of slots
+    size_t pos = 0;
+    size_t index = task->first_index;
+    while (pos < task->len) {
+        if (index % task->interval == 0 && index > 0) {
+            task->checkpoints[index / task->interval - 1] = task->base + pos;
+        }
+        pos += striter_task_unit_length(task->str, task->len, pos, task->mode);
+        index++;
+    }
+}
+
+// Take the next queued task; called with the pool locked
+static striter_task *striter_pool_pop(void)
+{
+    striter_task *task = striter_pool.head;
+    if (task) {
+        striter_pool.head = task->next;
+        if (striter_pool.head == NULL) {
+            striter_pool.tail = NULL;
+        }
+    }
+    return task;
+}
+
+static void striter_pool_finish(striter_task *task)
+{
+    pthread_mutex_lock(&striter_pool.lock);
+    if (--task->batch->pending == 0) {
+        pthread_cond_broadcast(&striter_pool.done);
+    }
+    pthread_mutex_unlock(&striter_pool.lock);
+}
+
+static void *striter_pool_worker(void *arg)
+{
+    pthread_mutex_lock(&striter_pool.lock);
+    for (;;) {
+        striter_task *task;
+        while ((task = striter_pool_pop()) == NULL && !striter_pool.stopping) {
+            pthread_cond_wait(&striter_pool.work, &striter_pool.lock);
+        }
+        if (task == NULL) {
+            break;
+        }
+        pthread_mutex_unlock(&striter_pool.lock);
+        striter_task_run(task);
+        striter_pool_finish(task);
+        pthread_mutex_lock(&striter_pool.lock);
+    }
+    pthread_mutex_unlock(&striter_pool.lock);
+    return NULL;
+}
+
+// A forked child has the pool's memory but none of its threads
+static void striter_pool_atfork_child(void)
+{
+    pthread_mutex_init(&striter_pool.lock, NULL);
+    pthread_cond_init(&striter_pool.work, NULL);
+    pthread_cond_init(&striter_pool.done, NULL);
+    striter_pool.nthreads = 0;
+    striter_pool.stopping = 0;
+    striter_pool.head = striter_pool.tail = NULL;
+}
+
+static void striter_pool_register_atfork(void)
+{
+    pthread_atfork(NULL, NULL, striter_pool_atfork_child);
+}
+
+// Run tasks on the pool and wait for all of them. The calling thread works
+// through the queue too, so n tasks need only n - 1 workers.
+static void striter_pool_run(striter_task *tasks, size_t n)
+{
+    static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+    striter_batch batch = { n };
+    
+    pthread_once(&atfork_once, striter_pool_register_atfork);
+    
+    pthread_mutex_lock(&striter_pool.lock);
+    while (striter_pool.nthreads < (int)n - 1 && striter_pool.nthreads < STRITER_POOL_MAX_THREADS) {
+        if (pthread_create(&striter_pool.threads[striter_pool.nthreads], NULL, striter_pool_worker, NULL) != 0) {
+            break;
+        }
+        striter_pool.nthreads++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        tasks[i].batch = &batch;
+        tasks[i].next = NULL;
+        if (striter_pool.tail) {
+            striter_pool.tail->next = &tasks[i];
+        } else {
+            striter_pool.head = &tasks[i];
+        }
+        striter_pool.tail = &tasks[i];
+    }
+    pthread_cond_broadcast(&striter_pool.work);
+    
+    // Help until the queue is empty, then wait for the workers
+    striter_task *task;
+    while ((task = striter_pool_pop()) != NULL) {
+        pthread_mutex_unlock(&striter_pool.lock);
+        striter_task_run(task);
+        striter_pool_finish(task);
+        pthread_mutex_lock(&striter_pool.lock);
+    }
+    while (batch.pending > 0) {
+        pthread_cond_wait(&striter_pool.done, &striter_pool.lock);
+    }
+    pthread_mutex_unlock(&striter_pool.lock);
+}
+#endif
+
+// First position at or after pos where segmentation can restart without
+// knowing anything before it, or len if there is none. Codepoints start at
+// every ASCII or valid lead byte: decoders only ever swallow continuation
+// bytes and bytes that can never start a sequence.
+static size_t striter_parallel_resync(const char *str, size_t len, size_t pos, striter_mode_t mode)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    
+    for (; pos < len; pos++) {
+        if (s[pos] >= 0x80 && (s[pos] < 0xC2 || s[pos] > 0xF4)) {
+            continue;
+        }
+        if (mode == STRITER_MODE_CODEPOINT || striter_grapheme_is_safe_break(str, len, pos)) {
+            return pos;
+        }
+    }
+    return len;
+}
+
+// Number of threads to use for len bytes in mode, or 1 to stay serial.
+// Only codepoints and native grapheme clusters have a resync rule; PCRE2
+// keeps per-thread state in the module globals.
+int striter_parallel_threads(size_t len, striter_mode_t mode)
+{
+#ifdef HAVE_PTHREAD_H
+    zend_long threads = STRITER_G(threads);
+    
+    if (threads < 2 || (mode != STRITER_MODE_GRAPHEME && mode != STRITER_MODE_CODEPOINT)) {
+        return 1;
+    }
+    if (mode == STRITER_MODE_GRAPHEME && STRITER_G(grapheme_engine) != STRITER_ENGINE_NATIVE) {
+        return 1;
+    }
+    if ((size_t)threads > len / STRITER_PARALLEL_MIN_BYTES) {
+        threads = (zend_long)(len / STRITER_PARALLEL_MIN_BYTES);
+    }
+    return threads < 2 ? 1 : (int)threads;
+#else
+    return 1;
+#endif
+}
+
+#ifdef HAVE_PTHREAD_H
+// Cut str into at most nthreads ranges at safe boundaries and set up one
+// task per range. Returns the number of tasks.
+static size_t striter_parallel_split(const char *str, size_t len, striter_mode_t mode, int nthreads, striter_task *tasks)
+{
+    size_t n = 0;
+    size_t start = 0;
+    
+    for (int i = 1; i <= nthreads && start < len; i++) {
+        size_t end = i == nthreads ? len : striter_parallel_resync(str, len, len / nthreads * i, mode);
+        if (end <= start) {
+            continue;
+        }
+        memset(&tasks[n], 0, sizeof(tasks[n]));
+        tasks[n].str = str + start;
+        tasks[n].len = end - start;
+        tasks[n].mode = mode;
+        tasks[n].ascii_span = STRITER_G(ascii_span);
+        tasks[n].base = start;
+        n++;
+        start = end;
+    }
+    return n;
+}
+#endif
+
+// Count the units of str on nthreads threads
+size_t striter_parallel_count(const char *str, size_t len, striter_mode_t mode, int nthreads)
+{
+#ifdef HAVE_PTHREAD_H
+    striter_task tasks[STRITER_POOL_MAX_THREADS];
+    size_t total = 0;
+    
+    if (nthreads > STRITER_POOL_MAX_THREADS) {
+        nthreads = STRITER_POOL_MAX_THREADS;
+    }
+    size_t n = striter_parallel_split(str, len, mode, nthreads, tasks);
+    striter_pool_run(tasks, n);
+    for (size_t i = 0; i < n; i++) {
+        total += tasks[i].count;
+    }
+    return total;
+#else
+    return striter_count_units(str, len, mode);
+#endif
+}
+
+// Finish segmenting obj's string from its scan high-water mark on nthreads
+// threads: count each range, then fill in the checkpoints of every range
+// from its now known first unit index. Leaves the count known and the scan
+// at the end of the string, exactly as a serial walk would.
+void striter_parallel_index(striter_string_iterator_obj *obj, int nthreads)
+{
+#ifdef HAVE_PTHREAD_H
+    striter_task tasks[STRITER_POOL_MAX_THREADS];
+    const char *str = ZSTR_VAL(obj->str) + obj->scan_pos;
+    size_t len = ZSTR_LEN(obj->str) - obj->scan_pos;
+    size_t interval = obj->index_interval;
+    
+    if (nthreads > STRITER_POOL_MAX_THREADS) {
+        nthreads = STRITER_POOL_MAX_THREADS;
+    }
+    size_t n = striter_parallel_split(str, len, obj->mode, nthreads, tasks);
+    striter_pool_run(tasks, n);
+    
+    size_t index = obj->scan_index;
+    for (size_t i = 0; i < n; i++) {
+        tasks[i].first_index = index;
+        index += tasks[i].count;
+    }
+    size_t total = index;
+    
+    // One slot per nonzero multiple of the interval, the last one possibly
+    // being the end of the string; slots before scan_index are already set
+    size_t needed = total / interval;
+    if (needed > obj->checkpoint_cap) {
+        obj->checkpoints = safe_erealloc(obj->checkpoints, needed, sizeof(size_t), 0);
+        obj->checkpoint_cap = needed;
+    }
+    for (size_t i = 0; i < n; i++) {
+        tasks[i].checkpoints = obj->checkpoints;
+        tasks[i].base += obj->scan_pos;
+        tasks[i].interval = interval;
+    }
+    striter_pool_run(tasks, n);
+    
+    if (needed > 0 && total % interval == 0) {
+        obj->checkpoints[needed - 1] = ZSTR_LEN(obj->str);
+    }
+    obj->checkpoint_count = needed;
+    obj->scan_pos = ZSTR_LEN(obj->str);
+    obj->scan_index = total;
+    obj->total_chars = total;
+    obj->count_known = 1;
+#endif
+}
+
+// Stop the pool's threads at module shutdown
+void striter_parallel_shutdown(void)
+{
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&striter_pool.lock);
+    striter_pool.stopping = 1;
+    pthread_cond_broadcast(&striter_pool.work);
+    pthread_mutex_unlock(&striter_pool.lock);
+    
+    for (int i = 0; i < striter_pool.nthreads; i++) {
+        pthread_join(striter_pool.threads[i], NULL);
+    }
+    striter_pool.nthreads = 0;
+    striter_pool.stopping = 0;
+#endif
+}
@@ -0,0 +1,309 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+#include "striter_unicode_tables.h"
+
+// Native UAX #29 word and sentence segmentation.
+//
+// Codepoints are classified through the generated two-stage Word_Break
+// and Sentence_Break tables. Word boundaries are decided by the generated
+// (previous, current) rule table like grapheme boundaries; the few rules
+// that need more context (WB6/7, WB7b/c, WB11/12, WB15/16) get it from
+// the class before the previous one, a lookahead to the next class, or
+// the length of the Regional_Indicator run. Sentence rules are about
+// terminator sequences (SATerm Close* Sp*), so the sentence segmenter
+// tracks where it is in such a sequence instead.
+//
+// Both start from a known boundary and never need anything before it: no
+// rule keeps a segment together across a position where it breaks. Like
+// in the other modes, invalid UTF-8 sequences are units of their own.
+
+static zend_always_inline uint8_t striter_wb_class(uint32_t cp)
+{
+    return striter_wb_stage2[
+        ((size_t)striter_wb_stage1[cp >> STRITER_WB_SHIFT] << STRITER_WB_SHIFT) | (cp & STRITER_WB_MASK)
+    ];
+}
+
+static zend_always_inline uint8_t striter_sb_class(uint32_t cp)
+{
+    return striter_sb_stage2[
+        ((size_t)striter_sb_stage1[cp >> STRITER_SB_SHIFT] << STRITER_SB_SHIFT) | (cp & STRITER_SB_MASK)
+    ];
+}
+
+// Decode the codepoint at pos, with ASCII kept out of the decoder
+static zend_always_inline int32_t striter_segment_decode(const unsigned char *s, size_t len, size_t pos, size_t *advance)
+{
+    if (s[pos] < 0x80) {
+        *advance = 1;
+        return s[pos];
+    }
+    return striter_utf8_decode(s + pos, len - pos, advance);
+}
+
+static zend_always_inline bool striter_wb_is_ahletter(int cls)
+{
+    return cls == STRITER_WB_ALETTER || cls == STRITER_WB_HEBREW_LETTER;
+}
+
+// Word_Break class of the first codepoint at or after pos that WB4 does
+// not skip, or -1 at the end of the string or an invalid sequence
+static int striter_wb_next_class(const unsigned char *s, size_t len, size_t pos)
+{
+    size_t advance;
+    
+    while (pos < len) {
+        int32_t cp = striter_segment_decode(s, len, pos, &advance);
+        if (cp < 0) {
+            return -1;
+        }
+        uint8_t cls = striter_wb_class(cp);
+        if (cls != STRITER_WB_EXTEND && cls != STRITER_WB_FORMAT && cls != STRITER_WB_ZWJ) {
+            return cls;
+        }
+        pos += advance;
+    }
+    return -1;
+}
+
+// Byte length of the word segment starting at pos. Segments are those of
+// UAX #29: words, but also each run of spaces and each punctuation mark.
+size_t striter_word_length(const char *str, size_t len, size_t pos)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    size_t advance;
+    
+    if (pos >= len) {
+        return 0;
+    }
+    
+    int32_t cp = striter_segment_decode(s, len, pos, &advance);
+    if (cp < 0) {
+        return advance;
+    }
+    
+    size_t end = pos + advance;
+    uint8_t raw = striter_wb_class(cp);     // Class of the codepoint just before end
+    uint8_t prev = raw;                     // Last class WB4 did not skip
+    int prev2 = -1;                         // The one before prev
+    size_t ri_run = raw == STRITER_WB_REGIONAL_INDICATOR;
+    
+    while (end < len) {
+        cp = striter_segment_decode(s, len, end, &advance);
+        if (cp < 0) {
+            break;
+        }
+    
+        uint8_t cur = striter_wb_class(cp);
+    
+        // WB3c and WB3d look at adjacent codepoints, before WB4 applies
+        if ((raw == STRITER_WB_ZWJ && striter_is_extended_pictographic(cp))
+                || (raw == STRITER_WB_WSEGSPACE && cur == STRITER_WB_WSEGSPACE)) {
+            goto no_break;
+        }
+    
+        switch (striter_wb_rules[prev][cur]) {
+            case STRITER_WBR_BREAK:
+                return end - pos;
+            case STRITER_WBR_IGNORE:
+                raw = cur;
+                end += advance;
+                continue;
+            case STRITER_WBR_NO_BREAK_NEXT_LETTER:
+                if (!striter_wb_is_ahletter(striter_wb_next_class(s, len, end + advance))) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_WBR_NO_BREAK_NEXT_HEBREW:
+                if (striter_wb_next_class(s, len, end + advance) != STRITER_WB_HEBREW_LETTER) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_WBR_NO_BREAK_NEXT_NUMERIC:
+                if (striter_wb_next_class(s, len, end + advance) != STRITER_WB_NUMERIC) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_WBR_NO_BREAK_PREV_LETTER:
+                if (!striter_wb_is_ahletter(prev2)) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_WBR_NO_BREAK_PREV_HEBREW:
+                if (prev2 != STRITER_WB_HEBREW_LETTER) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_WBR_NO_BREAK_PREV_NUMERIC:
+                if (prev2 != STRITER_WB_NUMERIC) {
+                    return end - pos;
+                }
+                break;
+            case STRITER_WBR_NO_BREAK_RI:
+                if (ri_run % 2 == 0) {
+                    return end - pos;
+                }
+                break;
+        }
+    
+no_break:
+        ri_run = cur == STRITER_WB_REGIONAL_INDICATOR ? ri_run + 1 : 0;
+        prev2 = prev;
+        prev = cur;
+        raw = cur;
+        end += advance;
+    }
+    
+    return end - pos;
+}
+
+// Where the sentence segmenter is in a terminator sequence
+#define STRITER_SB_STATE_NONE  0    // Not in one
+#define STRITER_SB_STATE_TERM  1    // SATerm Close*
+#define STRITER_SB_STATE_SPACE 2    // SATerm Close* Sp+
+
+static zend_always_inline bool striter_sb_is_parasep(int cls)
+{
+    return cls == STRITER_SB_SEP || cls == STRITER_SB_CR || cls == STRITER_SB_LF;
+}
+
+// SB8: whether the text from pos on is ( ¬(OLetter | Upper | Lower |
+// ParaSep | SATerm) )* Lower, skipping Extend and Format (SB5)
+static bool striter_sb_lower_follows(const unsigned char *s, size_t len, size_t pos)
+{
+    size_t advance;
+    
+    while (pos < len) {
+        int32_t cp = striter_segment_decode(s, len, pos, &advance);
+        if (cp < 0) {
+            return 0;
+        }
+        switch (striter_sb_class(cp)) {
+            case STRITER_SB_LOWER:
+                return 1;
+            case STRITER_SB_OLETTER:
+            case STRITER_SB_UPPER:
+            case STRITER_SB_SEP:
+            case STRITER_SB_CR:
+            case STRITER_SB_LF:
+            case STRITER_SB_ATERM:
+            case STRITER_SB_STERM:
+                return 0;
+        }
+        pos += advance;
+    }
+    return 0;
+}
+
+// Byte length of the sentence starting at pos, including its trailing
+// spaces and paragraph separator
+size_t striter_sentence_length(const char *str, size_t len, size_t pos)
+{
+    const unsigned char *s = (const unsigned char *)str;
+    size_t advance;
+    
+    if (pos >= len) {
+        return 0;
+    }
+    
+    int32_t cp = striter_segment_decode(s, len, pos, &advance);
+    if (cp < 0) {
+        return advance;
+    }
+    
+    size_t end = pos + advance;
+    uint8_t raw = striter_sb_class(cp);     // Class of the codepoint just before end
+    uint8_t prev = raw;                     // Last class SB5 did not skip
+    uint8_t prev2 = STRITER_SB_OTHER;       // The one before prev (SB7)
+    int state = STRITER_SB_STATE_NONE;
+    bool aterm = 0;                         // The sequence started with ATerm (SB8)
+    
+    if (raw == STRITER_SB_ATERM || raw == STRITER_SB_STERM) {
+        state = STRITER_SB_STATE_TERM;
+        aterm = raw == STRITER_SB_ATERM;
+    }
+    
+    while (end < len) {
+        cp = striter_segment_decode(s, len, end, &advance);
+        if (cp < 0) {
+            break;
+        }
+    
+        uint8_t cur = striter_sb_class(cp);
+    
+        if (raw == STRITER_SB_CR && cur == STRITER_SB_LF) {
+            // SB3
+        } else if (striter_sb_is_parasep(prev)) {
+            return end - pos;                                   // SB4
+        } else if (cur == STRITER_SB_EXTEND || cur == STRITER_SB_FORMAT) {
+            raw = cur;                                          // SB5
+            end += advance;
+            continue;
+        } else if (state != STRITER_SB_STATE_NONE) {
+            bool keep;
+    
+            if (prev == STRITER_SB_ATERM && cur == STRITER_SB_NUMERIC) {
+                keep = 1;                                       // SB6
+            } else if (prev == STRITER_SB_ATERM && cur == STRITER_SB_UPPER
+                    && (prev2 == STRITER_SB_UPPER || prev2 == STRITER_SB_LOWER)) {
+                keep = 1;                                       // SB7
+            } else if (aterm && striter_sb_lower_follows(s, len, end)) {
+                keep = 1;                                       // SB8
+            } else if (cur == STRITER_SB_SCONTINUE || cur == STRITER_SB_ATERM || cur == STRITER_SB_STERM) {
+                keep = 1;                                       // SB8a
+            } else if (state == STRITER_SB_STATE_TERM && cur == STRITER_SB_CLOSE) {
+                keep = 1;                                       // SB9
+            } else {
+                keep = cur == STRITER_SB_SP || striter_sb_is_parasep(cur); // SB9, SB10
+            }
+            if (!keep) {
+                return end - pos;                               // SB11
+            }
+        }
+    
+        if (cur == STRITER_SB_ATERM || cur == STRITER_SB_STERM) {
+            state = STRITER_SB_STATE_TERM;
+            aterm = cur == STRITER_SB_ATERM;
+        } else if (cur == STRITER_SB_SP && state != STRITER_SB_STATE_NONE) {
+            state = STRITER_SB_STATE_SPACE;
+        } else if (!(cur == STRITER_SB_CLOSE && state == STRITER_SB_STATE_TERM)) {
+            state = STRITER_SB_STATE_NONE;
+        }
+        prev2 = prev;
+        prev = cur;
+        raw = cur;
+        end += advance;
+    }
+    
+    return end - pos;
+}
+
+// Count word segments
+size_t striter_count_words(const char *str, size_t len)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    
+    while (pos < len) {
+        pos += striter_word_length(str, len, pos);
+        count++;
+    }
+    return count;
+}
+
+// Count sentences
+size_t striter_count_sentences(const char *str, size_t len)
+{
+    size_t count = 0;
+    size_t pos = 0;
+    
+    while (pos < len) {
+        pos += striter_sentence_length(str, len, pos);
+        count++;
+    }
+    return count;
+}
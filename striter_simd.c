@@ -0,0 +1,369 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "zend_cpuinfo.h"
+#include "php_striter.h"
+
+// Vectorized scanning kernels.
+//
+// Each kernel comes in a portable scalar (word-at-a-time) version plus
+// SSE2 and AVX2 versions on x86. UTF-8 validation is fully vectorized with
+// AVX2 only; the lower levels skip ASCII runs and decode the rest. The
+// kernel set is chosen at run time from CPUID through striter.simd, so one
+// binary runs on any x86-64 CPU.
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+# define STRITER_HAVE_SSE2 1
+# include <emmintrin.h>
+# if defined(HAVE_FUNC_ATTRIBUTE_TARGET)
+#  define STRITER_HAVE_AVX2 1
+#  include <immintrin.h>
+# endif
+#endif
+
+#define STRITER_HIGH_BITS UINT64_C(0x8080808080808080)
+
+// Length of the leading run of ASCII bytes, 8 bytes at a time
+static size_t striter_ascii_span_scalar(const unsigned char *s, size_t len)
+{
+    size_t i = 0;
+    
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, s + i, sizeof(word));
+        if (word & STRITER_HIGH_BITS) {
+            break;
+        }
+    }
+    while (i < len && s[i] < 0x80) {
+        i++;
+    }
+    
+    return i;
+}
+
+#ifdef STRITER_HAVE_SSE2
+// Length of the leading run of ASCII bytes, 16 bytes at a time
+static size_t striter_ascii_span_sse2(const unsigned char *s, size_t len)
+{
+    size_t i = 0;
+    
+    for (; i + 16 <= len; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + i)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    
+    return i + striter_ascii_span_scalar(s + i, len - i);
+}
+#endif
+
+#ifdef STRITER_HAVE_AVX2
+// Length of the leading run of ASCII bytes, 32 bytes at a time
+__attribute__((target("avx2")))
+static size_t striter_ascii_span_avx2(const unsigned char *s, size_t len)
+{
+    size_t i = 0;
+    
+    for (; i + 32 <= len; i += 32) {
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(s + i)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    
+    return i + striter_ascii_span_sse2(s + i, len - i);
+}
+#endif
+
+// Offset of the first invalid UTF-8 sequence in s[0..len), or len.
+// ASCII runs are skipped with the given span kernel.
+static zend_always_inline size_t striter_utf8_validate_with(const unsigned char *s, size_t len, striter_ascii_span_func ascii_span)
+{
+    size_t pos = 0;
+    
+    while (pos < len) {
+        size_t advance;
+        
+        pos += ascii_span(s + pos, len - pos);
+        if (pos >= len) {
+            break;
+        }
+        if (striter_utf8_decode(s + pos, len - pos, &advance) < 0) {
+            return pos;
+        }
+        pos += advance;
+    }
+    
+    return len;
+}
+
+static size_t striter_utf8_validate_scalar(const unsigned char *s, size_t len)
+{
+    return striter_utf8_validate_with(s, len, striter_ascii_span_scalar);
+}
+
+#ifdef STRITER_HAVE_SSE2
+static size_t striter_utf8_validate_sse2(const unsigned char *s, size_t len)
+{
+    return striter_utf8_validate_with(s, len, striter_ascii_span_sse2);
+}
+#endif
+
+#ifdef STRITER_HAVE_AVX2
+// UTF-8 validation with the lookup algorithm of simdjson (Keiser & Lemire,
+// "Validating UTF-8 In Less Than One Instruction Per Byte"). Each byte is
+// checked against the byte before it through three 16-entry nibble tables;
+// the bits that survive the AND name the error. 3- and 4-byte sequences
+// additionally need their 3rd/4th bytes to be continuations.
+#define STRITER_UTF8_TOO_SHORT      (1 << 0) // 11______ 0_______ / 11______ 11______
+#define STRITER_UTF8_TOO_LONG       (1 << 1) // 0_______ 10______
+#define STRITER_UTF8_OVERLONG_3     (1 << 2) // 11100000 100_____
+#define STRITER_UTF8_TOO_LARGE      (1 << 3) // 11110100 1001____ and above
+#define STRITER_UTF8_SURROGATE      (1 << 4) // 11101101 101_____
+#define STRITER_UTF8_OVERLONG_2     (1 << 5) // 1100000_ 10______
+#define STRITER_UTF8_TOO_LARGE_1000 (1 << 6) // 11110101 1000____ and above
+#define STRITER_UTF8_OVERLONG_4     (1 << 6) // 11110000 1000____
+#define STRITER_UTF8_TWO_CONTS      (1 << 7) // 10______ 10______
+#define STRITER_UTF8_CARRY          (STRITER_UTF8_TOO_SHORT | STRITER_UTF8_TOO_LONG | STRITER_UTF8_TWO_CONTS)
+
+// The 16-entry tables are repeated in both 128-bit lanes for vpshufb
+#define STRITER_LANES(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+// Bytes of input shifted in from the end of the previous block
+#define STRITER_PREV_AVX2(input, prev, n) \
+    _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - (n))
+
+__attribute__((target("avx2")))
+static inline __m256i striter_utf8_block_errors_avx2(__m256i input, __m256i prev_input)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i byte_1_high_table = STRITER_LANES(
+        // 0_______ ________ <ASCII in byte 1>
+        STRITER_UTF8_TOO_LONG, STRITER_UTF8_TOO_LONG, STRITER_UTF8_TOO_LONG, STRITER_UTF8_TOO_LONG,
+        STRITER_UTF8_TOO_LONG, STRITER_UTF8_TOO_LONG, STRITER_UTF8_TOO_LONG, STRITER_UTF8_TOO_LONG,
+        // 10______ ________ <continuation in byte 1>
+        STRITER_UTF8_TWO_CONTS, STRITER_UTF8_TWO_CONTS, STRITER_UTF8_TWO_CONTS, STRITER_UTF8_TWO_CONTS,
+        // 1100____ ________ <two byte lead in byte 1>
+        STRITER_UTF8_TOO_SHORT | STRITER_UTF8_OVERLONG_2,
+        // 1101____ ________ <two byte lead in byte 1>
+        STRITER_UTF8_TOO_SHORT,
+        // 1110____ ________ <three byte lead in byte 1>
+        STRITER_UTF8_TOO_SHORT | STRITER_UTF8_OVERLONG_3 | STRITER_UTF8_SURROGATE,
+        // 1111____ ________ <four+ byte lead in byte 1>
+        STRITER_UTF8_TOO_SHORT | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000 | STRITER_UTF8_OVERLONG_4
+    );
+    const __m256i byte_1_low_table = STRITER_LANES(
+        // ____0000 ________
+        STRITER_UTF8_CARRY | STRITER_UTF8_OVERLONG_3 | STRITER_UTF8_OVERLONG_2 | STRITER_UTF8_OVERLONG_4,
+        // ____0001 ________
+        STRITER_UTF8_CARRY | STRITER_UTF8_OVERLONG_2,
+        // ____001_ ________
+        STRITER_UTF8_CARRY,
+        STRITER_UTF8_CARRY,
+        // ____0100 ________
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE,
+        // ____0101 ________ and ____011_ ________
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        // ____1___ ________
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        // ____1101 ________
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000 | STRITER_UTF8_SURROGATE,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000,
+        STRITER_UTF8_CARRY | STRITER_UTF8_TOO_LARGE | STRITER_UTF8_TOO_LARGE_1000
+    );
+    const __m256i byte_2_high_table = STRITER_LANES(
+        // ________ 0_______ <ASCII in byte 2>
+        STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT,
+        STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT,
+        // ________ 1000____
+        STRITER_UTF8_TOO_LONG | STRITER_UTF8_OVERLONG_2 | STRITER_UTF8_TWO_CONTS | STRITER_UTF8_OVERLONG_3
+            | STRITER_UTF8_TOO_LARGE_1000 | STRITER_UTF8_OVERLONG_4,
+        // ________ 1001____
+        STRITER_UTF8_TOO_LONG | STRITER_UTF8_OVERLONG_2 | STRITER_UTF8_TWO_CONTS | STRITER_UTF8_OVERLONG_3
+            | STRITER_UTF8_TOO_LARGE,
+        // ________ 101_____
+        STRITER_UTF8_TOO_LONG | STRITER_UTF8_OVERLONG_2 | STRITER_UTF8_TWO_CONTS | STRITER_UTF8_SURROGATE
+            | STRITER_UTF8_TOO_LARGE,
+        STRITER_UTF8_TOO_LONG | STRITER_UTF8_OVERLONG_2 | STRITER_UTF8_TWO_CONTS | STRITER_UTF8_SURROGATE
+            | STRITER_UTF8_TOO_LARGE,
+        // ________ 11______
+        STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT, STRITER_UTF8_TOO_SHORT
+    );
+    
+    __m256i prev1 = STRITER_PREV_AVX2(input, prev_input, 1);
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(
+            _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+            _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, nibble))
+        ),
+        _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble))
+    );
+    
+    // Third and fourth bytes of 3- and 4-byte sequences must be continuations
+    __m256i prev2 = STRITER_PREV_AVX2(input, prev_input, 2);
+    __m256i prev3 = STRITER_PREV_AVX2(input, prev_input, 3);
+    __m256i must_be_cont = _mm256_and_si256(
+        _mm256_or_si256(
+            _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80))),
+            _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)))
+        ),
+        _mm256_set1_epi8((char)0x80)
+    );
+    
+    return _mm256_xor_si256(must_be_cont, special);
+}
+
+__attribute__((target("avx2")))
+static size_t striter_utf8_validate_avx2(const unsigned char *s, size_t len)
+{
+    // A block ending in the first bytes of a multi-byte sequence is only
+    // valid if the next block completes it
+    const __m256i incomplete_max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+    );
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    __m256i error;
+    unsigned char tail[32];
+    size_t i = 0;
+    
+    while (i < len) {
+        __m256i input;
+        
+        if (i + 32 <= len) {
+            input = _mm256_loadu_si256((const __m256i *)(s + i));
+        } else {
+            // Zero padding is ASCII, so a sequence cut off by the end of the
+            // string shows up as too short
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, len - i);
+            input = _mm256_loadu_si256((const __m256i *)tail);
+        }
+        
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = prev_incomplete;
+        } else {
+            error = striter_utf8_block_errors_avx2(input, prev_input);
+        }
+        
+        if (!_mm256_testz_si256(error, error)) {
+            // Find the exact offset with the scalar decoder, restarting at
+            // the sequence that may straddle into this block
+            size_t start = i;
+            for (int k = 0; k < 4 && start > 0; k++) {
+                start--;
+                if ((s[start] & 0xC0) != 0x80) {
+                    break;
+                }
+            }
+            return start + striter_utf8_validate_scalar(s + start, len - start);
+        }
+        
+        prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        prev_input = input;
+        i += 32;
+    }
+    
+    if (!_mm256_testz_si256(prev_incomplete, prev_incomplete)) {
+        size_t start = len;
+        for (int k = 0; k < 4 && start > 0; k++) {
+            start--;
+            if ((s[start] & 0xC0) != 0x80) {
+                break;
+            }
+        }
+        return start + striter_utf8_validate_scalar(s + start, len - start);
+    }
+    
+    return len;
+}
+#endif
+
+// Highest kernel level this CPU (and this build) supports
+static striter_simd_t striter_simd_available(void)
+{
+#ifdef STRITER_HAVE_AVX2
+    if (zend_cpu_supports_avx2()) {
+        return STRITER_SIMD_AVX2;
+    }
+#endif
+#ifdef STRITER_HAVE_SSE2
+    return STRITER_SIMD_SSE2;
+#else
+    return STRITER_SIMD_SCALAR;
+#endif
+}
+
+// Install the kernels for the requested level, clamped to what is
+// available, and return the level actually selected
+striter_simd_t striter_simd_select(striter_simd_t requested)
+{
+    striter_simd_t level = MIN(requested, striter_simd_available());
+    
+    switch (level) {
+#ifdef STRITER_HAVE_AVX2
+        case STRITER_SIMD_AVX2:
+            STRITER_G(ascii_span) = striter_ascii_span_avx2;
+            STRITER_G(utf8_validate) = striter_utf8_validate_avx2;
+            break;
+#endif
+#ifdef STRITER_HAVE_SSE2
+        case STRITER_SIMD_SSE2:
+            STRITER_G(ascii_span) = striter_ascii_span_sse2;
+            STRITER_G(utf8_validate) = striter_utf8_validate_sse2;
+            break;
+#endif
+        default:
+            level = STRITER_SIMD_SCALAR;
+            STRITER_G(ascii_span) = striter_ascii_span_scalar;
+            STRITER_G(utf8_validate) = striter_utf8_validate_scalar;
+            break;
+    }
+    
+    STRITER_G(simd) = level;
+    return level;
+}
+
+const char *striter_simd_name(striter_simd_t level)
+{
+    switch (level) {
+        case STRITER_SIMD_AVX2:
+            return "avx2";
+        case STRITER_SIMD_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+// Number of CR LF pairs in s[0..n). A CR as the very last byte is not
+// looked past.
+size_t striter_count_crlf(const unsigned char *s, size_t n)
+{
+    const unsigned char *p = s;
+    const unsigned char *end = s + n;
+    size_t pairs = 0;
+    
+    while (p < end && (p = memchr(p, '\r', end - p)) != NULL) {
+        if (p + 1 < end && p[1] == '\n') {
+            pairs++;
+            p += 2;
+        } else {
+            p++;
+        }
+    }
+    
+    return pairs;
+}
@@ -0,0 +1,196 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_striter.h"
+
+// One-pass aggregates over the units of a string.
+//
+// Counting or measuring units through str_iter() creates a string for
+// every unit only to throw it away. These functions segment the string
+// in place: units are hashed straight from the source buffer, and a key
+// is allocated only when a unit is seen for the first time. Runs of
+// single-byte units, which make up most of ASCII text, are taken a
+// vector at a time and counted in a table instead of being hashed.
+
+// Number of single-byte units starting at pos. In grapheme mode an ASCII
+// byte followed by another one is a cluster of its own unless it is the
+// CR of a CR LF, so the last byte of a run and anything from a CR on are
+// left to the segmenter.
+static size_t striter_ascii_units(const char *str, size_t len, size_t pos, striter_mode_t mode)
+{
+    const unsigned char *s = (const unsigned char *)str + pos;
+    size_t run;
+    
+    switch (mode) {
+        case STRITER_MODE_BYTE:
+            return len - pos;
+        case STRITER_MODE_CODEPOINT:
+            return s[0] < 0x80 ? striter_ascii_span(s, len - pos) : 0;
+        case STRITER_MODE_GRAPHEME:
+            if (s[0] >= 0x80 || (run = striter_ascii_span(s, len - pos)) < 2) {
+                return 0;
+            }
+            const unsigned char *cr = memchr(s, '\r', run - 1);
+            return cr ? (size_t)(cr - s) : run - 1;
+        default:
+            return 0;
+    }
+}
+
+// str_iter_count_values function implementation
+PHP_FUNCTION(str_iter_count_values)
+{
+    zend_string *str;
+    zend_string *mode = NULL;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(str)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR_OR_NULL(mode)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_mode_t iter_mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    const char *s = ZSTR_VAL(str);
+    size_t len = ZSTR_LEN(str);
+    striter_utf8_run valid_run = {0, 0};
+    zend_long byte_counts[256] = {0};
+    size_t pos = 0;
+    zval one;
+    
+    array_init(return_value);
+    HashTable *counts = Z_ARRVAL_P(return_value);
+    ZVAL_LONG(&one, 1);
+    
+    while (pos < len) {
+        size_t run = striter_ascii_units(s, len, pos, iter_mode);
+    
+        // Single bytes are counted in the table; their entries are added
+        // on first sight to keep the order of first appearance, and filled
+        // in at the end
+        for (size_t end = pos + run; pos < end; pos++) {
+            unsigned char c = (unsigned char)s[pos];
+            if (byte_counts[c]++ == 0) {
+                zend_symtable_str_update(counts, s + pos, 1, &one);
+            }
+        }
+        if (pos >= len) {
+            break;
+        }
+    
+        size_t unit_len = striter_unit_length_at(s, len, pos, iter_mode, &valid_run);
+        if (unit_len == 1) {
+            unsigned char c = (unsigned char)s[pos];
+            if (byte_counts[c]++ == 0) {
+                zend_symtable_str_update(counts, s + pos, 1, &one);
+            }
+        } else {
+            zval *count = zend_symtable_str_find(counts, s + pos, unit_len);
+            if (count != NULL) {
+                Z_LVAL_P(count)++;
+            } else {
+                zend_symtable_str_update(counts, s + pos, unit_len, &one);
+            }
+        }
+        pos += unit_len;
+    }
+    
+    for (int c = 0; c < 256; c++) {
+        if (byte_counts[c] > 1) {
+            char key = (char)c;
+            ZVAL_LONG(zend_symtable_str_find(counts, &key, 1), byte_counts[c]);
+        }
+    }
+}
+
+// Codepoints in s[0..len), adding the invalid sequences among them to
+// *invalid. ASCII runs are skipped a vector at a time.
+static size_t striter_stats_codepoints(const unsigned char *s, size_t len, size_t *invalid)
+{
+    size_t codepoints = 0;
+    size_t pos = 0;
+    size_t advance;
+    
+    while (pos < len) {
+        if (s[pos] < 0x80) {
+            size_t run = striter_ascii_span(s + pos, len - pos);
+            codepoints += run;
+            pos += run;
+            continue;
+        }
+        if (striter_utf8_decode(s + pos, len - pos, &advance) < 0) {
+            (*invalid)++;
+        }
+        codepoints++;
+        pos += advance;
+    }
+    return codepoints;
+}
+
+// str_iter_stats function implementation
+PHP_FUNCTION(str_iter_stats)
+{
+    zend_string *str;
+    zend_string *mode = NULL;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_STR(str)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR_OR_NULL(mode)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    striter_mode_t iter_mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    const unsigned char *s = (const unsigned char *)ZSTR_VAL(str);
+    size_t len = ZSTR_LEN(str);
+    striter_utf8_run valid_run = {0, 0};
+    size_t units = 0;
+    size_t codepoints = 0;
+    size_t max_bytes = 0;           // Bytes of the longest unit
+    size_t max_codepoints = 0;      // Codepoints of the unit with the most
+    size_t invalid = 0;             // Invalid UTF-8 sequences
+    size_t pos = 0;
+    
+    // Bytes are units of their own, so codepoints are counted across them
+    if (iter_mode == STRITER_MODE_BYTE) {
+        units = len;
+        max_bytes = max_codepoints = len > 0;
+        codepoints = striter_stats_codepoints(s, len, &invalid);
+        pos = len;
+    }
+    
+    // Everything is counted unit by unit in the one walk: units are made
+    // of whole codepoints, and an invalid sequence is a unit of its own
+    while (pos < len) {
+        size_t run = striter_ascii_units((const char *)s, len, pos, iter_mode);
+        if (run > 0) {
+            units += run;
+            codepoints += run;
+            pos += run;
+            max_bytes = MAX(max_bytes, 1);
+            max_codepoints = MAX(max_codepoints, 1);
+            continue;
+        }
+    
+        size_t unit_len = striter_unit_length_at((const char *)s, len, pos, iter_mode, &valid_run);
+        size_t unit_codepoints = 1;
+        if (unit_len > 1) {
+            unit_codepoints = striter_stats_codepoints(s + pos, unit_len, &invalid);
+        } else if (s[pos] >= 0x80) {
+            invalid++;
+        }
+        units++;
+        codepoints += unit_codepoints;
+        pos += unit_len;
+        max_bytes = MAX(max_bytes, unit_len);
+        max_codepoints = MAX(max_codepoints, unit_codepoints);
+    }
+    
+    array_init_size(return_value, 6);
+    add_assoc_long(return_value, "bytes", (zend_long)len);
+    add_assoc_long(return_value, "codepoints", (zend_long)codepoints);
+    add_assoc_long(return_value, "units", (zend_long)units);
+    add_assoc_long(return_value, "max_bytes", (zend_long)max_bytes);
+    add_assoc_long(return_value, "max_codepoints", (zend_long)max_codepoints);
+    add_assoc_long(return_value, "invalid", (zend_long)invalid);
+}
@@ -0,0 +1,330 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_streams.h"
+#include "zend_exceptions.h"
+#include "php_striter.h"
+
+// Bytes that must follow a unit before it is known to be complete: one
+// full UTF-8 sequence, enough for the grapheme rules to see the next
+// codepoint and for an invalid sequence to be measured like in a string.
+#define STRITER_STREAM_LOOKAHEAD 4
+
+// Word and sentence rules can look several codepoints past a unit (WB6,
+// WB12, SB8), so those modes keep a longer window. Only a run of ignorable
+// characters or sentence punctuation longer than this could be misjudged
+// at a chunk boundary.
+#define STRITER_STREAM_SEGMENT_LOOKAHEAD 256
+
+// _StrIterStreamIterator class entry
+zend_class_entry *striter_stream_iterator_ce;
+
+// Object handlers
+static zend_object_handlers striter_stream_handlers;
+
+static zend_object *striter_stream_create_object(zend_class_entry *ce)
+{
+    striter_stream_obj *obj = zend_object_alloc(sizeof(striter_stream_obj), ce);
+    
+    zend_object_std_init(&obj->std, ce);
+    object_properties_init(&obj->std, ce);
+    
+    obj->std.handlers = &striter_stream_handlers;
+    
+    // Initialize fields
+    ZVAL_UNDEF(&obj->stream);
+    obj->mode = STRITER_MODE_GRAPHEME;
+    obj->buf = NULL;
+    obj->buf_cap = 0;
+    obj->buf_len = 0;
+    obj->buf_pos = 0;
+    obj->unit_len = 0;
+    obj->char_index = 0;
+    obj->valid_run.start = obj->valid_run.end = 0;
+    obj->start_offset = 0;
+    obj->eof = 0;
+    obj->started = 0;
+    
+    return &obj->std;
+}
+
+static void striter_stream_free_object(zend_object *object)
+{
+    striter_stream_obj *obj = striter_stream_from_obj(object);
+    
+    zval_ptr_dtor(&obj->stream);
+    if (obj->buf) {
+        efree(obj->buf);
+    }
+    
+    zend_object_std_dtor(&obj->std);
+}
+
+static size_t striter_stream_lookahead(striter_mode_t mode)
+{
+    if (mode == STRITER_MODE_WORD || mode == STRITER_MODE_SENTENCE) {
+        return STRITER_STREAM_SEGMENT_LOOKAHEAD;
+    }
+    return STRITER_STREAM_LOOKAHEAD;
+}
+
+// Read the next chunk. The bytes before the current unit are dropped
+// first, so the buffer only grows when a single unit outgrows it.
+static void striter_stream_fill(striter_stream_obj *obj)
+{
+    php_stream *stream;
+    
+    if (obj->eof) {
+        return;
+    }
+    
+    php_stream_from_zval_no_verify(stream, &obj->stream);
+    if (stream == NULL) {
+        obj->eof = 1;
+        return;
+    }
+    
+    if (obj->buf_pos > 0) {
+        memmove(obj->buf, obj->buf + obj->buf_pos, obj->buf_len - obj->buf_pos);
+        obj->buf_len -= obj->buf_pos;
+        obj->buf_pos = 0;
+    }
+    if (obj->buf_len == obj->buf_cap) {
+        obj->buf_cap *= 2;
+        obj->buf = erealloc(obj->buf, obj->buf_cap);
+    }
+    
+    ssize_t n = php_stream_read(stream, obj->buf + obj->buf_len, obj->buf_cap - obj->buf_len);
+    if (n <= 0) {
+        obj->eof = 1;
+    } else {
+        obj->buf_len += (size_t)n;
+    }
+    
+    // Buffer offsets moved, so the PCRE2 engine's valid run is stale
+    obj->valid_run.start = obj->valid_run.end = 0;
+    obj->started = 1;
+}
+
+// Byte length of the current unit, reading more of the stream until the
+// unit is known to be complete. Returns 0 at the end of the stream.
+static size_t striter_stream_measure(striter_stream_obj *obj)
+{
+    if (obj->unit_len) {
+        return obj->unit_len;
+    }
+    
+    size_t lookahead = striter_stream_lookahead(obj->mode);
+    
+    for (;;) {
+        size_t avail = obj->buf_len - obj->buf_pos;
+    
+        if (avail < lookahead && !obj->eof) {
+            striter_stream_fill(obj);
+            continue;
+        }
+        if (avail == 0) {
+            return 0;
+        }
+    
+        size_t unit_len = striter_unit_length_at(obj->buf, obj->buf_len, obj->buf_pos, obj->mode, &obj->valid_run);
+    
+        // A unit that runs up to the end of the buffer may continue in the
+        // next chunk (a split sequence, or a cluster still being extended)
+        if (obj->eof || unit_len + lookahead <= avail) {
+            obj->unit_len = unit_len;
+            return unit_len;
+        }
+        striter_stream_fill(obj);
+    }
+}
+
+static void striter_stream_advance(striter_stream_obj *obj)
+{
+    size_t unit_len = striter_stream_measure(obj);
+    
+    if (unit_len) {
+        obj->buf_pos += unit_len;
+        obj->unit_len = 0;
+        obj->char_index++;
+    }
+}
+
+// Start over from where the stream was when the iterator was created.
+// Only possible before any data was read, or on seekable streams.
+static void striter_stream_rewind(striter_stream_obj *obj)
+{
+    php_stream *stream;
+    
+    if (!obj->started) {
+        return;
+    }
+    
+    php_stream_from_zval_no_verify(stream, &obj->stream);
+    if (stream == NULL || php_stream_seek(stream, obj->start_offset, SEEK_SET) != 0) {
+        zend_throw_exception(NULL, "Cannot rewind a stream iterator over a non-seekable stream", 0);
+        return;
+    }
+    
+    obj->buf_len = 0;
+    obj->buf_pos = 0;
+    obj->unit_len = 0;
+    obj->char_index = 0;
+    obj->valid_run.start = obj->valid_run.end = 0;
+    obj->eof = 0;
+    obj->started = 0;
+}
+
+// Internal iterator functions for IteratorAggregate. The read position
+// lives in the object, since the stream itself can only be read once.
+static void striter_stream_iterator_dtor(zend_object_iterator *iter)
+{
+    striter_iterator *iterator = (striter_iterator*)iter;
+    if (Z_TYPE(iterator->current_value) != IS_UNDEF) {
+        zval_ptr_dtor(&iterator->current_value);
+    }
+    zval_ptr_dtor(&iter->data);
+}
+
+static void striter_stream_iterator_rewind(zend_object_iterator *iter)
+{
+    striter_stream_rewind(striter_stream_from_obj(Z_OBJ(iter->data)));
+}
+
+static zend_result striter_stream_iterator_valid(zend_object_iterator *iter)
+{
+    striter_stream_obj *object = striter_stream_from_obj(Z_OBJ(iter->data));
+    
+    return striter_stream_measure(object) ? SUCCESS : FAILURE;
+}
+
+static zval *striter_stream_iterator_get_current(zend_object_iterator *iter)
+{
+    striter_iterator *iterator = (striter_iterator*)iter;
+    striter_stream_obj *object = striter_stream_from_obj(Z_OBJ(iter->data));
+    size_t unit_len = striter_stream_measure(object);
+    
+    if (unit_len == 0) {
+        return &EG(uninitialized_zval);
+    }
+    
+    // Store the current value in the iterator structure
+    if (Z_TYPE(iterator->current_value) != IS_UNDEF) {
+        zval_ptr_dtor(&iterator->current_value);
+    }
+    ZVAL_STR(&iterator->current_value, striter_unit_string(object->buf + object->buf_pos, unit_len));
+    return &iterator->current_value;
+}
+
+static void striter_stream_iterator_get_key(zend_object_iterator *iter, zval *key)
+{
+    striter_stream_obj *object = striter_stream_from_obj(Z_OBJ(iter->data));
+    ZVAL_LONG(key, object->char_index);
+}
+
+static void striter_stream_iterator_move_forward(zend_object_iterator *iter)
+{
+    striter_stream_advance(striter_stream_from_obj(Z_OBJ(iter->data)));
+}
+
+// Iterator function table
+static const zend_object_iterator_funcs striter_stream_iterator_funcs = {
+    striter_stream_iterator_dtor,
+    striter_stream_iterator_valid,
+    striter_stream_iterator_get_current,
+    striter_stream_iterator_get_key,
+    striter_stream_iterator_move_forward,
+    striter_stream_iterator_rewind,
+    NULL,
+    NULL,
+};
+
+// Get iterator handler for IteratorAggregate
+static zend_object_iterator *striter_stream_get_iterator(zend_class_entry *ce, zval *object, int by_ref)
+{
+    if (by_ref) {
+        zend_throw_error(NULL, "An iterator cannot be used with foreach by reference");
+        return NULL;
+    }
+    
+    striter_iterator *iterator = emalloc(sizeof(striter_iterator));
+    zend_iterator_init((zend_object_iterator*)iterator);
+    
+    ZVAL_OBJ_COPY(&iterator->intern.data, Z_OBJ_P(object));
+    iterator->intern.funcs = &striter_stream_iterator_funcs;
+    iterator->current_pos = 0;
+    iterator->byte_pos = 0;
+    iterator->unit_len = 0;
+    ZVAL_UNDEF(&iterator->current_value);
+    
+    return &iterator->intern;
+}
+
+// str_iter_stream function implementation
+PHP_FUNCTION(str_iter_stream)
+{
+    zval *zstream;
+    zend_string *mode = NULL;
+    zend_long chunk_size = 65536;
+    php_stream *stream;
+    
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_RESOURCE(zstream)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_STR(mode)
+        Z_PARAM_LONG(chunk_size)
+    ZEND_PARSE_PARAMETERS_END();
+    
+    php_stream_from_zval(stream, zstream);
+    
+    if (chunk_size < STRITER_STREAM_LOOKAHEAD) {
+        zend_argument_value_error(3, "must be at least %d", STRITER_STREAM_LOOKAHEAD);
+        RETURN_THROWS();
+    }
+    
+    object_init_ex(return_value, striter_stream_iterator_ce);
+    striter_stream_obj *obj = striter_stream_from_obj(Z_OBJ_P(return_value));
+    
+    ZVAL_COPY(&obj->stream, zstream);
+    obj->mode = mode != NULL ? striter_parse_mode(ZSTR_VAL(mode)) : STRITER_MODE_GRAPHEME;
+    obj->buf_cap = (size_t)chunk_size;
+    obj->buf = emalloc(obj->buf_cap);
+    obj->start_offset = php_stream_tell(stream);
+}
+
+// _StrIterStreamIterator::getIterator method
+PHP_METHOD(_StrIterStreamIterator, getIterator)
+{
+    ZEND_PARSE_PARAMETERS_NONE();
+    
+    // Return self; foreach goes through the get_iterator handler
+    RETURN_ZVAL(ZEND_THIS, 1, 0);
+}
+
+// Method entries for _StrIterStreamIterator class
+static const zend_function_entry striter_stream_methods[] = {
+    PHP_ME(_StrIterStreamIterator, getIterator, arginfo_striteriterator_getiterator, ZEND_ACC_PUBLIC)
+    PHP_FE_END
+};
+
+// Initialize _StrIterStreamIterator class
+void striter_stream_iterator_init(void)
+{
+    zend_class_entry ce;
+    INIT_CLASS_ENTRY(ce, "_StrIterStreamIterator", striter_stream_methods);
+    striter_stream_iterator_ce = zend_register_internal_class(&ce);
+    striter_stream_iterator_ce->create_object = striter_stream_create_object;
+    
+    // Set up object handlers
+    memcpy(&striter_stream_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+    striter_stream_handlers.free_obj = striter_stream_free_object;
+    striter_stream_handlers.offset = XtOffsetOf(striter_stream_obj, std);
+    striter_stream_handlers.clone_obj = NULL;
+    
+    // Set get_iterator handler for IteratorAggregate
+    striter_stream_iterator_ce->get_iterator = striter_stream_get_iterator;
+    
+    zend_class_implements(striter_stream_iterator_ce, 1, zend_ce_aggregate);
+}
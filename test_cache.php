@@ -0,0 +1,77 @@
+<?php
+// Test for the segmentation cache (striter.cache_size)
+
+echo "Test: Segmentation cache\n";
+
+// Cache counters from phpinfo(); they are only shown while the cache is on
+function cache_stats(): array {
+    ob_start();
+    phpinfo(INFO_MODULES);
+    $info = ob_get_clean();
+    preg_match_all('/^Cache (hits|misses|evictions) => (\d+)/m', $info, $m);
+    return array_combine($m[1], array_map("intval", $m[2]));
+}
+
+function cache_delta(array $before): string {
+    $after = cache_stats();
+    return sprintf("hits +%d, misses +%d", $after["hits"] - $before["hits"], $after["misses"] - $before["misses"]);
+}
+
+const TEMPLATE = "Héllo {name}, 👨‍👩‍👧 wörld! Ünïcödé e\u{301} text 🇯🇵 repeated for a while. ";
+
+ini_set("striter.cache_size", "1M");
+
+// Test 1: a literal is counted once; later iterators over it start counted
+echo "Test 1: Count\n";
+$before = cache_stats();
+$counts = [];
+for ($i = 0; $i < 3; $i++) {
+    $counts[] = count(str_iter(TEMPLATE));
+}
+echo "counts: " . implode(",", $counts) . " (" . cache_delta($before) . ")\n";
+echo "\n";
+
+// Test 2: once a cursor has walked the whole string, its index is cached
+// too, and random access through it agrees with an uncached string
+echo "Test 2: Index\n";
+foreach (str_iter(TEMPLATE, "codepoint") as $unit) {
+}
+$before = cache_stats();
+$cached = str_iter(TEMPLATE, "codepoint");
+$fresh = str_iter(substr(TEMPLATE . "x", 0, -1), "codepoint");
+$ok = true;
+for ($i = -count($fresh); $i < count($fresh); $i++) {
+    $ok = $ok && $cached[$i] === $fresh[$i];
+}
+echo "offsets: " . ($ok ? "match" : "MISMATCH") . " (" . cache_delta($before) . ")\n";
+echo "reverse: " . (str_iter_reverse(TEMPLATE, "codepoint")->toArray() === array_reverse($fresh->toArray()) ? "match" : "MISMATCH") . "\n";
+echo "\n";
+
+// Test 3: strings built at run time are not interned and never cached
+echo "Test 3: Non-interned strings\n";
+$before = cache_stats();
+$built = str_repeat("é", 10);
+count(str_iter($built));
+count(str_iter($built));
+echo cache_delta($before) . "\n";
+echo "\n";
+
+// Test 4: the least recently used entries are evicted to fit the budget
+echo "Test 4: Eviction\n";
+ini_set("striter.cache_size", "1K");
+$before = cache_stats();
+foreach (["alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta", "iota", "kappa", "lambda", "mu", "nu", "xi", "omicron", "pi"] as $word) {
+    count(str_iter($word));
+}
+echo "evicted: " . (cache_stats()["evictions"] > $before["evictions"] ? "yes" : "no") . "\n";
+echo "\n";
+
+// Test 5: invalid budgets are rejected
+echo "Test 5: INI validation\n";
+var_dump(ini_set("striter.cache_size", "-1"));
+var_dump(ini_set("striter.cache_size", "4X"));
+var_dump(ini_get("striter.cache_size"));
+echo "\n";
+
+echo "Segmentation cache tests completed!\n";
+?>
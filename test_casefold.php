@@ -0,0 +1,54 @@
+<?php
+// Test for str_iter_casecmp() and str_iter_starts_with_folded()
+
+echo "Test: Case folding\n";
+
+// Test 1: full folding matches across scripts and expansions
+echo "Test 1: str_iter_casecmp()\n";
+$pairs = [
+    ["Hello", "hELLO"],
+    ["Straße", "STRASSE"],
+    ["ΣΊΣΥΦΟΣ", "σίσυφος"],
+    ["ﬁle", "FILE"],
+    ["apple", "banana"],
+    ["abc", "ab"],
+    ["", ""],
+];
+foreach ($pairs as [$a, $b]) {
+    printf("%-10s %-10s full %2d  simple %2d\n", $a, $b, str_iter_casecmp($a, $b), str_iter_casecmp($a, $b, "grapheme", false));
+}
+echo "\n";
+
+// Test 2: byte mode folds ASCII letters only, like strcasecmp()
+echo "Test 2: Byte mode\n";
+foreach ([["ABC", "abc"], ["É", "é"], ["a", "B"]] as [$a, $b]) {
+    printf("%s %s: %d (strcasecmp %d)\n", $a, $b, str_iter_casecmp($a, $b, "byte"), max(-1, min(1, strcasecmp($a, $b))));
+}
+echo "\n";
+
+// Test 3: a prefix has to end on a unit boundary of the string
+echo "Test 3: str_iter_starts_with_folded()\n";
+$cases = [
+    ["Straße", "STRASS", "grapheme"],
+    ["Straße", "STRAS", "grapheme"],
+    ["Cafe\u{301} au lait", "CAFE", "grapheme"],
+    ["Cafe\u{301} au lait", "CAFE", "codepoint"],
+    ["Cafe\u{301} au lait", "CAFÉ", "grapheme"],
+    ["Foobar baz", "FOO", "grapheme"],
+    ["Foobar baz", "FOO", "word"],
+    ["Foobar baz", "FOOBAR", "word"],
+    ["anything", "", "grapheme"],
+];
+foreach ($cases as [$str, $prefix, $mode]) {
+    printf("%-18s %-7s %-9s %s\n", $str, $prefix, $mode, var_export(str_iter_starts_with_folded($str, $prefix, $mode), true));
+}
+echo "\n";
+
+// Test 4: invalid bytes only match the same bytes
+echo "Test 4: Invalid UTF-8\n";
+var_dump(str_iter_casecmp("A\xFF", "a\xFF"));
+var_dump(str_iter_casecmp("\xC3", "\xC3\xA9"));
+var_dump(str_iter_starts_with_folded("\xFFabc", "\xFFA"));
+
+echo "\nAll tests completed.\n";
+?>
@@ -0,0 +1,73 @@
+<?php
+// Test for chunked iteration: str_iter_chunks() and the chunk options
+
+echo "Test: Chunks\n";
+
+$text = "Héllo 👨‍👩‍👧 wörld e\u{301}! 🇯🇵🇫🇷 ok";
+
+// Test 1: N units per step; the last chunk may be shorter
+echo "Test 1: str_iter_chunks()\n";
+foreach (str_iter_chunks($text, 4) as $i => $chunk) {
+    echo "[$i] '$chunk'\n";
+}
+echo "count: " . count(str_iter_chunks($text, 4)) . "\n";
+echo "codepoints: " . implode("|", str_iter_chunks("abcdefg", 3, "codepoint")->toArray()) . "\n";
+echo "words: " . implode("|", str_iter_chunks("one two three four", 2, "word")->toArray()) . "\n";
+echo "\n";
+
+// Test 2: up to N bytes, never cutting a unit; a unit longer than N is a
+// chunk of its own
+echo "Test 2: chunk_bytes option\n";
+foreach (str_iter($text, "grapheme", ["chunk_bytes" => 8]) as $chunk) {
+    echo strlen($chunk) . ":'$chunk' ";
+}
+echo "\n";
+echo "bytes: " . implode("|", str_iter("abcdefg", "byte", ["chunk_bytes" => 3])->toArray()) . "\n";
+echo "\n";
+
+// Test 3: chunks joined give the string back, and the chunks match the
+// units grouped by hand, in every mode
+echo "Test 3: Same as grouped units\n";
+$long = str_repeat($text . "\n", 50);
+foreach (["grapheme", "codepoint", "byte", "word", "sentence", "line"] as $mode) {
+    $units = str_iter($long, $mode)->toArray();
+    $grouped = array_map("implode", array_chunk($units, 16));
+    $chunks = str_iter($long, $mode, ["chunk" => 16])->toArray();
+    $bytes = str_iter($long, $mode, ["chunk_bytes" => 64])->toArray();
+    $fits = true;
+    foreach ($bytes as $chunk) {
+        $fits = $fits && (strlen($chunk) <= 64 || count(str_iter($chunk, $mode)) === 1);
+    }
+    printf("%-9s chunk: %s, chunk_bytes: %s\n", $mode,
+        $chunks === $grouped ? "same" : "DIFFERENT",
+        implode("", $bytes) === $long && $fits ? "ok" : "WRONG");
+}
+echo "\n";
+
+// Test 4: cursor methods and offsets move by chunk
+echo "Test 4: Cursor and offsets\n";
+$it = str_iter_chunks($text, 5);
+echo "it[1]: '" . $it[1] . "', it[-1]: '" . $it[-1] . "'\n";
+$it->end();
+echo "end: " . $it->key() . " '" . $it->current() . "'\n";
+$it->prev();
+echo "prev: " . $it->key() . " '" . $it->current() . "'\n";
+echo "reverse: " . implode("|", str_iter_reverse("abcdefg", "codepoint", ["chunk" => 3])->toArray()) . "\n";
+echo "offsets: " . json_encode(str_iter("abcdefg", "codepoint", ["chunk" => 3, "offsets" => true])->toArray()) . "\n";
+echo "substitute: " . implode("|", str_iter("ab\xFFcd\xFE", "codepoint", ["chunk" => 3, "substitute" => true])->toArray()) . "\n";
+echo "\n";
+
+// Test 5: invalid sizes
+echo "Test 5: Errors\n";
+foreach ([fn() => str_iter_chunks("abc", 0),
+          fn() => str_iter("abc", "grapheme", ["chunk" => "2"]),
+          fn() => str_iter("abc", "grapheme", ["chunk" => 2, "chunk_bytes" => 8])] as $fn) {
+    try {
+        $fn();
+    } catch (ValueError $e) {
+        echo get_class($e) . ": " . $e->getMessage() . "\n";
+    }
+}
+
+echo "\nAll tests completed.\n";
+?>
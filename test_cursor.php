@@ -0,0 +1,51 @@
+<?php
+// Test for the cursor-based iteration engine
+
+echo "Test: Cursor-based iteration\n";
+
+// Test 1: Units concatenate back to the original string in every mode
+echo "Test 1: Round trip\n";
+$str = "Hello世界🌍\r\n👨‍👩‍👧 café\xFF!";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $joined = "";
+    foreach (str_iter($str, $mode) as $char) {
+        $joined .= $char;
+    }
+    echo "$mode: " . ($joined === $str ? "OK" : "FAILED") . "\n";
+}
+echo "\n";
+
+// Test 2: current() is stable when called repeatedly
+echo "Test 2: Repeated current()\n";
+$iter = str_iter("A👋🏽B");
+$iter->rewind();
+$iter->next();
+echo "First:  '" . $iter->current() . "'\n";
+echo "Second: '" . $iter->current() . "'\n";
+echo "Key: " . $iter->key() . "\n";
+echo "\n";
+
+// Test 3: foreach and manual iteration keep independent cursors
+echo "Test 3: Independent cursors\n";
+$iter = str_iter("XYZ");
+$iter->rewind();
+$iter->next();
+foreach ($iter as $key => $char) {
+    echo "  foreach [$key] => '$char', manual => '" . $iter->current() . "'\n";
+}
+echo "\n";
+
+// Test 4: Long string iterates in linear time
+echo "Test 4: Long string\n";
+$long = str_repeat("ab🌍", 100000);
+$start = microtime(true);
+$count = 0;
+foreach (str_iter($long) as $char) {
+    $count++;
+}
+echo "Units: $count\n";
+echo "Fast enough: " . ((microtime(true) - $start) < 5 ? "Yes" : "No") . "\n";
+echo "\n";
+
+echo "Cursor tests completed!\n";
+?>
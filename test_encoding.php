@@ -0,0 +1,79 @@
+<?php
+// Test for the encoding option
+
+echo "Test: Encodings\n";
+
+function hex(string $s): string {
+    return bin2hex($s);
+}
+
+function utf16(string $s, string $encoding): string {
+    return mb_convert_encoding($s, $encoding, "UTF-8");
+}
+
+// Test 1: the same text in every encoding yields the same units
+echo "Test 1: Same units as UTF-8\n";
+$text = "Crème brûlée, e\u{301}t\u{E9}. 👨‍👩‍👧 🇫🇷 한국어\r\nNext line?";
+foreach (["UTF-16LE", "UTF-16BE"] as $encoding) {
+    $source = utf16($text, $encoding);
+    foreach (["grapheme", "codepoint", "word", "sentence", "line"] as $mode) {
+        $units = str_iter($source, $mode, ["encoding" => $encoding])->toArray();
+        printf("%s %-9s %s\n", $encoding, $mode, $units === str_iter($text, $mode)->toArray() ? "same" : "DIFFERENT");
+    }
+}
+$latin1 = "Cr\xE8me br\xFBl\xE9e \xAB\xA0\xE0 la fran\xE7aise\xA0\xBB\r\n";
+$units = str_iter($latin1, null, ["encoding" => "ISO-8859-1"])->toArray();
+echo "ISO-8859-1: " . ($units === str_iter(mb_convert_encoding($latin1, "UTF-8", "ISO-8859-1"))->toArray() ? "same" : "DIFFERENT") . "\n";
+echo "\n";
+
+// Test 2: counts, keys and offsets are those of the source string
+echo "Test 2: Source positions\n";
+$source = utf16("a\u{E9}😀e\u{301}", "UTF-16LE");
+$it = str_iter($source, null, ["encoding" => "UTF-16LE"]);
+echo "count: " . count($it) . "\n";
+foreach ($it as $key => $unit) {
+    echo "$key: " . hex($unit) . "\n";
+}
+echo "offsets: " . json_encode(str_iter($source, null, ["encoding" => "UTF-16LE", "offsets" => true])->toArray()) . "\n";
+echo "reverse: " . implode(" ", array_map("hex", str_iter_reverse($source, "codepoint", ["encoding" => "UTF-16LE"])->toArray())) . "\n";
+echo "byte mode: " . count(str_iter($source, "byte", ["encoding" => "UTF-16LE"])) . "\n";
+echo "\n";
+
+// Test 3: encoding names are matched without case, with an alias each
+echo "Test 3: Names\n";
+foreach (["utf-16le", "UTF-16BE", "latin-1", "iso-8859-1", "utf8"] as $name) {
+    echo "$name: " . hex(implode(str_iter("\xE9\x00", "codepoint", ["encoding" => $name])->toArray())) . "\n";
+}
+echo "\n";
+
+// Test 4: invalid sequences yield U+FFFD, or fail in strict mode
+echo "Test 4: Invalid UTF-16\n";
+// A lone high surrogate, then a trailing odd byte
+$source = "a\x00\x00\xD8b\x00c";
+echo "units: " . implode(" ", array_map("hex", str_iter($source, null, ["encoding" => "UTF-16LE"])->toArray())) . "\n";
+try {
+    str_iter($source, null, ["encoding" => "UTF-16LE", "strict" => true]);
+} catch (ValueError $e) {
+    echo $e->getMessage() . "\n";
+}
+echo "\n";
+
+// Test 5: chunks and normalization work on the decoded units
+echo "Test 5: Chunk and normalize\n";
+$source = utf16("e\u{301}a\u{308}xyz", "UTF-16BE");
+echo "chunk: " . implode(" ", array_map("hex", str_iter($source, null, ["encoding" => "UTF-16BE", "chunk" => 2])->toArray())) . "\n";
+echo "NFC: " . implode(" ", array_map("hex", str_iter($source, null, ["encoding" => "UTF-16BE", "normalize" => "NFC"])->toArray())) . "\n";
+echo "\n";
+
+// Test 6: anything else is rejected
+echo "Test 6: Bad encoding\n";
+foreach (["UTF-32", 16] as $encoding) {
+    try {
+        str_iter("x", null, ["encoding" => $encoding]);
+    } catch (ValueError $e) {
+        echo $e->getMessage() . "\n";
+    }
+}
+
+echo "\nAll tests completed.\n";
+?>
@@ -0,0 +1,43 @@
+<?php
+// Test for str_iter_file()
+
+echo "Test: File iteration\n";
+
+$str = str_repeat("Hello世界🌍👋🏽!\r\ne\u{301}🇯🇵 ", 300);
+$path = tempnam(sys_get_temp_dir(), "striter");
+
+// Test 1: a mapped file iterates like the same string
+echo "Test 1: Same units as str_iter()\n";
+file_put_contents($path, $str);
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $iter = str_iter_file($path, $mode);
+    $same = $iter->toArray() === str_iter($str, $mode)->toArray();
+    echo "$mode: " . count($iter) . " units, " . ($same ? "match" : "MISMATCH") . "\n";
+}
+echo "\n";
+
+// Test 2: random access and offsets work on mapped files
+echo "Test 2: Random access\n";
+$iter = str_iter_file($path, "grapheme");
+echo $iter[7] . " " . $iter[-1] . " " . json_encode(str_iter_file($path)->currentOffset()) . "\n";
+echo "\n";
+
+// Test 3: sizes around the page size, where the terminating NUL comes from
+// the zero page after the mapping
+echo "Test 3: Page-sized files\n";
+foreach ([4095, 4096, 4097, 8192] as $size) {
+    file_put_contents($path, str_repeat("x", $size));
+    echo "$size: " . count(str_iter_file($path, "byte")) . "\n";
+}
+echo "\n";
+
+// Test 4: empty and missing files
+echo "Test 4: Edge cases\n";
+file_put_contents($path, "");
+echo "empty: " . count(str_iter_file($path)) . "\n";
+unlink($path);
+var_dump(@str_iter_file($path));
+echo "\n";
+
+echo "File tests completed!\n";
+?>
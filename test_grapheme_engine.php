@@ -0,0 +1,54 @@
+<?php
+// Test for the native grapheme engine
+
+echo "Test: Native grapheme engine\n";
+echo "Engine: " . ini_get("striter.grapheme_engine") . "\n\n";
+
+$cases = [
+    "CR LF" => "a\r\nb",
+    "Combining mark" => "e\u{0301}x",
+    "Flags" => "🇯🇵🇺🇸🇫",
+    "Skin tone" => "👋🏽👋🏽",
+    "ZWJ family" => "👨‍👩‍👧‍👦",
+    "Tag sequence" => "🏴󠁧󠁢󠁥󠁮󠁧󠁿🏴",
+    "Hangul jamo" => "\u{1100}\u{1161}\u{11A8}가",
+    "Devanagari" => "क्षि",
+    "Prepend" => "\u{0600}1",
+    "Invalid byte" => "e\u{0301}\xFFx",
+];
+
+// Test 1: Segmentation of rule-specific sequences
+echo "Test 1: Segmentation\n";
+foreach ($cases as $name => $str) {
+    $parts = [];
+    foreach (str_iter($str) as $char) {
+        $parts[] = bin2hex($char);
+    }
+    echo "$name: " . count($parts) . " [" . implode(" ", $parts) . "]\n";
+}
+echo "\n";
+
+// Test 2: Cross-check against the PCRE2 engine when it is built in
+echo "Test 2: Cross-check with PCRE2\n";
+if (@ini_set("striter.grapheme_engine", "pcre2") === false) {
+    echo "PCRE2 engine not available\n";
+} else {
+    foreach ($cases as $name => $str) {
+        ini_set("striter.grapheme_engine", "native");
+        $native = iterator_to_array(str_iter($str));
+        ini_set("striter.grapheme_engine", "pcre2");
+        $pcre2 = iterator_to_array(str_iter($str));
+        echo "$name: " . ($native === $pcre2 ? "same" : "DIFFERENT") . "\n";
+    }
+    ini_set("striter.grapheme_engine", "native");
+}
+echo "\n";
+
+// Test 3: Unknown engines are rejected
+echo "Test 3: Unknown engine\n";
+var_dump(@ini_set("striter.grapheme_engine", "icu"));
+echo "Engine: " . ini_get("striter.grapheme_engine") . "\n";
+echo "\n";
+
+echo "Grapheme engine tests completed!\n";
+?>
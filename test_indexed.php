@@ -0,0 +1,60 @@
+<?php
+// Test for the indexed option: a compact table of every unit boundary
+
+echo "Test: Indexed iterators\n";
+
+$text = "Héllo wörld. 👨‍👩‍👧 e\u{301} こんにちは世界!\nNew line 🇯🇵 here. ";
+$long = "e" . str_repeat("\u{301}", 200);           // One cluster of 401 bytes
+$text = str_repeat($text, 20) . $long . str_repeat($text, 20);
+
+// Test 1: every unit, forwards and backwards, and every offset agree with
+// an iterator without the index
+echo "Test 1: Same units as without the index\n";
+foreach (["grapheme", "codepoint", "byte", "word", "sentence", "line"] as $mode) {
+    $plain = str_iter($text, $mode);
+    $indexed = str_iter($text, $mode, ["indexed" => true]);
+    $n = count($plain);
+    $same = count($indexed) === $n && $indexed->toArray() === $plain->toArray();
+    for ($i = -$n; $i < $n; $i += 7) {
+        $same = $same && $indexed[$i] === $plain[$i];
+    }
+    $indexed->end();
+    $plain->end();
+    while ($same && $plain->valid()) {
+        $same = $indexed->key() === $plain->key() && $indexed->current() === $plain->current();
+        $indexed->prev();
+        $plain->prev();
+    }
+    printf("%-9s %4d units: %s\n", $mode, $n, $same ? "same" : "DIFFERENT");
+}
+echo "\n";
+
+// Test 2: a cluster too long for a one-byte length
+echo "Test 2: Long cluster\n";
+$it = str_iter($text, "grapheme", ["indexed" => true]);
+$at = count(str_iter(str_repeat("Héllo wörld. 👨‍👩‍👧 e\u{301} こんにちは世界!\nNew line 🇯🇵 here. ", 20)));
+echo "length: " . strlen($it[$at]) . ", next: " . $it[$at + 1] . "\n";
+$it->seek($at);
+$it->next();
+echo "after seek and next: key " . $it->key() . ", '" . $it->current() . "'\n";
+echo "\n";
+
+// Test 3: the index is built by the first pass, at about a byte per unit
+echo "Test 3: Memory\n";
+$ascii = str_repeat("The quick brown fox jumps over the lazy dog. ", 2000);
+$it = str_iter($ascii, "grapheme", ["indexed" => true]);
+echo "before first pass: " . $it->indexSize() . " bytes\n";
+count($it);
+printf("after count(): %.2f bytes per unit\n", $it->indexSize() / count($it));
+echo "byte mode: " . str_iter($ascii, "byte", ["indexed" => true])->indexSize() . " bytes\n";
+echo "\n";
+
+// Test 4: foreach builds the index as it goes
+echo "Test 4: Built during foreach\n";
+$it = str_iter("a👍b🇯🇵c", "grapheme", ["indexed" => true]);
+foreach ($it as $unit) {
+}
+echo $it[3] . " " . $it[-1] . " " . $it[1] . "\n";
+
+echo "\nAll tests completed.\n";
+?>
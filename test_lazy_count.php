@@ -0,0 +1,53 @@
+<?php
+// Test for lazily computed count()
+
+echo "Test: Lazy count\n";
+
+$str = "Hello世界🌍👋🏽!";
+
+// Test 1: count() before any iteration
+echo "Test 1: count() first\n";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    echo "$mode: " . count(str_iter($str, $mode)) . "\n";
+}
+echo "\n";
+
+// Test 2: count() after a partial manual scan matches a fresh count
+echo "Test 2: count() after partial iteration\n";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $iter = str_iter($str, $mode);
+    $iter->rewind();
+    for ($i = 0; $i < 6; $i++) {
+        $iter->next();
+    }
+    $fresh = count(str_iter($str, $mode));
+    echo "$mode: " . count($iter) . " (fresh: $fresh)\n";
+}
+echo "\n";
+
+// Test 3: count() after breaking out of foreach
+echo "Test 3: count() after early break\n";
+$iter = str_iter($str);
+foreach ($iter as $key => $char) {
+    if ($key == 3) {
+        break;
+    }
+}
+echo "Count: " . $iter->count() . "\n";
+echo "\n";
+
+// Test 4: valid() works without a count
+echo "Test 4: valid() without count\n";
+$iter = str_iter("AB");
+$iter->rewind();
+$n = 0;
+while ($iter->valid()) {
+    $iter->next();
+    $n++;
+}
+echo "Steps: $n, count: " . count($iter) . "\n";
+echo "Empty valid: " . (str_iter("")->valid() ? "true" : "false") . "\n";
+echo "\n";
+
+echo "Lazy count tests completed!\n";
+?>
@@ -0,0 +1,73 @@
+<?php
+// Test for the normalize option
+
+echo "Test: Normalization\n";
+
+function hex(string $s): string {
+    return bin2hex($s);
+}
+
+// Test 1: composed and decomposed forms of the same text
+echo "Test 1: NFC and NFD\n";
+$decomposed = "e\u{301}a\u{308}\u{1100}\u{1161}\u{11A8}";
+$composed = "\u{E9}\u{E4}\u{AC01}";
+foreach (["NFC", "NFD"] as $form) {
+    foreach (["composed" => $composed, "decomposed" => $decomposed] as $name => $text) {
+        $units = str_iter($text, null, ["normalize" => $form])->toArray();
+        echo "$form $name: " . implode(" ", array_map("hex", $units)) . "\n";
+    }
+}
+echo "\n";
+
+// Test 2: marks are put in canonical order, and a blocked mark stays apart
+echo "Test 2: Reordering\n";
+// a + acute (230) + dot below (220): the dot goes first and composes with
+// the a, and the acute is left over
+$text = "a\u{301}\u{323}";
+echo "NFD: " . hex(implode(str_iter($text, null, ["normalize" => "NFD"])->toArray())) . "\n";
+echo "NFC: " . hex(implode(str_iter($text, null, ["normalize" => "NFC"])->toArray())) . "\n";
+echo "\n";
+
+// Test 3: units are found in the source; normalizing them one by one is
+// normalizing the string
+echo "Test 3: Same as Normalizer\n";
+if (class_exists("Normalizer")) {
+    $text = str_repeat("Ame\u{301}lie \u{1E9B}\u{323} \u{212B} \u{2126} 한국어 \u{1100}\u{1161} 👨‍👩‍👧 q\u{307}\u{323}. ", 20);
+    foreach (["NFC" => Normalizer::FORM_C, "NFD" => Normalizer::FORM_D] as $form => $intl) {
+        foreach (["grapheme", "word", "sentence", "line"] as $mode) {
+            $joined = implode(str_iter($text, $mode, ["normalize" => $form])->toArray());
+            printf("%s %-9s %s\n", $form, $mode, $joined === Normalizer::normalize($text, $intl) ? "same" : "DIFFERENT");
+        }
+    }
+} else {
+    echo "intl not loaded, skipped\n";
+}
+echo "\n";
+
+// Test 4: counts, offsets and keys are those of the source string
+echo "Test 4: Source positions\n";
+$it = str_iter("e\u{301}x", null, ["normalize" => "NFC"]);
+echo "count: " . count($it) . "\n";
+echo "offsets: " . json_encode(str_iter("e\u{301}x", null, ["normalize" => "NFC", "offsets" => true])->toArray()) . "\n";
+echo "byte mode: " . hex(implode(str_iter("e\u{301}", "byte", ["normalize" => "NFC"])->toArray())) . "\n";
+echo "\n";
+
+// Test 5: invalid sequences pass through, or are substituted
+echo "Test 5: Invalid UTF-8\n";
+$text = "e\u{301}\xFF\u{301}";
+echo "copied: " . hex(implode(str_iter($text, null, ["normalize" => "NFC"])->toArray())) . "\n";
+echo "chunk: " . hex(implode(str_iter($text, null, ["normalize" => "NFC", "chunk" => 4, "substitute" => true])->toArray())) . "\n";
+echo "\n";
+
+// Test 6: anything but NFC or NFD is rejected
+echo "Test 6: Bad form\n";
+foreach (["NFKC", 1] as $form) {
+    try {
+        str_iter("x", null, ["normalize" => $form]);
+    } catch (ValueError $e) {
+        echo $e->getMessage() . "\n";
+    }
+}
+
+echo "\nAll tests completed.\n";
+?>
@@ -0,0 +1,43 @@
+<?php
+// Test for the offsets option and currentOffset()
+
+echo "Test: Offsets\n";
+
+$str = "Hi世界🌍👋🏽!";
+
+// Test 1: foreach yields [byteOffset, byteLength] pairs that slice back to the units
+echo "Test 1: Offset pairs\n";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $pairs = [];
+    $ok = true;
+    $units = iterator_to_array(str_iter($str, $mode));
+    foreach (str_iter($str, $mode, ["offsets" => true]) as $i => [$offset, $length]) {
+        $pairs[] = "$offset+$length";
+        $ok = $ok && substr($str, $offset, $length) === $units[$i];
+    }
+    echo "$mode: " . implode(" ", $pairs) . ($ok ? " (slices match)" : " (MISMATCH)") . "\n";
+}
+echo "\n";
+
+// Test 2: current(), offsetGet() and toArray() follow the option
+echo "Test 2: Other accessors\n";
+$iter = str_iter($str, "grapheme", ["offsets" => true]);
+$iter->rewind();
+$iter->next();
+$iter->next();
+echo json_encode($iter->current()) . " " . json_encode($iter[5]) . " " . json_encode($iter->toArray()) . "\n";
+echo "\n";
+
+// Test 3: currentOffset() tracks the cursor in either form
+echo "Test 3: currentOffset\n";
+$iter = str_iter($str);
+$offsets = [];
+for ($iter->rewind(); $iter->valid(); $iter->next()) {
+    $offsets[] = $iter->currentOffset();
+}
+echo implode(",", $offsets) . "\n";
+var_dump($iter->currentOffset());
+echo "\n";
+
+echo "Offset tests completed!\n";
+?>
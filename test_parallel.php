@@ -0,0 +1,61 @@
+<?php
+// Test for striter.threads: parallel count() and index building
+
+echo "Test: Parallel segmentation\n";
+
+// Large enough for several threads (each gets at least 1 MiB), and built
+// from pieces whose clusters span many bytes, so split points land inside
+// ZWJ sequences, flag pairs, Hangul syllables, CR LF and invalid bytes
+$pieces = ["a", "é", "👨‍👩‍👧", "\r", "\n", "こ", "\xFF", "e\u{301}", "🇯🇵", "🇺", "\u{200D}", "\u{1100}\u{1161}", "abcdefgh "];
+mt_srand(14);
+$str = "";
+while (strlen($str) < (6 << 20)) {
+    $str .= $pieces[mt_rand(0, count($pieces) - 1)];
+}
+
+// Test 1: count() is the same with and without threads
+echo "Test 1: count()\n";
+foreach (["grapheme", "codepoint"] as $mode) {
+    ini_set("striter.threads", "0");
+    $serial = count(str_iter($str, $mode));
+    $counts = [];
+    foreach ([2, 3, 4, 8] as $threads) {
+        ini_set("striter.threads", (string)$threads);
+        $counts[] = count(str_iter($str, $mode));
+    }
+    echo "$mode: " . (array_unique($counts) === [$serial] ? "match" : "MISMATCH " . implode(",", $counts) . " vs $serial") . "\n";
+}
+echo "\n";
+
+// Test 2: random access through the parallel index, after a partial walk
+echo "Test 2: Random access\n";
+foreach (["grapheme", "codepoint"] as $mode) {
+    ini_set("striter.threads", "0");
+    $serial = str_iter($str, $mode);
+    ini_set("striter.threads", "4");
+    $parallel = str_iter($str, $mode);
+    foreach ($parallel as $i => $unit) {
+        if ($i == 1000) {
+            break;
+        }
+    }
+    $ok = true;
+    $n = count($serial);
+    mt_srand(1);
+    for ($i = 0; $i < 2000; $i++) {
+        $index = mt_rand(0, $n - 1);
+        $ok = $ok && $parallel[$index] === $serial[$index];
+    }
+    $ok = $ok && $parallel[$n - 1] === $serial[$n - 1] && !isset($parallel[$n]);
+    echo "$mode: " . ($ok ? "match" : "MISMATCH") . "\n";
+}
+echo "\n";
+
+// Test 3: out-of-range values are rejected
+echo "Test 3: INI validation\n";
+var_dump(ini_set("striter.threads", "65"));
+var_dump(ini_get("striter.threads"));
+echo "\n";
+
+echo "Parallel tests completed!\n";
+?>
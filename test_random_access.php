@@ -0,0 +1,82 @@
+<?php
+// Test for ArrayAccess and seek()
+
+echo "Test: Random access\n";
+
+$str = "Hello世界🌍👋🏽!";
+
+// Test 1: offsetGet in every mode, including negative offsets
+echo "Test 1: offsetGet\n";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $iter = str_iter($str, $mode);
+    echo "$mode: [0]=" . bin2hex($iter[0]) . " [5]=" . bin2hex($iter[5]) . " [-1]=" . bin2hex($iter[-1]) . "\n";
+}
+echo "\n";
+
+// Test 2: offsets agree with foreach on a string spanning many checkpoints
+echo "Test 2: offsetGet matches foreach\n";
+$long = str_repeat("ab👨‍👩‍👧c\r\né", 500);
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $units = iterator_to_array(str_iter($long, $mode));
+    $iter = str_iter($long, $mode);
+    $ok = true;
+    mt_srand(1);
+    for ($i = 0; $i < 500; $i++) {
+        $k = mt_rand(0, count($units) - 1);
+        $ok = $ok && $iter[$k] === $units[$k];
+    }
+    echo "$mode: " . ($ok ? "match" : "MISMATCH") . "\n";
+}
+echo "\n";
+
+// Test 3: offsetExists / isset
+echo "Test 3: isset\n";
+$iter = str_iter($str);
+var_dump(isset($iter[0]), isset($iter[9]), isset($iter[10]), isset($iter[-10]), isset($iter[-11]));
+echo "\n";
+
+// Test 4: out of range and invalid offsets
+echo "Test 4: Errors\n";
+foreach ([10, -11] as $offset) {
+    try {
+        $iter[$offset];
+    } catch (OutOfBoundsException $e) {
+        echo get_class($e) . ": " . $e->getMessage() . "\n";
+    }
+}
+try {
+    $iter["x"];
+} catch (TypeError $e) {
+    echo get_class($e) . ": " . $e->getMessage() . "\n";
+}
+try {
+    $iter[0] = "x";
+} catch (Error $e) {
+    echo get_class($e) . ": " . $e->getMessage() . "\n";
+}
+echo "\n";
+
+// Test 5: seek moves the cursor
+echo "Test 5: seek\n";
+$iter = str_iter($str);
+$iter->seek(5);
+echo "key=" . $iter->key() . " current=" . $iter->current() . "\n";
+$iter->next();
+echo "after next: key=" . $iter->key() . " current=" . $iter->current() . "\n";
+try {
+    $iter->seek(100);
+} catch (OutOfBoundsException $e) {
+    echo get_class($e) . ": " . $e->getMessage() . "\n";
+}
+echo "\n";
+
+// Test 6: a small checkpoint interval gives the same answers
+echo "Test 6: striter.index_interval\n";
+ini_set("striter.index_interval", "1");
+$iter = str_iter($long, "codepoint");
+echo bin2hex($iter[1234]) . " " . bin2hex(str_iter($long, "codepoint")[1234]) . "\n";
+ini_restore("striter.index_interval");
+echo "\n";
+
+echo "Random access tests completed!\n";
+?>
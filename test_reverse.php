@@ -0,0 +1,71 @@
+<?php
+// Test for reverse iteration: str_iter_reverse(), prev() and end()
+
+echo "Test: Reverse iteration\n";
+
+// Test 1: reverse iteration yields the forward units in reverse order, in
+// every mode, with invalid UTF-8, flags, CR LF and combining marks
+echo "Test 1: Reverse matches forward\n";
+$samples = [
+    "Hello世界🌍👋🏽!",
+    "e\u{301}\r\n🇯🇵🇺🇸🇫 👨‍👩‍👧 a\xFFb\xE2\x82c",
+    "It's 3.14 o'clock. (Really?) Yes.\nNext line\u{2028}well-known 日本語",
+    str_repeat("Mr. Smith said \"Hi.\" Then left. ", 50),
+];
+foreach (["grapheme", "codepoint", "byte", "word", "sentence", "line"] as $mode) {
+    $ok = true;
+    foreach ($samples as $str) {
+        $forward = str_iter($str, $mode)->toArray();
+        $reverse = [];
+        foreach (str_iter_reverse($str, $mode) as $unit) {
+            $reverse[] = $unit;
+        }
+        $ok = $ok && $reverse === array_reverse($forward)
+            && str_iter_reverse($str, $mode)->toArray() === $reverse;
+    }
+    echo "$mode: " . ($ok ? "match" : "MISMATCH") . "\n";
+}
+echo "\n";
+
+// Test 2: keys, offsets and seek() follow the iteration order
+echo "Test 2: Keys and offsets\n";
+$iter = str_iter_reverse("ab🌍c");
+foreach ($iter as $key => $unit) {
+    echo "[$key] => '$unit'\n";
+}
+echo "[0]: '" . $iter[0] . "', [-1]: '" . $iter[-1] . "', count: " . count($iter) . "\n";
+$iter->seek(1);
+echo "seek(1): " . $iter->key() . " => '" . $iter->current() . "'\n";
+echo "offsets: " . json_encode(str_iter_reverse("aé", "codepoint", ["offsets" => true])->toArray()) . "\n";
+echo "\n";
+
+// Test 3: prev() and end() on a forward iterator
+echo "Test 3: prev() and end()\n";
+$iter = str_iter("ab🌍c");
+$iter->end();
+while ($iter->valid()) {
+    echo $iter->key() . ":'" . $iter->current() . "' ";
+    $iter->prev();
+}
+echo "\n";
+$iter->rewind();
+$iter->next();
+$iter->next();
+$iter->prev();
+echo "next, next, prev: " . $iter->key() . " => '" . $iter->current() . "'\n";
+$iter->rewind();
+$iter->prev();
+var_dump($iter->valid());
+echo "\n";
+
+// Test 4: empty strings
+echo "Test 4: Empty string\n";
+$iter = str_iter_reverse("");
+var_dump($iter->valid(), $iter->toArray(), count($iter));
+$iter = str_iter("");
+$iter->end();
+var_dump($iter->valid());
+echo "\n";
+
+echo "Reverse iteration tests completed!\n";
+?>
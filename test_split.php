@@ -0,0 +1,47 @@
+<?php
+// Test for toArray() and str_iter_split()
+
+echo "Test: toArray and str_iter_split\n";
+
+$str = "Hello世界🌍👋🏽!\r\n";
+
+// Test 1: toArray matches iterator_to_array in every mode
+echo "Test 1: toArray\n";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $iter = str_iter($str, $mode);
+    $same = $iter->toArray() === iterator_to_array(str_iter($str, $mode));
+    echo "$mode: " . count($iter->toArray()) . " units, " . ($same ? "same as foreach" : "DIFFERENT") . "\n";
+}
+echo "\n";
+
+// Test 2: str_iter_split with the default chunk
+echo "Test 2: str_iter_split\n";
+echo implode("|", str_iter_split($str)) === implode("|", str_iter($str)->toArray()) ? "grapheme ok\n" : "grapheme DIFFERENT\n";
+echo implode(" ", array_map("bin2hex", str_iter_split("añ", "byte"))) . "\n";
+echo "\n";
+
+// Test 3: chunks keep units whole, the last one may be shorter
+echo "Test 3: Chunks\n";
+foreach ([2, 3, 100] as $chunk) {
+    echo "$chunk: " . json_encode(str_iter_split("Hello世界🌍👋🏽!", "grapheme", $chunk), JSON_UNESCAPED_UNICODE) . "\n";
+}
+echo json_encode(str_iter_split("abcde", "byte", 2)) . "\n";
+echo "\n";
+
+// Test 4: empty string and invalid chunk
+echo "Test 4: Edge cases\n";
+var_dump(str_iter_split(""), str_iter("")->toArray());
+try {
+    str_iter_split("abc", "byte", 0);
+} catch (ValueError $e) {
+    echo $e->getMessage() . "\n";
+}
+echo "\n";
+
+// Test 5: toArray honours substitute
+echo "Test 5: Substitute\n";
+echo json_encode(str_iter("a\xFFb", "codepoint", ["substitute" => true])->toArray(), JSON_UNESCAPED_UNICODE) . "\n";
+echo "\n";
+
+echo "Split tests completed!\n";
+?>
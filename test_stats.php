@@ -0,0 +1,45 @@
+<?php
+// Test for str_iter_count_values() and str_iter_stats()
+
+echo "Test: Aggregates\n";
+
+$text = "Héllo wörld! 👨‍👩‍👧 e\u{301} 👨‍👩‍👧 ll 42\r\n";
+
+// Test 1: the same counts, in the same order, as counting the units
+echo "Test 1: str_iter_count_values()\n";
+foreach (str_iter_count_values($text) as $unit => $count) {
+    echo json_encode($unit) . " => $count\n";
+}
+foreach (["grapheme", "codepoint", "byte", "word", "sentence", "line"] as $mode) {
+    $long = str_repeat($text . "Ünïcödé \xFF text. ", 30);
+    $same = str_iter_count_values($long, $mode) === array_count_values(str_iter($long, $mode)->toArray());
+    printf("%-9s %s\n", $mode, $same ? "same as array_count_values()" : "DIFFERENT");
+}
+echo "\n";
+
+// Test 2: byte and codepoint counts and the longest unit
+echo "Test 2: str_iter_stats()\n";
+foreach (["grapheme", "codepoint", "word"] as $mode) {
+    echo "$mode: " . json_encode(str_iter_stats($text . "\xFF", $mode)) . "\n";
+}
+echo "empty: " . json_encode(str_iter_stats("")) . "\n";
+echo "\n";
+
+// Test 3: agrees with measuring every unit in userland
+echo "Test 3: Same as userland\n";
+$long = str_repeat("The quick 🇯🇵 fox e\u{301}\u{302}\u{303} jumps. 👩🏽‍💻\n", 40);
+foreach (["grapheme", "word", "line"] as $mode) {
+    $units = str_iter($long, $mode)->toArray();
+    $expected = [
+        "bytes" => strlen($long),
+        "codepoints" => count(str_iter($long, "codepoint")),
+        "units" => count($units),
+        "max_bytes" => max(array_map("strlen", $units)),
+        "max_codepoints" => max(array_map(fn($u) => count(str_iter($u, "codepoint")), $units)),
+        "invalid" => 0,
+    ];
+    printf("%-9s %s\n", $mode, str_iter_stats($long, $mode) === $expected ? "same" : "DIFFERENT");
+}
+
+echo "\nAll tests completed.\n";
+?>
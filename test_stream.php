@@ -0,0 +1,55 @@
+<?php
+// Test for str_iter_stream()
+
+echo "Test: Stream iteration\n";
+
+$str = str_repeat("Hello世界🌍👋🏽!\r\ne\u{301}🇯🇵👨‍👩‍👧 ", 50) . "\xFF\xE3\x81end";
+
+function stream_of(string $data) {
+    $fp = fopen("php://memory", "w+");
+    fwrite($fp, $data);
+    rewind($fp);
+    return $fp;
+}
+
+// Test 1: every chunk size gives the same units as str_iter()
+echo "Test 1: Chunk boundaries\n";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    $expected = str_iter($str, $mode)->toArray();
+    $ok = true;
+    foreach ([4, 5, 7, 16, 100, 65536] as $chunk) {
+        $units = iterator_to_array(str_iter_stream(stream_of($str), $mode, $chunk));
+        $ok = $ok && $units === $expected;
+    }
+    echo "$mode: " . count($expected) . " units, " . ($ok ? "match" : "MISMATCH") . "\n";
+}
+echo "\n";
+
+// Test 2: a cluster longer than the chunk size is kept whole
+echo "Test 2: Long cluster\n";
+$zalgo = "a" . str_repeat("\u{301}", 40) . "b";
+$units = iterator_to_array(str_iter_stream(stream_of($zalgo), "grapheme", 8));
+echo count($units) . " units, first is " . strlen($units[0]) . " bytes\n";
+echo "\n";
+
+// Test 3: iteration starts at the stream's current position and can be
+// repeated on seekable streams
+echo "Test 3: Start offset and rewind\n";
+$fp = stream_of("skip:abc");
+fread($fp, 5);
+$iter = str_iter_stream($fp);
+echo implode(",", iterator_to_array($iter)) . "\n";
+echo implode(",", iterator_to_array($iter)) . "\n";
+echo "\n";
+
+// Test 4: invalid chunk size
+echo "Test 4: Errors\n";
+try {
+    str_iter_stream(stream_of("abc"), "grapheme", 2);
+} catch (ValueError $e) {
+    echo $e->getMessage() . "\n";
+}
+echo "\n";
+
+echo "Stream tests completed!\n";
+?>
@@ -0,0 +1,74 @@
+<?php
+// Test for the strict and substitute options
+
+echo "Test: Strict UTF-8 and substitution\n";
+
+// Test 1: strict accepts valid UTF-8 in every mode
+echo "Test 1: Strict with valid input\n";
+$valid = "Hello世界🌍👋🏽!";
+foreach (["grapheme", "codepoint", "byte"] as $mode) {
+    echo "$mode: " . count(str_iter($valid, $mode, ["strict" => true])) . "\n";
+}
+echo "\n";
+
+// Test 2: strict rejects invalid UTF-8 and reports the byte offset
+echo "Test 2: Strict with invalid input\n";
+$invalid = [
+    "stray continuation" => "abc\x80def",
+    "truncated"          => "Hello\xE3\x81 World",
+    "overlong"           => "ab\xC0\xAF",
+    "surrogate"          => "\xED\xA0\x80",
+    "above U+10FFFF"     => "1234567890123456789012345678901234567890\xF4\x90\x80\x80",
+    "cut at end"         => "こんにちは\xF0\x9F\x8C",
+];
+foreach ($invalid as $name => $str) {
+    try {
+        str_iter($str, "codepoint", ["strict" => true]);
+        echo "$name: accepted\n";
+    } catch (ValueError $e) {
+        echo "$name: " . $e->getMessage() . "\n";
+    }
+}
+echo "\n";
+
+// Test 3: the constructor takes the same options
+echo "Test 3: Constructor\n";
+try {
+    new _StrIterIterator("\xFF", "grapheme", ["strict" => true]);
+} catch (ValueError $e) {
+    echo "constructor: " . $e->getMessage() . "\n";
+}
+echo "\n";
+
+// Test 4: substitute yields U+FFFD for each invalid sequence
+echo "Test 4: Substitute\n";
+$str = "こ\xFF\xFEん\xE3\x81!";
+foreach (["grapheme", "codepoint"] as $mode) {
+    $units = [];
+    foreach (str_iter($str, $mode, ["substitute" => true]) as $unit) {
+        $units[] = $unit === "\u{FFFD}" ? "U+FFFD" : $unit;
+    }
+    echo "$mode: " . implode(" ", $units) . "\n";
+}
+echo "\n";
+
+// Test 5: byte mode never substitutes
+echo "Test 5: Substitute in byte mode\n";
+$units = [];
+foreach (str_iter("a\xFF", "byte", ["substitute" => true]) as $unit) {
+    $units[] = bin2hex($unit);
+}
+echo "byte: " . implode(" ", $units) . "\n";
+echo "\n";
+
+// Test 6: unknown options are rejected
+echo "Test 6: Unknown option\n";
+try {
+    str_iter("abc", "grapheme", ["strcit" => true]);
+} catch (ValueError $e) {
+    echo $e->getMessage() . "\n";
+}
+echo "\n";
+
+echo "Strict UTF-8 tests completed!\n";
+?>
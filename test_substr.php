@@ -0,0 +1,54 @@
+<?php
+// Test for str_iter_substr() and str_iter_truncate()
+
+echo "Test: Substrings and truncation\n";
+
+$str = "Hi 👨‍👩‍👧 café e\u{301}! 🇯🇵";
+
+// Test 1: substrings with positive and negative start and length, like
+// mb_substr() but counting grapheme clusters by default
+echo "Test 1: str_iter_substr\n";
+foreach ([[0, 4], [3, 1], [-4, null], [-6, 3], [2, -3], [20, null], [-20, 2], [5, -20]] as [$start, $length]) {
+    echo json_encode([$start, $length]) . ": '" . str_iter_substr($str, $start, $length) . "'\n";
+}
+echo "codepoint [3, 2]: " . bin2hex(str_iter_substr($str, 3, 2, "codepoint")) . "\n";
+echo "byte [0, 4]: " . bin2hex(str_iter_substr($str, 0, 4, "byte")) . "\n";
+echo "word [-3, 2]: '" . str_iter_substr("One two three", -3, 2, "word") . "'\n";
+echo "\n";
+
+// Test 2: the result matches iterating and slicing, in every mode
+echo "Test 2: Matches toArray()\n";
+foreach (["grapheme", "codepoint", "byte", "word", "sentence", "line"] as $mode) {
+    $units = str_iter($str . " Next. One\r\nmore", $mode)->toArray();
+    $ok = true;
+    for ($start = -count($units) - 1; $start <= count($units) + 1; $start++) {
+        foreach ([null, 0, 1, 3, -1, -4] as $length) {
+            $expected = implode("", array_slice($units, max($start, -count($units)), $length));
+            $ok = $ok && str_iter_substr($str . " Next. One\r\nmore", $start, $length, $mode) === $expected;
+        }
+    }
+    echo "$mode: " . ($ok ? "match" : "MISMATCH") . "\n";
+}
+echo "\n";
+
+// Test 3: truncation keeps whole clusters and counts the suffix in the limit
+echo "Test 3: str_iter_truncate\n";
+foreach ([20, 11, 5, 1, 0] as $length) {
+    echo "$length: '" . str_iter_truncate($str, $length) . "'\n";
+}
+echo "suffix '...': '" . str_iter_truncate($str, 6, "...") . "'\n";
+echo "no suffix: '" . str_iter_truncate($str, 4, "") . "'\n";
+echo "words: '" . str_iter_truncate("The quick brown fox", 5, " [more]", "word") . "'\n";
+echo "\n";
+
+// Test 4: errors
+echo "Test 4: Errors\n";
+try {
+    str_iter_truncate($str, -1);
+} catch (ValueError $e) {
+    echo get_class($e) . ": " . $e->getMessage() . "\n";
+}
+echo "\n";
+
+echo "Substring tests completed!\n";
+?>
@@ -0,0 +1,53 @@
+<?php
+// Test for the word and sentence modes (UAX #29)
+
+echo "Test: Word and sentence segmentation\n";
+
+// Test 1: words keep contractions, decimals and ZWJ emoji together; every
+// space run and punctuation mark is a segment of its own
+echo "Test 1: Words\n";
+$samples = [
+    "Hello, world! It's 3.14 o'clock.",
+    "e-mail foo_bar 1,000.5 U.S.A.",
+    "Привет мир. שלום \"עולם\" ה\"ה",
+    "カタカナ 漢字かな 👨‍👩‍👧 🇯🇵🇺🇸 a\u{301}b",
+    "tab\tcr\r\nlf\n\n",
+];
+foreach ($samples as $str) {
+    echo json_encode(str_iter($str, "word")->toArray(), JSON_UNESCAPED_UNICODE) . "\n";
+}
+echo "\n";
+
+// Test 2: sentences end after terminators and the spaces that follow,
+// except where the rules continue them (a lowercase word after a period,
+// decimals)
+echo "Test 2: Sentences\n";
+$samples = [
+    "Mr. Smith arrived. He was late! Was he?  Yes.",
+    "It costs 3.5 dollars. \"Really?\" she said. (Quite.) Then etc. and more.",
+    "First line\nSecond line\r\nThird.\u{2029}Fourth",
+    "日本語の文。もう一つ！最後",
+];
+foreach ($samples as $str) {
+    echo json_encode(str_iter($str, "sentence")->toArray(), JSON_UNESCAPED_UNICODE) . "\n";
+}
+echo "\n";
+
+// Test 3: the cursor, count(), random access and offsets work as in the other modes
+echo "Test 3: Iterator features\n";
+$str = "One two. Three four five. Six.";
+$words = str_iter($str, "word");
+echo "word count: " . count($words) . ", [4]: '" . $words[4] . "', [-1]: '" . $words[-1] . "'\n";
+$sentences = str_iter($str, "sentence", ["offsets" => true]);
+echo "sentence offsets: " . json_encode($sentences->toArray()) . "\n";
+echo "split: " . json_encode(str_iter_split($str, "sentence", 2)) . "\n";
+echo "\n";
+
+// Test 4: invalid UTF-8 sequences are units of their own
+echo "Test 4: Invalid UTF-8\n";
+echo implode(" ", array_map("bin2hex", str_iter("ab\xFFcd ef", "word")->toArray())) . "\n";
+echo implode(" ", array_map("bin2hex", str_iter("Hi.\xFF There.", "sentence")->toArray())) . "\n";
+echo "\n";
+
+echo "Word and sentence tests completed!\n";
+?>
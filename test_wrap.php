@@ -0,0 +1,64 @@
+<?php
+// Test for line mode (UAX #14) and str_iter_wrap()
+
+echo "Test: Line breaking and wrapping\n";
+
+// Test 1: line segments end at break opportunities: after spaces, after
+// hyphens, between ideographs, and after hard line breaks
+echo "Test 1: Line segments\n";
+$samples = [
+    "The quick (\"brown\") fox can't jump 32.3 feet, right?",
+    "well-known self-evident e-mail",
+    "日本語のテキスト、です。",
+    "emoji 👍🏽👨‍👩‍👧 and 🇯🇵🇺🇸 flags",
+    "one\ntwo\r\nthree\u{2028}four",
+    "no\u{A0}break\u{2060}here a\u{200B}b",
+];
+foreach ($samples as $str) {
+    echo json_encode(str_iter($str, "line")->toArray(), JSON_UNESCAPED_UNICODE) . "\n";
+}
+echo "\n";
+
+// Test 2: wrapping by display width; trailing spaces hang and the chunks
+// join back into the original string
+echo "Test 2: Wrapping\n";
+$cases = [
+    ["The quick brown fox jumps over the lazy dog", 10],
+    ["Line one\nLine two is longer\n\nEnd", 8],
+    ["日本語のテキストを折り返します。", 10],
+    ["mixed 日本語 and English text", 8],
+    ["emoji 👍🏽 and flags 🇯🇵🇺🇸 wrap", 8],
+    ["e\u{301}e\u{301}e\u{301}e\u{301}", 2],
+    ["well-known self-evident", 6],
+];
+foreach ($cases as [$str, $width]) {
+    $chunks = str_iter_wrap($str, $width);
+    echo $width . ": " . json_encode($chunks, JSON_UNESCAPED_UNICODE)
+        . (implode("", $chunks) === $str ? "" : " (NOT LOSSLESS)") . "\n";
+}
+echo "\n";
+
+// Test 3: words longer than the width are cut between grapheme clusters,
+// unless $cut is false
+echo "Test 3: Long words\n";
+$str = "antidisestablishmentarianism is long";
+echo "cut: " . json_encode(str_iter_wrap($str, 10)) . "\n";
+echo "no cut: " . json_encode(str_iter_wrap($str, 10, false)) . "\n";
+echo "wide: " . json_encode(str_iter_wrap("漢字漢字", 1), JSON_UNESCAPED_UNICODE) . "\n";
+echo "\n";
+
+// Test 4: edge cases
+echo "Test 4: Edge cases\n";
+echo "empty: " . json_encode(str_iter_wrap("", 5)) . "\n";
+echo "fits: " . json_encode(str_iter_wrap("short", 80)) . "\n";
+echo "invalid: " . implode(" ", array_map("bin2hex", str_iter_wrap("ab\xFF cd", 3))) . "\n";
+echo "line count: " . count(str_iter("a b-c 日本", "line")) . "\n";
+try {
+    str_iter_wrap("text", 0);
+} catch (ValueError $e) {
+    echo "ValueError: " . $e->getMessage() . "\n";
+}
+echo "\n";
+
+echo "Line breaking tests completed!\n";
+?>
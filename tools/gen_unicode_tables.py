@@ -0,0 +1,852 @@
+#!/usr/bin/env python3
+"""Generate striter_unicode_tables.h
+
+Usage:
+    tools/gen_unicode_tables.py [--ucd DIR] > striter_unicode_tables.h
+
+With --ucd, properties are read from the Unicode Character Database files
+in DIR (GraphemeBreakProperty.txt, emoji-data.txt, WordBreakProperty.txt,
+SentenceBreakProperty.txt, LineBreak.txt, CaseFolding.txt; the break
+properties may be in DIR/auxiliary). Without it, grapheme classes are derived from Python's
+unicodedata module using the property definitions of UAX #29 and the
+contributory properties listed below, which unicodedata does not expose.
+Those lists are written for Unicode 14.0.0, so this path refuses to run
+when unicodedata implements any other version; use --ucd instead.
+Word_Break, Sentence_Break and Line_Break build on too many other
+properties for that, and unicodedata has no simple case folding, so
+those and the case foldings are read from Perl's Unicode::UCD instead,
+which must implement the same Unicode version. Display widths always
+come from unicodedata (East_Asian_Width and General_Category), and so do
+the normalization data: canonical combining classes, decompositions,
+primary composites and the NFC/NFD quick check values derived from them.
+
+Each property is emitted as a two-stage lookup table: stage1 maps the
+high bits of a codepoint to a deduplicated block in stage2.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import unicodedata
+
+MAX_CP = 0x110000
+
+# ---------------------------------------------------------------------------
+# Grapheme_Cluster_Break
+# ---------------------------------------------------------------------------
+
+GCB_NAMES = [
+    "Other", "CR", "LF", "Control", "Extend", "ZWJ", "Regional_Indicator",
+    "Prepend", "SpacingMark", "L", "V", "T", "LV", "LVT",
+]
+GCB = {name: i for i, name in enumerate(GCB_NAMES)}
+
+# Extended_Pictographic is folded into the grapheme table as its own class:
+# every Extended_Pictographic codepoint has Grapheme_Cluster_Break=Other.
+GCB_CLASSES = GCB_NAMES + ["Extended_Pictographic"]
+EXT_PICT = len(GCB_NAMES)
+
+
+def parse_ucd_file(path):
+    """Yield (first, last, value) from a UCD property file."""
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            cps, value = [x.strip() for x in line.split(";")[:2]]
+            if ".." in cps:
+                first, last = (int(x, 16) for x in cps.split(".."))
+            else:
+                first = last = int(cps, 16)
+            yield first, last, value
+
+
+def ranges(*spec):
+    """Expand (first, last) pairs and single codepoints into a set."""
+    out = set()
+    for item in spec:
+        if isinstance(item, tuple):
+            out.update(range(item[0], item[1] + 1))
+        else:
+            out.add(item)
+    return out
+
+
+# Contributory properties that unicodedata does not expose (PropList.txt,
+# IndicSyllabicCategory.txt, emoji-data.txt), as of this Unicode version.
+BUILTIN_UNICODE_VERSION = "14.0.0"
+
+OTHER_GRAPHEME_EXTEND = ranges(
+    0x09BE, 0x09D7, 0x0B3E, 0x0B57, 0x0BBE, 0x0BD7, 0x0CC2, (0x0CD5, 0x0CD6),
+    0x0D3E, 0x0D57, 0x0DCF, 0x0DDF, 0x1B35, 0x200C, (0x302E, 0x302F),
+    (0xFF9E, 0xFF9F), 0x1133E, 0x11357, 0x114B0, 0x114BD, 0x115AF, 0x11930,
+    0x1D165, (0x1D16E, 0x1D172), (0xE0020, 0xE007F),
+)
+EMOJI_MODIFIER = ranges((0x1F3FB, 0x1F3FF))
+PREPEND = ranges(
+    (0x0600, 0x0605), 0x06DD, 0x070F, (0x0890, 0x0891), 0x08E2, 0x0D4E,
+    0x110BD, 0x110CD, (0x111C2, 0x111C3), 0x1193F, 0x11941, 0x11A3A,
+    (0x11A84, 0x11A89), 0x11D46,
+)
+PREPENDED_CONCATENATION_MARK = ranges(
+    (0x0600, 0x0605), 0x06DD, 0x070F, (0x0890, 0x0891), 0x08E2, 0x110BD,
+    0x110CD,
+)
+SPACING_MARK_EXTRA = ranges(0x0E33, 0x0EB3)
+SPACING_MARK_EXCLUDED = ranges(
+    0x102B, 0x102C, 0x1038, (0x1062, 0x1064), (0x1067, 0x106D), 0x1083,
+    (0x1087, 0x108C), 0x108F, (0x109A, 0x109C), 0x1A61, 0x1A63, 0x1A64,
+    0xAA7B, 0xAA7D, 0x11720, 0x11721,
+)
+UNASSIGNED_DEFAULT_IGNORABLE = ranges(
+    0x2065, (0xFFF0, 0xFFF8), 0xE0000, (0xE0002, 0xE001F), (0xE0080, 0xE00FF),
+    (0xE01F0, 0xE0FFF),
+)
+EXTENDED_PICTOGRAPHIC = ranges(
+    0x00A9, 0x00AE, 0x203C, 0x2049, 0x2122, 0x2139, (0x2194, 0x2199),
+    (0x21A9, 0x21AA), (0x231A, 0x231B), 0x2328, 0x2388, 0x23CF,
+    (0x23E9, 0x23F3), (0x23F8, 0x23FA), 0x24C2, (0x25AA, 0x25AB), 0x25B6,
+    0x25C0, (0x25FB, 0x25FE), (0x2600, 0x2605), (0x2607, 0x2612),
+    (0x2614, 0x2685), (0x2690, 0x2705), (0x2708, 0x2712), 0x2714, 0x2716,
+    0x271D, 0x2721, 0x2728, (0x2733, 0x2734), 0x2744, 0x2747, 0x274C, 0x274E,
+    (0x2753, 0x2755), 0x2757, (0x2763, 0x2767), (0x2795, 0x2797), 0x27A1,
+    0x27B0, 0x27BF, (0x2934, 0x2935), (0x2B05, 0x2B07), (0x2B1B, 0x2B1C),
+    0x2B50, 0x2B55, 0x3030, 0x303D, 0x3297, 0x3299, (0x1F000, 0x1F0FF),
+    (0x1F10D, 0x1F10F), 0x1F12F, (0x1F16C, 0x1F171), (0x1F17E, 0x1F17F),
+    0x1F18E, (0x1F191, 0x1F19A), (0x1F1AD, 0x1F1E5), (0x1F201, 0x1F20F),
+    0x1F21A, 0x1F22F, (0x1F232, 0x1F23A), (0x1F23C, 0x1F23F),
+    (0x1F249, 0x1F3FA), (0x1F400, 0x1F53D), (0x1F546, 0x1F64F),
+    (0x1F680, 0x1F6FF), (0x1F774, 0x1F77F), (0x1F7D5, 0x1F7FF),
+    (0x1F80C, 0x1F80F), (0x1F848, 0x1F84F), (0x1F85A, 0x1F85F),
+    (0x1F888, 0x1F88F), (0x1F8AE, 0x1F8FF), (0x1F90C, 0x1F93A),
+    (0x1F93C, 0x1F945), (0x1F947, 0x1FAFF), (0x1FC00, 0x1FFFD),
+)
+
+
+def derive_gcb(cp):
+    """Grapheme_Cluster_Break per UAX #29, Table 2."""
+    if cp == 0x0D:
+        return GCB["CR"]
+    if cp == 0x0A:
+        return GCB["LF"]
+    if cp == 0x200D:
+        return GCB["ZWJ"]
+    if 0x1F1E6 <= cp <= 0x1F1FF:
+        return GCB["Regional_Indicator"]
+    if cp in PREPEND:
+        return GCB["Prepend"]
+
+    gc = unicodedata.category(chr(cp))
+    if gc in ("Mn", "Me") or cp in OTHER_GRAPHEME_EXTEND or cp in EMOJI_MODIFIER:
+        return GCB["Extend"]
+    if gc in ("Zl", "Zp", "Cc", "Cs"):
+        return GCB["Control"]
+    if gc == "Cn" and cp in UNASSIGNED_DEFAULT_IGNORABLE:
+        return GCB["Control"]
+    if gc == "Cf" and cp not in PREPENDED_CONCATENATION_MARK:
+        return GCB["Control"]
+    if (gc == "Mc" and cp not in SPACING_MARK_EXCLUDED) or cp in SPACING_MARK_EXTRA:
+        return GCB["SpacingMark"]
+
+    # Hangul_Syllable_Type
+    if 0x1100 <= cp <= 0x115F or 0xA960 <= cp <= 0xA97C:
+        return GCB["L"]
+    if 0x1160 <= cp <= 0x11A7 or 0xD7B0 <= cp <= 0xD7C6:
+        return GCB["V"]
+    if 0x11A8 <= cp <= 0x11FF or 0xD7CB <= cp <= 0xD7FB:
+        return GCB["T"]
+    if 0xAC00 <= cp <= 0xD7A3:
+        return GCB["LV"] if (cp - 0xAC00) % 28 == 0 else GCB["LVT"]
+
+    return GCB["Other"]
+
+
+def load_grapheme_classes(ucd):
+    classes = [GCB["Other"]] * MAX_CP
+    if ucd:
+        for first, last, value in parse_ucd_file(os.path.join(ucd, "GraphemeBreakProperty.txt")):
+            for cp in range(first, last + 1):
+                classes[cp] = GCB[value]
+        ext_pict = set()
+        for first, last, value in parse_ucd_file(os.path.join(ucd, "emoji-data.txt")):
+            if value == "Extended_Pictographic":
+                ext_pict.update(range(first, last + 1))
+    else:
+        for cp in range(MAX_CP):
+            classes[cp] = derive_gcb(cp)
+        ext_pict = EXTENDED_PICTOGRAPHIC
+
+    for cp in ext_pict:
+        if classes[cp] == GCB["Other"]:
+            classes[cp] = EXT_PICT
+    return classes
+
+
+# ---------------------------------------------------------------------------
+# GB rules as a pair table
+# ---------------------------------------------------------------------------
+
+BREAK, NO_BREAK, NO_BREAK_EMOJI, NO_BREAK_RI = 0, 1, 2, 3
+
+
+def grapheme_pair_rule(prev, cur):
+    """Rule outcome for a boundary between classes prev and cur (GB3-GB999).
+
+    NO_BREAK_EMOJI and NO_BREAK_RI need state the pair alone does not
+    carry (GB11 and GB12/GB13); the segmenter resolves them.
+    """
+    n = {name: GCB_CLASSES.index(name) for name in GCB_CLASSES}
+    if prev == n["CR"] and cur == n["LF"]:
+        return NO_BREAK                                         # GB3
+    if prev in (n["Control"], n["CR"], n["LF"]):
+        return BREAK                                            # GB4
+    if cur in (n["Control"], n["CR"], n["LF"]):
+        return BREAK                                            # GB5
+    if prev == n["L"] and cur in (n["L"], n["V"], n["LV"], n["LVT"]):
+        return NO_BREAK                                         # GB6
+    if prev in (n["LV"], n["V"]) and cur in (n["V"], n["T"]):
+        return NO_BREAK                                         # GB7
+    if prev in (n["LVT"], n["T"]) and cur == n["T"]:
+        return NO_BREAK                                         # GB8
+    if cur in (n["Extend"], n["ZWJ"]):
+        return NO_BREAK                                         # GB9
+    if cur == n["SpacingMark"]:
+        return NO_BREAK                                         # GB9a
+    if prev == n["Prepend"]:
+        return NO_BREAK                                         # GB9b
+    if prev == n["ZWJ"] and cur == n["Extended_Pictographic"]:
+        return NO_BREAK_EMOJI                                   # GB11
+    if prev == n["Regional_Indicator"] and cur == n["Regional_Indicator"]:
+        return NO_BREAK_RI                                      # GB12, GB13
+    return BREAK                                                # GB999
+
+
+# ---------------------------------------------------------------------------
+# Word_Break and Sentence_Break
+# ---------------------------------------------------------------------------
+
+WB_NAMES = [
+    "Other", "CR", "LF", "Newline", "Extend", "ZWJ", "Regional_Indicator",
+    "Format", "Katakana", "Hebrew_Letter", "ALetter", "Single_Quote",
+    "Double_Quote", "MidNumLet", "MidLetter", "MidNum", "Numeric",
+    "ExtendNumLet", "WSegSpace",
+]
+WB = {name: i for i, name in enumerate(WB_NAMES)}
+
+SB_NAMES = [
+    "Other", "CR", "LF", "Extend", "Sep", "Format", "Sp", "Lower", "Upper",
+    "OLetter", "Numeric", "ATerm", "SContinue", "STerm", "Close",
+]
+SB = {name: i for i, name in enumerate(SB_NAMES)}
+
+PERL_INVMAP = r"""
+use Unicode::UCD qw(prop_invmap);
+print Unicode::UCD::UnicodeVersion(), "\n";
+my ($list, $map) = prop_invmap($ARGV[0]);
+print "$list->[$_] $map->[$_]\n" for 0 .. $#$list;
+"""
+
+
+def perl_property(name):
+    """Yield (first, last, value) for a property from Perl's Unicode::UCD."""
+    out = subprocess.run(["perl", "-e", PERL_INVMAP, name], check=True,
+                         capture_output=True, text=True).stdout.splitlines()
+    if out[0] != unicodedata.unidata_version:
+        sys.exit("Perl implements Unicode %s, unicodedata %s; use --ucd"
+                 % (out[0], unicodedata.unidata_version))
+    entries = [line.split(" ", 1) for line in out[1:]]
+    for i, (first, value) in enumerate(entries):
+        last = int(entries[i + 1][0]) - 1 if i + 1 < len(entries) else MAX_CP - 1
+        yield int(first), last, value
+
+
+PERL_CASEFOLDS = r"""
+use Unicode::UCD qw(all_casefolds);
+print Unicode::UCD::UnicodeVersion(), "\n";
+my $folds = all_casefolds();
+print "$_;$folds->{$_}{full};$folds->{$_}{simple}\n" for sort { $a <=> $b } keys %$folds;
+"""
+
+
+def perl_casefolds():
+    """Yield (cp, full, simple) case foldings from Perl's Unicode::UCD."""
+    out = subprocess.run(["perl", "-e", PERL_CASEFOLDS], check=True,
+                         capture_output=True, text=True).stdout.splitlines()
+    if out[0] != unicodedata.unidata_version:
+        sys.exit("Perl implements Unicode %s, unicodedata %s; use --ucd"
+                 % (out[0], unicodedata.unidata_version))
+    for line in out[1:]:
+        cp, full, simple = line.split(";")
+        yield int(cp), full, simple
+
+
+def untailor_perl_wb(cp, value):
+    """Undo Perl's tailoring of Word_Break (see perlrebackslash, \\b{wb})."""
+    if value == "ExtPict_LE":
+        return "ALetter"
+    if value == "ExtPict_XX":
+        return "Other"
+    if value == "Perl_Tailored_HSpace":
+        # WSegSpace is Zs without the no-break spaces
+        if unicodedata.category(chr(cp)) == "Zs" and cp not in (0x00A0, 0x2007, 0x202F):
+            return "WSegSpace"
+        return "Other"
+    return value
+
+
+def find_ucd_file(ucd, name):
+    for path in (os.path.join(ucd, name), os.path.join(ucd, "auxiliary", name)):
+        if os.path.exists(path):
+            return path
+    sys.exit("%s not found in %s" % (name, ucd))
+
+
+def load_break_classes(ucd, prop, filename, names):
+    classes = [names["Other"]] * MAX_CP
+    if ucd:
+        source = parse_ucd_file(find_ucd_file(ucd, filename))
+    else:
+        source = perl_property(prop)
+    for first, last, value in source:
+        for cp in range(first, last + 1):
+            if prop == "Word_Break" and not ucd:
+                classes[cp] = names[untailor_perl_wb(cp, value)]
+            else:
+                classes[cp] = names[value]
+    return classes
+
+
+# WB rule outcomes. The context ones are resolved by the segmenter: WB6,
+# WB7b and WB12 look at the class after the current one, WB7, WB7c and
+# WB11 at the one before the previous one, WB15/16 count the RI run.
+WB_RULE_NAMES = [
+    "BREAK", "NO_BREAK", "IGNORE", "NO_BREAK_NEXT_LETTER",
+    "NO_BREAK_NEXT_HEBREW", "NO_BREAK_NEXT_NUMERIC", "NO_BREAK_PREV_LETTER",
+    "NO_BREAK_PREV_HEBREW", "NO_BREAK_PREV_NUMERIC", "NO_BREAK_RI",
+]
+WBR = {name: i for i, name in enumerate(WB_RULE_NAMES)}
+
+
+def word_pair_rule(prev, cur):
+    """Rule outcome between the last class WB4 kept (prev) and cur.
+
+    WB3c and WB3d apply to directly adjacent codepoints, before WB4, so the
+    segmenter checks them before this table.
+    """
+    n = WB
+    ahletter = (n["ALetter"], n["Hebrew_Letter"])
+    midnumletq = (n["MidNumLet"], n["Single_Quote"])
+    if prev == n["CR"] and cur == n["LF"]:
+        return WBR["NO_BREAK"]                                  # WB3
+    if prev in (n["Newline"], n["CR"], n["LF"]):
+        return WBR["BREAK"]                                     # WB3a
+    if cur in (n["Newline"], n["CR"], n["LF"]):
+        return WBR["BREAK"]                                     # WB3b
+    if cur in (n["Extend"], n["Format"], n["ZWJ"]):
+        return WBR["IGNORE"]                                    # WB4
+    if prev in ahletter and cur in ahletter:
+        return WBR["NO_BREAK"]                                  # WB5
+    if prev == n["Hebrew_Letter"] and cur == n["Single_Quote"]:
+        return WBR["NO_BREAK"]                                  # WB7a (WB6 either way)
+    if prev in ahletter and cur in (n["MidLetter"],) + midnumletq:
+        return WBR["NO_BREAK_NEXT_LETTER"]                      # WB6
+    if prev in (n["MidLetter"],) + midnumletq and cur in ahletter:
+        return WBR["NO_BREAK_PREV_LETTER"]                      # WB7
+    if prev == n["Hebrew_Letter"] and cur == n["Double_Quote"]:
+        return WBR["NO_BREAK_NEXT_HEBREW"]                      # WB7b
+    if prev == n["Double_Quote"] and cur == n["Hebrew_Letter"]:
+        return WBR["NO_BREAK_PREV_HEBREW"]                      # WB7c
+    if prev == n["Numeric"] and cur == n["Numeric"]:
+        return WBR["NO_BREAK"]                                  # WB8
+    if prev in ahletter and cur == n["Numeric"]:
+        return WBR["NO_BREAK"]                                  # WB9
+    if prev == n["Numeric"] and cur in ahletter:
+        return WBR["NO_BREAK"]                                  # WB10
+    if prev in (n["MidNum"],) + midnumletq and cur == n["Numeric"]:
+        return WBR["NO_BREAK_PREV_NUMERIC"]                     # WB11
+    if prev == n["Numeric"] and cur in (n["MidNum"],) + midnumletq:
+        return WBR["NO_BREAK_NEXT_NUMERIC"]                     # WB12
+    if prev == n["Katakana"] and cur == n["Katakana"]:
+        return WBR["NO_BREAK"]                                  # WB13
+    if prev in ahletter + (n["Numeric"], n["Katakana"], n["ExtendNumLet"]) \
+            and cur == n["ExtendNumLet"]:
+        return WBR["NO_BREAK"]                                  # WB13a
+    if prev == n["ExtendNumLet"] and cur in ahletter + (n["Numeric"], n["Katakana"]):
+        return WBR["NO_BREAK"]                                  # WB13b
+    if prev == n["Regional_Indicator"] and cur == n["Regional_Indicator"]:
+        return WBR["NO_BREAK_RI"]                               # WB15, WB16
+    return WBR["BREAK"]                                         # WB999
+
+
+# ---------------------------------------------------------------------------
+# Line_Break (UAX #14) and display width
+# ---------------------------------------------------------------------------
+
+# Classes after LB1: AI, SG and XX resolve to AL, SA to CM or AL, CJ to
+# NS. OP and CP are split by East_Asian_Width for LB30.
+LB_NAMES = [
+    "AL", "BK", "CR", "LF", "NL", "SP", "ZW", "ZWJ", "CM", "WJ", "GL", "BA",
+    "BB", "B2", "HY", "CB", "CL", "CP", "CP_EA", "EX", "IN", "NS", "OP",
+    "OP_EA", "QU", "IS", "NU", "PO", "PR", "SY", "EB", "EM", "H2", "H3", "HL",
+    "ID", "JL", "JV", "JT", "RI",
+]
+LB = {name: i for i, name in enumerate(LB_NAMES)}
+
+
+def resolve_lb(cp, value):
+    """Line_Break class of cp after LB1 and the LB30/LB30b splits."""
+    if value in ("AI", "SG", "XX", "Unknown"):
+        return "AL"
+    if value == "SA":
+        return "CM" if unicodedata.category(chr(cp)) in ("Mn", "Mc") else "AL"
+    if value == "CJ":
+        return "NS"
+    if value in ("OP", "CP") and unicodedata.east_asian_width(chr(cp)) in ("F", "W", "H"):
+        return value + "_EA"
+    # LB30b treats unassigned Extended_Pictographic like EB
+    if value == "ID" and cp in EXTENDED_PICTOGRAPHIC and unicodedata.category(chr(cp)) == "Cn":
+        return "EB"
+    return value
+
+
+def load_line_classes(ucd):
+    values = ["XX"] * MAX_CP
+    if ucd:
+        source = parse_ucd_file(find_ucd_file(ucd, "LineBreak.txt"))
+    else:
+        source = perl_property("Line_Break")
+    for first, last, value in source:
+        for cp in range(first, last + 1):
+            values[cp] = value
+    return [LB[resolve_lb(cp, values[cp])] for cp in range(MAX_CP)]
+
+
+# LB rule outcomes for a (previous, current) class pair: whether there is
+# a break when the two are adjacent and when spaces separate them. LB4-LB10
+# (hard breaks, spaces, ZW, ZWJ and combining marks) are handled by the
+# segmenter before the table is consulted; the rest is evaluated once for
+# each case, since some rules allow spaces in between (LB14-LB17) and
+# others do not.
+LB_RULE_NAMES = ["BREAK", "INDIRECT", "PROHIBITED", "RI", "HL_HY"]
+LBR = {name: i for i, name in enumerate(LB_RULE_NAMES)}
+
+
+def line_decide(p, c, spaced):
+    """Whether the rules break between classes p and c, given whether
+    spaces separate them. Returns an LBR value; only adjacent pairs get
+    the context dependent ones."""
+
+    def any_of(name, *names):
+        return name in names
+
+    no_break = LBR["PROHIBITED"]
+    if any_of(p, "BK", "CR", "LF", "NL"):
+        return LBR["BREAK"]                                     # LB4, LB5
+    if any_of(c, "BK", "CR", "LF", "NL", "SP", "ZW"):
+        return no_break                                         # LB6, LB7
+    if p == "ZW":
+        return LBR["BREAK"]                                     # LB8
+    if c == "WJ" or (p == "WJ" and not spaced):
+        return no_break                                         # LB11
+    if p == "GL" and not spaced:
+        return no_break                                         # LB12
+    if c == "GL" and not spaced and not any_of(p, "BA", "HY"):
+        return no_break                                         # LB12a
+    if any_of(c, "CL", "CP", "CP_EA", "EX", "IS", "SY"):
+        return no_break                                         # LB13
+    if any_of(p, "OP", "OP_EA"):
+        return no_break                                         # LB14
+    if p == "QU" and any_of(c, "OP", "OP_EA"):
+        return no_break                                         # LB15
+    if any_of(p, "CL", "CP", "CP_EA") and c == "NS":
+        return no_break                                         # LB16
+    if p == "B2" and c == "B2":
+        return no_break                                         # LB17
+    if spaced:
+        return LBR["BREAK"]                                     # LB18
+    if c == "QU" or p == "QU":
+        return no_break                                         # LB19
+    if c == "CB" or p == "CB":
+        return LBR["BREAK"]                                     # LB20
+    if any_of(c, "BA", "HY", "NS") or p == "BB":
+        return no_break                                         # LB21
+    fallback = LBR["BREAK"]
+    if any_of(p, "HY", "BA"):
+        fallback = LBR["HL_HY"]                                 # LB21a
+    if p == "SY" and c == "HL":
+        return no_break                                         # LB21b
+    if c == "IN":
+        return no_break                                         # LB22
+    if (any_of(p, "AL", "HL") and c == "NU") or (p == "NU" and any_of(c, "AL", "HL")):
+        return no_break                                         # LB23
+    if (p == "PR" and any_of(c, "ID", "EB", "EM")) or (any_of(p, "ID", "EB", "EM") and c == "PO"):
+        return no_break                                         # LB23a
+    if (any_of(p, "PR", "PO") and any_of(c, "AL", "HL")) or (any_of(p, "AL", "HL") and any_of(c, "PR", "PO")):
+        return no_break                                         # LB24
+    if (p, c) in (("CL", "PO"), ("CP", "PO"), ("CP_EA", "PO"), ("CL", "PR"), ("CP", "PR"),
+                  ("CP_EA", "PR"), ("NU", "PO"), ("NU", "PR"), ("PO", "OP"), ("PO", "OP_EA"),
+                  ("PO", "NU"), ("PR", "OP"), ("PR", "OP_EA"), ("PR", "NU"), ("HY", "NU"),
+                  ("IS", "NU"), ("NU", "NU"), ("SY", "NU")):
+        return no_break                                         # LB25
+    if (p == "JL" and any_of(c, "JL", "JV", "H2", "H3")) or (any_of(p, "JV", "H2") and any_of(c, "JV", "JT")) \
+            or (any_of(p, "JT", "H3") and c == "JT"):
+        return no_break                                         # LB26
+    if (any_of(p, "JL", "JV", "JT", "H2", "H3") and c == "PO") or (p == "PR" and any_of(c, "JL", "JV", "JT", "H2", "H3")):
+        return no_break                                         # LB27
+    if any_of(p, "AL", "HL") and any_of(c, "AL", "HL"):
+        return no_break                                         # LB28
+    if p == "IS" and any_of(c, "AL", "HL"):
+        return no_break                                         # LB29
+    if (any_of(p, "AL", "HL", "NU") and c == "OP") or (p == "CP" and any_of(c, "AL", "HL", "NU")):
+        return no_break                                         # LB30
+    if p == "RI" and c == "RI":
+        return LBR["RI"]                                        # LB30a
+    if p == "EB" and c == "EM":
+        return no_break                                         # LB30b
+    return fallback                                             # LB31
+
+
+def line_pair_rule(prev, cur):
+    """Outcome between prev and cur, possibly with spaces in between.
+
+    BREAK: break either way.
+    INDIRECT: no break if adjacent, break after spaces.
+    PROHIBITED: no break either way.
+    RI: INDIRECT when the RI run before cur is odd (LB30a), else BREAK.
+    HL_HY: INDIRECT when the class before prev is HL (LB21a), else BREAK.
+    """
+    p, c = LB_NAMES[prev], LB_NAMES[cur]
+    adjacent = line_decide(p, c, False)
+    if line_decide(p, c, True) == LBR["PROHIBITED"]:
+        assert adjacent == LBR["PROHIBITED"]
+        return LBR["PROHIBITED"]
+    if adjacent == LBR["PROHIBITED"]:
+        return LBR["INDIRECT"]
+    return adjacent
+
+
+def display_width(cp):
+    """Terminal columns of cp on its own: 0, 1 or 2."""
+    gc = unicodedata.category(chr(cp))
+    if gc in ("Mn", "Me", "Cf", "Cc", "Zl", "Zp") or cp == 0x200B:
+        return 0
+    # Hangul medial vowels and final consonants join the preceding syllable
+    if 0x1160 <= cp <= 0x11FF or 0xD7B0 <= cp <= 0xD7FF:
+        return 0
+    if unicodedata.east_asian_width(chr(cp)) in ("W", "F"):
+        return 2
+    return 1
+
+
+# ---------------------------------------------------------------------------
+# Normalization
+# ---------------------------------------------------------------------------
+
+NFC_QC_YES, NFC_QC_NO, NFC_QC_MAYBE = 0, 1, 2
+HANGUL_FIRST, HANGUL_LAST = 0xAC00, 0xD7A3
+
+
+def canonical_decomposition(cp):
+    """Codepoints of the canonical mapping of cp, or None."""
+    d = unicodedata.decomposition(chr(cp))
+    if not d or d.startswith("<"):
+        return None
+    return [int(x, 16) for x in d.split()]
+
+
+def primary_composites():
+    """{(first, second): composite} for the pairs NFC composes, Hangul
+    syllables excepted (those are composed algorithmically)."""
+    pairs = {}
+    for cp in range(MAX_CP):
+        d = canonical_decomposition(cp)
+        if d and len(d) == 2 and unicodedata.normalize("NFC", chr(cp)) == chr(cp):
+            pairs[(d[0], d[1])] = cp
+    return pairs
+
+
+def normalization_properties(pairs):
+    """Per codepoint: ccc | NFC_QC << 8 | NFD_QC=No << 10."""
+    seconds = {second for _, second in pairs}
+    seconds.update(range(0x1161, 0x1176))                  # Hangul V
+    seconds.update(range(0x11A8, 0x11C3))                  # Hangul T
+    values = []
+    for cp in range(MAX_CP):
+        c = chr(cp)
+        if unicodedata.normalize("NFC", c) != c:
+            nfc = NFC_QC_NO
+        elif cp in seconds:
+            nfc = NFC_QC_MAYBE
+        else:
+            nfc = NFC_QC_YES
+        nfd = unicodedata.normalize("NFD", c) != c
+        values.append(unicodedata.combining(c) | nfc << 8 | nfd << 10)
+    return values
+
+
+def full_decompositions():
+    """Sorted (cp, NFD of cp) for every codepoint NFD changes, Hangul
+    syllables excepted."""
+    result = []
+    for cp in range(MAX_CP):
+        if HANGUL_FIRST <= cp <= HANGUL_LAST:
+            continue
+        nfd = unicodedata.normalize("NFD", chr(cp))
+        if nfd != chr(cp):
+            result.append((cp, [ord(x) for x in nfd]))
+    return result
+
+
+# ---------------------------------------------------------------------------
+# Case folding
+# ---------------------------------------------------------------------------
+
+def load_case_folds(ucd):
+    """{cp: (full, simple)} for every codepoint that folds, each a list of
+    codepoints. Statuses C and F make the full folding, C and S the simple
+    one; the Turkic mappings (T) are left out."""
+    folds = {}
+    if ucd:
+        with open(os.path.join(ucd, "CaseFolding.txt"), encoding="utf-8") as f:
+            for line in f:
+                line = line.split("#", 1)[0].strip()
+                if not line:
+                    continue
+                cp, status, mapping = [x.strip() for x in line.split(";")[:3]]
+                full, simple = folds.setdefault(int(cp, 16), ([int(cp, 16)], [int(cp, 16)]))
+                mapping = [int(x, 16) for x in mapping.split()]
+                if status in ("C", "F"):
+                    full[:] = mapping
+                if status in ("C", "S"):
+                    simple[:] = mapping
+    else:
+        for cp, full, simple in perl_casefolds():
+            folds[cp] = ([int(x, 16) for x in full.split()],
+                         [int(x, 16) for x in simple.split()] if simple else [cp])
+    return folds
+
+
+def case_fold_kinds(folds):
+    """Per codepoint an index into the deduplicated fold kinds, 0 for
+    codepoints that fold to themselves, and the kinds: the simple folding
+    as a delta, and the full folding where it differs from the simple one."""
+    kinds = [(0, ())]
+    index = {kinds[0]: 0}
+    values = [0] * MAX_CP
+    for cp, (full, simple) in folds.items():
+        assert len(simple) == 1
+        kind = (simple[0] - cp, tuple(full) if full != simple else ())
+        if kind == kinds[0]:
+            continue
+        if kind not in index:
+            index[kind] = len(kinds)
+            kinds.append(kind)
+        values[cp] = index[kind]
+    return values, kinds
+
+
+# ---------------------------------------------------------------------------
+# Output
+# ---------------------------------------------------------------------------
+
+def build_two_stage(values, shift):
+    """Split values into a deduplicated stage1/stage2 pair."""
+    block_size = 1 << shift
+    blocks = {}
+    stage1 = []
+    stage2 = []
+    for start in range(0, len(values), block_size):
+        block = tuple(values[start:start + block_size])
+        if block not in blocks:
+            blocks[block] = len(stage2) >> shift
+            stage2.extend(block)
+        stage1.append(blocks[block])
+    return stage1, stage2
+
+
+def c_type(values):
+    top = max(values)
+    if top < 1 << 8:
+        return "uint8_t"
+    if top < 1 << 16:
+        return "uint16_t"
+    return "uint32_t"
+
+
+def emit_array(out, ctype, name, values, per_line=16):
+    out.write("static const %s %s[%d] = {\n" % (ctype, name, len(values)))
+    for i in range(0, len(values), per_line):
+        chunk = values[i:i + per_line]
+        out.write("    " + ", ".join(str(v) for v in chunk) + ",\n")
+    out.write("};\n\n")
+
+
+def emit_two_stage(out, prefix, values, shift):
+    stage1, stage2 = build_two_stage(values, shift)
+    out.write("#define %s_SHIFT %d\n" % (prefix.upper(), shift))
+    out.write("#define %s_MASK 0x%X\n\n" % (prefix.upper(), (1 << shift) - 1))
+    emit_array(out, c_type(stage1), prefix + "_stage1", stage1)
+    emit_array(out, c_type(stage2), prefix + "_stage2", stage2)
+    width = {"uint8_t": 1, "uint16_t": 2, "uint32_t": 4}
+    return len(stage1) * width[c_type(stage1)] + len(stage2) * width[c_type(stage2)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ucd", help="directory containing the UCD text files")
+    args = parser.parse_args()
+    if not args.ucd and unicodedata.unidata_version != BUILTIN_UNICODE_VERSION:
+        sys.exit("The built-in property lists are for Unicode %s, unicodedata "
+                 "implements %s; use --ucd"
+                 % (BUILTIN_UNICODE_VERSION, unicodedata.unidata_version))
+
+    out = sys.stdout
+    version = "from " + args.ucd if args.ucd else unicodedata.unidata_version
+
+    out.write("/* Generated by tools/gen_unicode_tables.py - do not edit.\n")
+    out.write(" * Unicode data: %s */\n\n" % version)
+    out.write("#ifndef STRITER_UNICODE_TABLES_H\n#define STRITER_UNICODE_TABLES_H\n\n")
+    out.write("#include <stdint.h>\n\n")
+
+    # Grapheme classes
+    out.write("// Grapheme_Cluster_Break classes (Extended_Pictographic folded in)\n")
+    out.write("typedef enum {\n")
+    for i, name in enumerate(GCB_CLASSES):
+        out.write("    STRITER_GCB_%s = %d,\n" % (name.upper(), i))
+    out.write("    STRITER_GCB_COUNT = %d\n} striter_gcb_t;\n\n" % len(GCB_CLASSES))
+
+    classes = load_grapheme_classes(args.ucd)
+    size = emit_two_stage(out, "striter_gcb", classes, 7)
+    out.write("// striter_gcb tables: %d bytes\n\n" % size)
+
+    # Pair rules
+    out.write("// GB rule outcome for each (previous, current) class pair\n")
+    out.write("#define STRITER_GB_BREAK 0\n#define STRITER_GB_NO_BREAK 1\n")
+    out.write("#define STRITER_GB_NO_BREAK_EMOJI 2\n#define STRITER_GB_NO_BREAK_RI 3\n\n")
+    n = len(GCB_CLASSES)
+    out.write("static const uint8_t striter_gcb_rules[%d][%d] = {\n" % (n, n))
+    for prev in range(n):
+        row = [grapheme_pair_rule(prev, cur) for cur in range(n)]
+        out.write("    { " + ", ".join(str(v) for v in row) + " }, // %s\n" % GCB_CLASSES[prev])
+    out.write("};\n\n")
+
+    # Word classes and pair rules
+    out.write("// Word_Break classes\n")
+    out.write("typedef enum {\n")
+    for i, name in enumerate(WB_NAMES):
+        out.write("    STRITER_WB_%s = %d,\n" % (name.upper(), i))
+    out.write("    STRITER_WB_COUNT = %d\n} striter_wb_t;\n\n" % len(WB_NAMES))
+
+    classes = load_break_classes(args.ucd, "Word_Break", "WordBreakProperty.txt", WB)
+    size = emit_two_stage(out, "striter_wb", classes, 7)
+    out.write("// striter_wb tables: %d bytes\n\n" % size)
+
+    out.write("// WB rule outcome for each (previous, current) class pair\n")
+    for i, name in enumerate(WB_RULE_NAMES):
+        out.write("#define STRITER_WBR_%s %d\n" % (name, i))
+    out.write("\n")
+    n = len(WB_NAMES)
+    out.write("static const uint8_t striter_wb_rules[%d][%d] = {\n" % (n, n))
+    for prev in range(n):
+        row = [word_pair_rule(prev, cur) for cur in range(n)]
+        out.write("    { " + ", ".join(str(v) for v in row) + " }, // %s\n" % WB_NAMES[prev])
+    out.write("};\n\n")
+
+    # Sentence classes
+    out.write("// Sentence_Break classes\n")
+    out.write("typedef enum {\n")
+    for i, name in enumerate(SB_NAMES):
+        out.write("    STRITER_SB_%s = %d,\n" % (name.upper(), i))
+    out.write("    STRITER_SB_COUNT = %d\n} striter_sb_t;\n\n" % len(SB_NAMES))
+
+    classes = load_break_classes(args.ucd, "Sentence_Break", "SentenceBreakProperty.txt", SB)
+    size = emit_two_stage(out, "striter_sb", classes, 7)
+    out.write("// striter_sb tables: %d bytes\n\n" % size)
+
+    # Line classes and pair rules
+    out.write("// Line_Break classes, resolved per LB1 (OP_EA/CP_EA: wide OP/CP, for LB30)\n")
+    out.write("typedef enum {\n")
+    for i, name in enumerate(LB_NAMES):
+        out.write("    STRITER_LB_%s = %d,\n" % (name.upper(), i))
+    out.write("    STRITER_LB_COUNT = %d\n} striter_lb_t;\n\n" % len(LB_NAMES))
+
+    classes = load_line_classes(args.ucd)
+    size = emit_two_stage(out, "striter_lb", classes, 7)
+    out.write("// striter_lb tables: %d bytes\n\n" % size)
+
+    out.write("// LB rule outcome for each (previous, current) class pair\n")
+    for i, name in enumerate(LB_RULE_NAMES):
+        out.write("#define STRITER_LBR_%s %d\n" % (name, i))
+    out.write("\n")
+    n = len(LB_NAMES)
+    out.write("static const uint8_t striter_lb_rules[%d][%d] = {\n" % (n, n))
+    for prev in range(n):
+        row = [line_pair_rule(prev, cur) for cur in range(n)]
+        out.write("    { " + ", ".join(str(v) for v in row) + " }, // %s\n" % LB_NAMES[prev])
+    out.write("};\n\n")
+
+    # Display width
+    out.write("// Display width in terminal columns (0, 1 or 2)\n")
+    size = emit_two_stage(out, "striter_width", [display_width(cp) for cp in range(MAX_CP)], 7)
+    out.write("// striter_width tables: %d bytes\n\n" % size)
+
+    # Normalization
+    pairs = primary_composites()
+    out.write("// Normalization properties: canonical combining class in the low\n")
+    out.write("// byte, NFC_QC above it, then whether NFD_QC is No\n")
+    out.write("#define STRITER_NFC_QC_YES %d\n#define STRITER_NFC_QC_NO %d\n#define STRITER_NFC_QC_MAYBE %d\n"
+              % (NFC_QC_YES, NFC_QC_NO, NFC_QC_MAYBE))
+    out.write("#define STRITER_NORM_CCC(v) ((v) & 0xFF)\n")
+    out.write("#define STRITER_NORM_NFC_QC(v) (((v) >> 8) & 3)\n")
+    out.write("#define STRITER_NORM_NFD_NO(v) (((v) >> 10) & 1)\n\n")
+    size = emit_two_stage(out, "striter_norm", normalization_properties(pairs), 7)
+    out.write("// striter_norm tables: %d bytes\n\n" % size)
+
+    decomps = full_decompositions()
+    data = []
+    offsets = []
+    for _, nfd in decomps:
+        offsets.append(len(data))
+        data.extend(nfd)
+    offsets.append(len(data))
+    out.write("// Full canonical decompositions (NFD) of the codepoints in\n")
+    out.write("// striter_decomp_cps: data[offsets[i]] to data[offsets[i + 1]]\n")
+    out.write("#define STRITER_DECOMP_COUNT %d\n" % len(decomps))
+    out.write("#define STRITER_DECOMP_MAX %d\n\n" % max(len(nfd) for _, nfd in decomps))
+    emit_array(out, c_type([cp for cp, _ in decomps]), "striter_decomp_cps", [cp for cp, _ in decomps])
+    emit_array(out, c_type(offsets), "striter_decomp_offsets", offsets)
+    emit_array(out, c_type(data), "striter_decomp_data", data)
+
+    keys = sorted(pairs)
+    out.write("// Primary composites: (first << 21 | second) in ascending order, and\n")
+    out.write("// the composite of each pair\n")
+    out.write("#define STRITER_COMP_COUNT %d\n\n" % len(keys))
+    emit_array(out, "uint64_t", "striter_comp_pairs", ["%dULL" % (a << 21 | b) for a, b in keys], per_line=6)
+    emit_array(out, c_type([pairs[k] for k in keys]), "striter_comp_results", [pairs[k] for k in keys])
+
+    # Case folding
+    values, kinds = case_fold_kinds(load_case_folds(args.ucd))
+    out.write("// Case folding: the fold kind of each codepoint, 0 if it folds to\n")
+    out.write("// itself. A kind is a simple folding, added to the codepoint, and a\n")
+    out.write("// full folding data[offsets[k]] to data[offsets[k + 1]] if it differs\n")
+    out.write("#define STRITER_FOLD_KINDS %d\n" % len(kinds))
+    out.write("#define STRITER_FOLD_MAX %d\n\n" % max(len(full) for _, full in kinds))
+    size = emit_two_stage(out, "striter_fold", values, 7)
+    out.write("// striter_fold tables: %d bytes\n\n" % size)
+    data = []
+    offsets = []
+    for _, full in kinds:
+        offsets.append(len(data))
+        data.extend(full)
+    offsets.append(len(data))
+    emit_array(out, "int32_t", "striter_fold_deltas", [delta for delta, _ in kinds])
+    emit_array(out, c_type(offsets), "striter_fold_offsets", offsets)
+    emit_array(out, c_type(data), "striter_fold_data", data)
+
+    out.write("#endif /* STRITER_UNICODE_TABLES_H */\n")
+
+
+if __name__ == "__main__":
+    main()